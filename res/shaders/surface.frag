@@ -0,0 +1,52 @@
+#version 330 core
+
+out vec4 color;
+
+in vec3 vDir;
+in vec4 vColor;
+
+// see snzr_virtualTextureBind
+uniform sampler2D uVtIndirection;
+uniform sampler2D uVtCache;
+uniform vec4 uVtInfo;
+uniform vec4 uVtPageInfo;
+
+// alpha is 0 when nothing is resident yet
+vec4 vtSample(vec2 uv, vec2 dx, vec2 dy) {
+    vec2 texels = uVtInfo.xy * uVtInfo.w;
+    float lod = 0.5 * log2(max(dot(dx * texels, dx * texels), dot(dy * texels, dy * texels)));
+    lod = clamp(floor(lod), 0.0, uVtInfo.z - 1.0);
+    uv = clamp(uv, vec2(0.0), vec2(0.99999));
+
+    // page x, page y, level of whichever resident tile covers uv, the best one at or above lod
+    vec4 entry = textureLod(uVtIndirection, uv, lod);
+    if (entry.a == 0.0) {
+        return vec4(0.0);
+    }
+    vec3 e = floor(entry.xyz * 255.0 + 0.5);
+    vec2 tiles = max(floor(uVtInfo.xy / exp2(e.z)), vec2(1.0));
+    vec2 inTile = fract(uv * tiles);
+
+    vec2 texel = e.xy * uVtPageInfo.y + uVtPageInfo.x + inTile * uVtInfo.w;
+    return textureLod(uVtCache, texel / uVtPageInfo.z, 0.0);
+}
+
+void main()
+{
+    vec3 d = normalize(vDir);
+    vec2 uv = vec2(0.5 + atan(d.z, d.x) / 6.28318530718, acos(clamp(d.y, -1.0, 1.0)) / 3.14159265359);
+
+    // u wraps from 1 to 0 at the back, so take derivatives of a copy wrapped halfway around too and keep the smaller ones
+    vec2 dx = dFdx(uv);
+    vec2 dy = dFdy(uv);
+    float u2 = fract(uv.x + 0.5);
+    float dx2 = dFdx(u2);
+    float dy2 = dFdy(u2);
+    if (abs(dx2) + abs(dy2) < abs(dx.x) + abs(dy.x)) {
+        dx.x = dx2;
+        dy.x = dy2;
+    }
+
+    vec4 surface = vtSample(uv, dx, dy);
+    color = surface.a == 0.0 ? vColor : surface;
+}
@@ -144,7 +144,8 @@ struct gm_Celestial {
     float surfaceRadius;
     float orbitStartOffset; // in rads, represents initial angle along orbit at t = 0
     HMM_Vec4 color;
-    snzr_Texture texture;
+    const snzr_TextureRegion* texture;  // async loaded, placeholder until resident
+    snzr_VirtualTexture* surface;  // for the zoomed in sphere, null when there's no map. See gm_celestialSurfaceLoad
 
     // updated vars
     HMM_Vec2 currentPosition;
@@ -160,7 +161,7 @@ gm_Celestial* gm_celestialInit(snz_Arena* arena, const char* name, const char* t
     c->orbitStartOffset = orbitStartOffset;
     c->surfaceRadius = surfaceRadius;
     c->color = color;
-    c->texture = ui_texFromFile(texturePath);
+    c->texture = ui_texFromFileAsync(texturePath);
 
     c->parent = parent;
     if (c->parent) {
@@ -173,6 +174,101 @@ gm_Celestial* gm_celestialInit(snz_Arena* arena, const char* name, const char* t
     return c;
 }
 
+// surface maps get big (16k equirectangular), so they're virtual textures and only what's on screen gets loaded
+void gm_celestialSurfaceLoad(gm_Celestial* c, const char* path, int64_t cachePagesPerSide, snz_Arena* arena, snz_Arena* scratch) {
+    c->surface = SNZ_ARENA_PUSH(arena, snzr_VirtualTexture);
+    *c->surface = ui_virtualTextureFromFile(path, cachePagesPerSide, arena, scratch);
+}
+
+void gm_celestialSurfaceUnload(gm_Celestial* c) {
+    if (c->surface) {
+        snzr_virtualTextureDeinit(c->surface);
+        c->surface = NULL;
+    }
+}
+
+#define _GM_SURFACE_TILE_SAMPLES 5  // per side of a tile, to find how much of the screen it covers
+
+// point on the unit sphere for an equirectangular uv, matches surface.frag
+static HMM_Vec3 _gm_surfaceDirFromUV(float u, float v) {
+    float lon = (u - 0.5f) * 2 * HMM_PI32;
+    float polar = v * HMM_PI32;
+    return HMM_V3(sinf(polar) * cosf(lon), cosf(polar), sinf(polar) * sinf(lon));
+}
+
+// size in target pixels of the biggest side of the part of the tile facing toCamera, -1 if none of it does
+static float _gm_surfaceTileCoverage(const snzr_VirtualTexture* vt, int64_t level, int64_t x, int64_t y, HMM_Mat4 mvp, HMM_Vec3 toCamera, HMM_Vec2 targetSize) {
+    HMM_Vec2 min = HMM_V2(INFINITY, INFINITY);
+    HMM_Vec2 max = HMM_V2(-INFINITY, -INFINITY);
+    bool visible = false;
+    for (int sy = 0; sy < _GM_SURFACE_TILE_SAMPLES; sy++) {
+        for (int sx = 0; sx < _GM_SURFACE_TILE_SAMPLES; sx++) {
+            float u = (x + sx / (_GM_SURFACE_TILE_SAMPLES - 1.0f)) / vt->levelTilesX[level];
+            float v = (y + sy / (_GM_SURFACE_TILE_SAMPLES - 1.0f)) / vt->levelTilesY[level];
+            HMM_Vec3 dir = _gm_surfaceDirFromUV(u, v);
+            if (HMM_Dot(dir, toCamera) <= 0) {
+                continue;
+            }
+            visible = true;
+            HMM_Vec4 clip = HMM_Mul(mvp, HMM_V4(dir.X, dir.Y, dir.Z, 1));
+            HMM_Vec2 pt = HMM_V2((clip.X / clip.W * 0.5f + 0.5f) * targetSize.X, (clip.Y / clip.W * 0.5f + 0.5f) * targetSize.Y);
+            min = HMM_V2(SNZ_MIN(min.X, pt.X), SNZ_MIN(min.Y, pt.Y));
+            max = HMM_V2(SNZ_MAX(max.X, pt.X), SNZ_MAX(max.Y, pt.Y));
+        }
+    }
+    if (!visible) {
+        return -1;
+    }
+    return SNZ_MAX(max.X - min.X, max.Y - min.Y);
+}
+
+typedef struct {
+    int64_t level;
+    int64_t x;
+    int64_t y;
+} _gm_SurfaceTile;
+
+// requests the tiles of the surface that a unit sphere drawn with vp and model (rotation and uniform scale only)
+// shows, at about a texel per pixel. toCamera is in the spheres space, and the camera is assumed orthographic.
+// Walks the tile quadtree breadth first from the single coarsest tile, so coarse tiles get asked for first and
+// the walk stops refining once it has asked for about as many tiles as the cache holds.
+void gm_surfaceRequestTiles(snzr_VirtualTexture* vt, HMM_Mat4 vp, HMM_Mat4 model, HMM_Vec3 toCamera, HMM_Vec2 targetSize, snz_Arena* scratch) {
+    HMM_Mat4 mvp = HMM_Mul(vp, model);
+    int64_t budget = vt->pagesPerSide * vt->pagesPerSide * 3 / 4;  // leaves room to stream in while old pages are in use
+
+    _gm_SurfaceTile* queue = SNZ_ARENA_PUSH_ARR(scratch, budget, _gm_SurfaceTile);
+    int64_t queueStart = 0;
+    int64_t queueEnd = 0;
+    queue[queueEnd++] = (_gm_SurfaceTile){ .level = vt->levelCount - 1 };
+    while (queueStart < queueEnd) {
+        _gm_SurfaceTile t = queue[queueStart++];
+        snzr_virtualTextureRequest(vt, t.level, t.x, t.y);
+        if (t.level == 0 || queueEnd >= budget) {
+            continue;
+        }
+        float coverage = _gm_surfaceTileCoverage(vt, t.level, t.x, t.y, mvp, toCamera, targetSize);
+        if (coverage <= vt->tileSize) {
+            continue;  // already a texel or more per pixel
+        }
+
+        // child tiles are 2x2, or 2x1 where a level is a single tile wide or tall
+        int64_t childLevel = t.level - 1;
+        int64_t fx = vt->levelTilesX[childLevel] / vt->levelTilesX[t.level];
+        int64_t fy = vt->levelTilesY[childLevel] / vt->levelTilesY[t.level];
+        for (int64_t cy = t.y * fy; cy < (t.y + 1) * fy; cy++) {
+            for (int64_t cx = t.x * fx; cx < (t.x + 1) * fx; cx++) {
+                if (queueEnd >= budget) {
+                    break;
+                }
+                if (_gm_surfaceTileCoverage(vt, childLevel, cx, cy, mvp, toCamera, targetSize) < 0) {
+                    continue;
+                }
+                queue[queueEnd++] = (_gm_SurfaceTile){ .level = childLevel, .x = cx, .y = cy };
+            }
+        }
+    }
+}
+
 // expects parent to be updated, updates children, body should be non-null
 // if no parent, body position updated to 0, 0
 void gm_celestialUpdate(gm_Celestial* body, float time) {
@@ -189,26 +285,39 @@ void gm_celestialUpdate(gm_Celestial* body, float time) {
     }
 }
 
-void gm_orbitLineDraw(float zoomAnim, HMM_Vec2 fadeOrigin, HMM_Vec2 origin, float radius, HMM_Mat4 vp, snz_Arena* scratch) {
-    HMM_Vec4Slice points = SNZ_ARENA_PUSH_SLICE(scratch, 256, HMM_Vec4);
-    for (int i = 0; i < points.count; i++) {
-        float angle = i * (2 * HMM_PI / (points.count - 1));  // minus one to close the loop
-        HMM_Vec2 pos = HMM_RotateV2(HMM_V2(radius, 0), angle);
-        pos = HMM_Add(pos, origin);
-        points.elems[i] = HMM_V4(pos.X, pos.Y, 0, 1);
-    }
+// pixelScale is target pixels per screen pixel, so that lines keep their width in targets that get upscaled
+void gm_orbitLineDraw(float zoomAnim, HMM_Vec2 fadeOrigin, HMM_Vec2 origin, float radius, HMM_Mat4 vp, float pixelScale) {
     HMM_Vec4 color = ui_colorOrbit;
     color.A *= 1 - zoomAnim;
-    snzr_drawLineFaded(
-        points.elems, points.count,
-        color, ui_thicknessOrbit,
+    snzr_drawRingFaded(
+        HMM_V3(origin.X, origin.Y, 0), radius,
+        color, ui_thicknessOrbit * pixelScale,
         vp,
         HMM_V3(fadeOrigin.X, fadeOrigin.Y, 0), 0, radius * 1.8);
 }
 
 // expects GL ctx to be on a framebuffer
-// expects a valid snzu_Instance also
-void gm_celestialsBuild(gm_CelestialSlice celestials, _snzu_Box* parentBox, HMM_Mat4 vp, gm_Celestial** outTargetCelestial, float zoomAnim, snz_Arena* scratch) {
+// pixelScale is for the framebuffer, see gm_orbitLineDraw
+void gm_orbitsDraw(gm_CelestialSlice celestials, HMM_Mat4 vp, float zoomAnim, float pixelScale, snz_Arena* scratch) {
+    if (zoomAnim > 0.99999) {
+        return;
+    }
+
+    snzr_CmdList orbits = { 0 }; // recorded so that every orbit goes out in one draw
+    snzr_cmdListBegin(&orbits, scratch);
+    for (int i = 0; i < celestials.count; i++) {
+        gm_Celestial* c = &celestials.elems[i];
+        for (gm_Celestial* child = c->firstChild; child; child = child->nextSibling) {
+            gm_orbitLineDraw(zoomAnim, child->currentPosition, c->currentPosition, child->orbitRadius, vp, pixelScale);
+        }
+    }
+    snzr_cmdListEnd();
+    snzr_cmdListSubmit(&orbits);
+}
+
+// expects a valid snzu_Instance
+// planets are boxes, so they're always at screen resolution and get built every frame, even when the orbits aren't drawn
+void gm_celestialsBuild(gm_CelestialSlice celestials, _snzu_Box* parentBox, HMM_Mat4 vp, gm_Celestial** outTargetCelestial, float zoomAnim) {
     // we are zoomed in, stop rendering
     // not just for perf but also so that planets don't block ui events while not being visible
     if (zoomAnim > 0.99999) {
@@ -227,7 +336,7 @@ void gm_celestialsBuild(gm_CelestialSlice celestials, _snzu_Box* parentBox, HMM_
     for (int i = 0; i < celestials.count; i++) {
         gm_Celestial* c = &celestials.elems[i];
         snzu_boxNewF("%d planet in scene", i);
-        snzu_boxSetTexture(c->texture);
+        snzu_boxSetTextureRegion(*c->texture);
 
         HMM_Vec4 color = c->color;
         color.A *= 1 - zoomAnim;
@@ -253,9 +362,5 @@ void gm_celestialsBuild(gm_CelestialSlice celestials, _snzu_Box* parentBox, HMM_
             pt = HMM_Mul(transform, position4);
             snzu_boxSetEnd(pt.XY);
         }
-
-        for (gm_Celestial* child = c->firstChild; child; child = child->nextSibling) {
-            gm_orbitLineDraw(zoomAnim, child->currentPosition, c->currentPosition, child->orbitRadius, vp, scratch);
-        }
     }
 }
@@ -2,20 +2,45 @@
 #include "ui.h"
 #include "ser.h"
 #include "game.h"
+#include <ctype.h>
 #include <stdio.h>
 
 snzu_Instance main_uiInstance = { 0 };
 snz_Arena main_fontArena = { 0 };
 snz_Arena main_lifetimeArena = { 0 };
 
-snzr_FrameBuffer main_sceneFrameBuffer = { 0 };
+snzr_FrameBufferPool main_sceneTargets = { 0 };
+snzr_AntiAliasing main_sceneAA = SNZR_AA_MSAA; // the pool gets rebuilt at the end of the frame when this changes
+#define MAIN_SCENE_MSAA_SAMPLES 4
+snzr_DynamicResolution main_sceneResolution = { 0 };
+bool main_dynamicResolution = true; // scene renders smaller and gets upscaled when it's over budget
+#define MAIN_SCENE_GPU_BUDGET_MS 4
+#define MAIN_SCENE_MIN_SCALE 0.5
+float main_sceneHz = 0; // the scene redraws at most this often, 0 for every frame. The ui always runs at full rate.
+#define MAIN_SCENE_REDUCED_HZ 30
+
+// the last scene drawn, shown again instead of redrawing while nothing that goes into it changes
+typedef struct {
+    snzr_FrameBufferRegion region; // retained in main_sceneTargets, zeroed when there isn't one
+    uint64_t hash; // of the camera, sim time, target, etc. it was drawn with
+    float age; // seconds since it was drawn
+    uint64_t drawnCount;
+    uint64_t reusedCount;
+} main_SceneCache;
+main_SceneCache main_sceneCache = { 0 };
 
 gm_CelestialSlice main_celestials = { 0 };
 gm_Celestial* main_rootCelestial = NULL;
 gm_Celestial* main_targetCelestial = NULL;
 bool main_targetCelestialZoomed = false;
+bool main_paused = false; // sim time stops, the camera & ui keep going
+bool main_showRenderStats = false;
+bool main_capturing = false; // every presented frame gets written into MAIN_CAPTURE_DIR
+#define MAIN_CAPTURE_DIR "captures"
 
 ren3d_Mesh main_sphereMesh = { 0 };
+#define MAIN_SURFACE_DIR "res/surfaces" // <lowercase celestial name>.png, equirectangular, optional
+#define MAIN_SURFACE_CACHE_PAGES 16 // per side, 128px tiles
 
 void main_init(snz_Arena* scratch, SDL_Window* window) {
     SNZ_ASSERT(window || !window, "???");
@@ -29,6 +54,7 @@ void main_init(snz_Arena* scratch, SDL_Window* window) {
     ui_init(&main_fontArena, scratch, scratch);
     ren3d_init(scratch);
 
+    const char* prevOwner = snzr_resourceOwnerSet("game");
     SNZ_ARENA_ARR_BEGIN(&main_lifetimeArena, gm_Celestial);
     // name, parent, orbit radius, orbit time, orbit offset, size, color
     gm_Celestial* sol = gm_celestialInit(&main_lifetimeArena, "SOL", "res/textures/sol.png", NULL, 0, 0, 0, 1, ui_colorText);
@@ -40,16 +66,80 @@ void main_init(snz_Arena* scratch, SDL_Window* window) {
     main_celestials = SNZ_ARENA_ARR_END(&main_lifetimeArena, gm_Celestial);
 
     main_sphereMesh = gm_sphereMeshInit(scratch, 5);
+    for (int i = 0; i < main_celestials.count; i++) {
+        gm_Celestial* c = &main_celestials.elems[i];
+        char* path = snz_arenaFormatStr(scratch, "%s/%s.png", MAIN_SURFACE_DIR, c->name);
+        for (char* ch = path + strlen(MAIN_SURFACE_DIR); *ch; ch++) {
+            *ch = (char)tolower((unsigned char)*ch);
+        }
+        FILE* f = fopen(path, "rb");
+        if (f) {
+            fclose(f);
+            gm_celestialSurfaceLoad(c, path, MAIN_SURFACE_CACHE_PAGES, &main_lifetimeArena, scratch);
+        }
+    }
+    snzr_resourceOwnerSet("scene");
+    main_sceneTargets = snzr_frameBufferPoolInit(120, main_sceneAA, MAIN_SCENE_MSAA_SAMPLES);
+    snzr_resourceOwnerSet(prevOwner);
+    main_sceneResolution = snzr_dynamicResolutionInit("scene", MAIN_SCENE_GPU_BUDGET_MS, MAIN_SCENE_MIN_SCALE, 1);
+}
+
+void main_deinit() {
+    for (int i = 0; i < main_celestials.count; i++) {
+        gm_celestialSurfaceUnload(&main_celestials.elems[i]);
+    }
+    snzr_frameBufferPoolDeinit(&main_sceneTargets);
+    ren3d_meshDeinit(&main_sphereMesh);
+    ren3d_deinit();
+    ui_deinit();
+}
+
+typedef struct {
+    HMM_Mat4 vp;
+    float zoomAnim;
+    float pixelScale;
+    snz_Arena* frameArena;
+} main_OrbitPass;
+
+static void main_orbitPassDraw(const snzr_PassGraph* graph, void* userData) {
+    (void)graph;
+    main_OrbitPass* pass = userData;
+    gm_orbitsDraw(main_celestials, pass->vp, pass->zoomAnim, pass->pixelScale, pass->frameArena);
+}
+
+typedef struct {
+    HMM_Mat4 vp;
+    HMM_Mat4 model;
+    snzr_VirtualTexture* surface; // may be null
+} main_SpherePass;
+
+// userData is the snzr_PassTarget to upscale, it's the pass's only input
+static void main_upscalePassDraw(const snzr_PassGraph* graph, void* userData) {
+    snzr_drawUpscaled(snzr_passGraphTargetRegion(graph, *(snzr_PassTarget*)userData));
+}
+
+static void main_spherePassDraw(const snzr_PassGraph* graph, void* userData) {
+    (void)graph;
+    main_SpherePass* pass = userData;
+    if (pass->surface) {
+        ren3d_drawSphereSurface(&main_sphereMesh, pass->surface, pass->vp, pass->model);
+    } else {
+        ren3d_drawMesh(&main_sphereMesh, pass->vp, pass->model);
+    }
 }
 
 void main_loop(float dt, snz_Arena* frameArena, snzu_Input og_frameInputs, HMM_Vec2 og_screenSize) {
     snzu_frameStart(frameArena, og_screenSize, dt);
+    const gm_Celestial* prevTarget = main_targetCelestial;
+    float sceneScale = 1; // what the scene is drawn at this frame, only below 1 with F6 on
 
     snzu_boxNew("parent");
     float time = 0;
     { // game update
         float* const _time = SNZU_USE_MEM(float, "time");
-        *_time += dt;
+        if (!main_paused) {
+            *_time += dt;
+        }
         time = *_time;
         gm_celestialUpdate(main_rootCelestial, time);
     }
@@ -59,21 +149,31 @@ void main_loop(float dt, snz_Arena* frameArena, snzu_Input og_frameInputs, HMM_V
         float leftBarWidth = 100;
 
         _snzu_Box* sceneBox = snzu_boxNew("main scene");
+        snzr_PassGraph* sceneGraph = SNZ_ARENA_PUSH(frameArena, snzr_PassGraph);
+        snzr_passGraphInit(sceneGraph, &main_sceneTargets);
+        snzr_PassTarget sceneTarget = 0;
+        snzr_PassTarget* drawTarget = SNZ_ARENA_PUSH(frameArena, snzr_PassTarget); // what scene passes draw into
+        uint32_t sceneWidth = 0;
+        uint32_t sceneHeight = 0;
         snzu_boxFillParent();
         snzu_boxSetSizeFromEndAx(SNZU_AX_X, og_screenSize.X - leftBarWidth); // FIXME: size remaining fn
         snzu_Interaction* inter = SNZU_USE_MEM(snzu_Interaction, "inter");
         snzu_boxSetInteractionOutput(inter, SNZU_IF_HOVER | SNZU_IF_MOUSE_BUTTONS | SNZU_IF_MOUSE_SCROLL);
         {
             HMM_Vec2 size = snzu_boxGetSize();
-            if (main_sceneFrameBuffer.texture.width != size.X ||
-                main_sceneFrameBuffer.texture.height != size.Y) {
-                snzr_frameBufferDeinit(&main_sceneFrameBuffer);
+            sceneWidth = SNZ_MAX((uint32_t)size.X, 1);
+            sceneHeight = SNZ_MAX((uint32_t)size.Y, 1);
+            sceneTarget = snzr_passGraphTarget(sceneGraph, "scene", sceneWidth, sceneHeight);
+            snzr_passGraphKeep(sceneGraph, sceneTarget); // the box shows it
+            *drawTarget = sceneTarget;
+            if (main_dynamicResolution) {
+                sceneScale = snzr_dynamicResolutionUpdate(&main_sceneResolution);
             }
-            if (!main_sceneFrameBuffer.glId) {
-                snzr_Texture t = snzr_textureInitRBGA(size.X, size.Y, NULL);
-                main_sceneFrameBuffer = snzr_frameBufferInit(t);
+            if (sceneScale < 1) {
+                uint32_t w = SNZ_MAX((uint32_t)(sceneWidth * sceneScale), 1);
+                uint32_t h = SNZ_MAX((uint32_t)(sceneHeight * sceneScale), 1);
+                *drawTarget = snzr_passGraphTarget(sceneGraph, "scene scaled", w, h);
             }
-            snzu_boxSetTexture(main_sceneFrameBuffer.texture);
 
             if (snzu_isNothingFocused()) {
                 char inputChar = inter->keyChars[0];
@@ -97,6 +197,32 @@ void main_loop(float dt, snz_Arena* frameArena, snzu_Input og_frameInputs, HMM_V
                         }
                     } else if (inter->keyCode == SDLK_SPACE) {
                         main_targetCelestialZoomed = !main_targetCelestialZoomed;
+                    } else if (inter->keyCode == SDLK_F1) {
+                        main_showRenderStats = !main_showRenderStats;
+                    } else if (inter->keyCode == SDLK_F2) {
+                        snzr_gpuProfilerDumpCSV("gpu_profile.csv");
+                        ui_debugLogF("gpu zones written to gpu_profile.csv");
+                    } else if (inter->keyCode == SDLK_F3) {
+                        snz_PacingMode next = (snz_pacingStatsGet().requestedMode + 1) % (SNZ_PACING_FIXED + 1); // not the applied one, which can fall back
+                        snz_pacingSetMode(next, 144);
+                        const char* pacingNames[] = { "vsync", "adaptive vsync", "fixed 144fps" };
+                        ui_debugLogF("pacing set to %s", pacingNames[next]);
+                    } else if (inter->keyCode == SDLK_F4) {
+                        main_sceneAA = (main_sceneAA + 1) % SNZR_AA_COUNT;
+                        const char* aaNames[SNZR_AA_COUNT] = { "none", "msaa", "fxaa" };
+                        ui_debugLogF("scene aa set to %s", aaNames[main_sceneAA]);
+                    } else if (inter->keyCode == SDLK_F5) {
+                        main_capturing = !main_capturing;
+                        ui_debugLogF("capturing %s", main_capturing ? "on" : "off");
+                    } else if (inter->keyCode == SDLK_F6) {
+                        main_dynamicResolution = !main_dynamicResolution;
+                        ui_debugLogF("dynamic resolution %s", main_dynamicResolution ? "on" : "off");
+                    } else if (inter->keyCode == SDLK_F7) {
+                        main_sceneHz = main_sceneHz > 0 ? 0 : MAIN_SCENE_REDUCED_HZ;
+                        ui_debugLogF("scene rate %s", main_sceneHz > 0 ? "reduced" : "full");
+                    } else if (inter->keyCode == SDLK_p) {
+                        main_paused = !main_paused;
+                        ui_debugLogF("%s", main_paused ? "paused" : "unpaused");
                     }
                 } // end keydown checks
             } // end other focused check
@@ -127,27 +253,32 @@ void main_loop(float dt, snz_Arena* frameArena, snzu_Input og_frameInputs, HMM_V
                 *cameraHeight = HMM_Lerp(*cameraHeight, *zoomAnim, main_targetCelestial->surfaceRadius * 2 * 1.5);
             }
 
-            HMM_Vec2 fbSize = HMM_V2(main_sceneFrameBuffer.texture.width, main_sceneFrameBuffer.texture.height);
-            float aspect = fbSize.X / fbSize.Y;
+            float aspect = (float)sceneWidth / sceneHeight;
 
+            main_OrbitPass* orbits = SNZ_ARENA_PUSH(frameArena, main_OrbitPass);
             {
                 float halfHeight = *cameraHeight / 2;
                 HMM_Mat4 proj = HMM_Orthographic_RH_NO(-aspect * halfHeight, aspect * halfHeight, -halfHeight, halfHeight, 0, 100000);
                 HMM_Mat4 cameraView = HMM_Translate(HMM_V3(-cameraPosition->X, -cameraPosition->Y, 0));
 
-                snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, main_sceneFrameBuffer.glId));
-                snzr_callGLFnOrError(glViewport(0, 0, fbSize.X, fbSize.Y));
-                snzr_callGLFnOrError(glClearColor(ui_colorBackground.X, ui_colorBackground.Y, ui_colorBackground.Z, ui_colorBackground.W));
-                snzr_callGLFnOrError(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
-                glDepthMask(GL_FALSE); // so that orbit lines aren't drawn over planet render
-                gm_celestialsBuild(main_celestials, sceneBox, HMM_Mul(proj, cameraView), &main_targetCelestial, *zoomAnim, frameArena);
-                glDepthMask(GL_TRUE);
-                if (main_targetCelestial == main_rootCelestial) {
-                    main_targetCelestial = NULL;
-                    main_targetCelestialZoomed = false;
-                }
+                *orbits = (main_OrbitPass){
+                    .vp = HMM_Mul(proj, cameraView),
+                    .zoomAnim = *zoomAnim,
+                    .pixelScale = sceneScale,
+                    .frameArena = frameArena,
+                };
+                snzr_passGraphAdd(sceneGraph, (snzr_PassDesc){
+                                                  .name = "orbit lines",
+                                                  .func = main_orbitPassDraw,
+                                                  .userData = orbits,
+                                                  .output = *drawTarget,
+                                                  .clear = true,
+                                                  .clearColor = ui_colorBackground,
+                                                  .noDepthWrite = true, // so that orbit lines aren't drawn over planet render
+                                              });
             }
 
+            main_SpherePass* sphere = NULL;
             if (main_targetCelestialZoomed) {
                 HMM_Vec2* const prev = SNZU_USE_MEM(HMM_Vec2, "prevMouse");// FIXME: build in a moue delta for drag into snooze
                 HMM_Vec2 delta = { 0 };
@@ -176,11 +307,92 @@ void main_loop(float dt, snz_Arena* frameArena, snzu_Input og_frameInputs, HMM_V
                 cameraPosition = HMM_RotateV3AxisAngle_RH(cameraPosition, HMM_V3(0, 1, 0), cameraViewAngles->Y);
                 HMM_Mat4 view = HMM_LookAt_RH(cameraPosition, HMM_V3(0, 0, 0), HMM_V3(0, 1, 0));
 
-                HMM_Mat4 model = HMM_Scale(HMM_V3(radius, radius, radius));
-                ren3d_drawMesh(&main_sphereMesh, HMM_Mul(proj, view), model);
+                sphere = SNZ_ARENA_PUSH(frameArena, main_SpherePass);
+                *sphere = (main_SpherePass){
+                    .vp = HMM_Mul(proj, view),
+                    .model = HMM_Scale(HMM_V3(radius, radius, radius)),
+                    .surface = main_targetCelestial->surface,
+                };
+                if (sphere->surface) {
+                    HMM_Vec2 targetSize = HMM_V2(sceneWidth * sceneScale, sceneHeight * sceneScale);
+                    gm_surfaceRequestTiles(sphere->surface, sphere->vp, sphere->model, HMM_Norm(cameraPosition), targetSize, frameArena);
+                    snzr_virtualTextureUpdate(sphere->surface);
+                }
+                snzr_passGraphAdd(sceneGraph, (snzr_PassDesc){
+                                                  .name = "zoomed sphere",
+                                                  .func = main_spherePassDraw,
+                                                  .userData = sphere,
+                                                  .output = *drawTarget,
+                                              });
+            }
+
+            if (*drawTarget != sceneTarget) {
+                snzr_passGraphAdd(sceneGraph, (snzr_PassDesc){
+                                                  .name = "scene upscale",
+                                                  .func = main_upscalePassDraw,
+                                                  .userData = drawTarget,
+                                                  .output = sceneTarget,
+                                                  .inputs = { *drawTarget },
+                                                  .inputCount = 1,
+                                              });
             }
-            snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, 0));
-            snzr_callGLFnOrError(glViewport(0, 0, og_screenSize.X, og_screenSize.Y)); // FIXME: AHHHHHHHHHHH HAVE FRAME DRAW SET VIEPORT WHY DIDN"T U DO THAT BEFORE
+
+            gm_celestialsBuild(main_celestials, sceneBox, orbits->vp, &main_targetCelestial, *zoomAnim);
+
+            { // only draw the scene when something that goes into it changed, otherwise the last one gets shown again
+                uint64_t hash = SNZ_HASH_SEED;
+                hash = snz_hashBytes(hash, &time, sizeof(time));
+                hash = snz_hashBytes(hash, &main_targetCelestial, sizeof(main_targetCelestial));
+                hash = snz_hashBytes(hash, &orbits->vp, sizeof(orbits->vp));
+                hash = snz_hashBytes(hash, &orbits->zoomAnim, sizeof(orbits->zoomAnim));
+                hash = snz_hashBytes(hash, &sceneScale, sizeof(sceneScale));
+                if (sphere) {
+                    hash = snz_hashBytes(hash, &sphere->vp, sizeof(sphere->vp));
+                    hash = snz_hashBytes(hash, &sphere->model, sizeof(sphere->model));
+                    if (sphere->surface) {
+                        snzr_VirtualTextureStats stats = sphere->surface->stats;
+                        hash = snz_hashBytes(hash, &stats.uploaded, sizeof(stats.uploaded));
+                        if (stats.loading > 0) {
+                            snz_requestRedraw(); // to pick the tiles up when they land
+                        }
+                    }
+                }
+
+                main_SceneCache* cache = &main_sceneCache;
+                cache->age += dt;
+                bool changed = hash != cache->hash;
+                bool resized = cache->region.width != sceneWidth || cache->region.height != sceneHeight;
+                bool throttled = main_sceneHz > 0 && cache->age < 1 / main_sceneHz;
+                if (cache->region.frameBuffer.glId == 0 || resized || (changed && !throttled)) {
+                    if (cache->region.frameBuffer.glId != 0) {
+                        snzr_frameBufferPoolRelease(&main_sceneTargets, cache->region); // the graph can draw into it again
+                    }
+                    snzr_gpuZone("scene") {
+                        snzr_passGraphExecute(sceneGraph);
+                    }
+                    cache->region = snzr_passGraphTargetRegion(sceneGraph, sceneTarget);
+                    snzr_frameBufferPoolRetain(&main_sceneTargets, cache->region);
+                    cache->hash = hash;
+                    cache->age = 0;
+                    cache->drawnCount++;
+                } else {
+                    cache->reusedCount++;
+                }
+                if (changed) {
+                    snz_requestRedraw(); // still moving (or throttled), and the tree only sees the scene as a texture
+                }
+            }
+            if (main_targetCelestial == main_rootCelestial) {
+                main_targetCelestial = NULL;
+                main_targetCelestialZoomed = false;
+            }
+            if (main_targetCelestial != prevTarget) {
+                ui_debugLogF("targeting %s", main_targetCelestial ? main_targetCelestial->name : "nothing");
+            }
+            _snzu_Box* prevSelected = snzu_getSelectedBox();
+            snzu_boxSelect(sceneBox);
+            snzu_boxSetTextureFrameBufferRegion(main_sceneCache.region);
+            snzu_boxSelect(prevSelected);
         } // end main scene
 
         snzu_boxNew("left bar");
@@ -223,7 +435,7 @@ void main_loop(float dt, snz_Arena* frameArena, snzu_Input og_frameInputs, HMM_V
                     snzu_boxSetSizeFromStart(HMM_V2(paddedSize, paddedSize));
                     snzu_boxScope() {
                         snzu_boxNew("planet");
-                        snzu_boxSetTexture(c->texture);
+                        snzu_boxSetTextureRegion(*c->texture);
                         snzu_boxSetColor(c->color);
                         snzu_boxSetSizeFromStart(HMM_V2(planetSize, planetSize));
                         snzu_boxAlignInParent(SNZU_AX_X, SNZU_ALIGN_CENTER);
@@ -261,7 +473,44 @@ void main_loop(float dt, snz_Arena* frameArena, snzu_Input og_frameInputs, HMM_V
         } // end left bar
     }
 
+    if (main_showRenderStats) {
+        ui_debugGpuZones();
+        ui_debugCullStats();
+        ui_debugTextCacheStats();
+        ui_debugResourceStats();
+        ui_debugPacingStats();
+        const char* aaNames[SNZR_AA_COUNT] = { "none", "msaa", "fxaa" };
+        ui_debugValueF("scene aa (F4)", "%s%s%s", aaNames[main_sceneTargets.aa], // what's in use, not main_sceneAA
+                       main_sceneTargets.aa != main_sceneTargets.requestedAA ? ", fell back from " : "",
+                       main_sceneTargets.aa != main_sceneTargets.requestedAA ? aaNames[main_sceneTargets.requestedAA] : "");
+        snzr_CaptureStats captures = snzr_captureStatsGet();
+        if (main_dynamicResolution) {
+            ui_debugValueF("scene resolution (F6)", "dynamic, %.0f%%, %.2fms of %.2fms", sceneScale * 100,
+                           main_sceneResolution.lastMs, main_sceneResolution.budgetMs);
+        } else { // the controller isn't updated while off, so what it has is stale
+            ui_debugValueF("scene resolution (F6)", "native, %.0f%%", sceneScale * 100);
+        }
+        ui_debugValueF("scene rate (F7)", "%s%s, %llu drawn %llu reused",
+                       main_sceneHz > 0 ? "reduced" : "full", main_paused ? ", paused (P)" : "",
+                       main_sceneCache.drawnCount, main_sceneCache.reusedCount);
+        if (main_targetCelestial && main_targetCelestial->surface) {
+            ui_debugVirtualTextureStats("surface tiles", main_targetCelestial->surface);
+        }
+        ui_debugValueF("capturing (F5)", "%s, %llu written %llu dropped %llu failed",
+                       main_capturing ? "on" : "off", captures.written, captures.dropped, captures.failed);
+    }
     ui_debugValuesBuild();
     HMM_Mat4 uiVP = HMM_Orthographic_RH_NO(0, og_screenSize.X, og_screenSize.Y, 0, 0.0001, 100000);
     snzu_frameDrawAndGenInteractions(og_frameInputs, uiVP);
+    if (main_capturing) {
+        snzr_captureFrame(MAIN_CAPTURE_DIR);
+    }
+    snzr_frameBufferPoolFrameEnd(&main_sceneTargets); // after the ui draws, because it samples the scene target
+    if (main_sceneTargets.requestedAA != main_sceneAA) { // not aa, which can differ after a fallback
+        snzr_frameBufferPoolDeinit(&main_sceneTargets);
+        main_sceneCache.region = (snzr_FrameBufferRegion){ 0 }; // freed with the pool
+        const char* prevOwner = snzr_resourceOwnerSet("scene");
+        main_sceneTargets = snzr_frameBufferPoolInit(120, main_sceneAA, MAIN_SCENE_MSAA_SAMPLES);
+        snzr_resourceOwnerSet(prevOwner);
+    }
 }
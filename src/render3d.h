@@ -56,6 +56,10 @@ ren3d_Mesh ren3d_meshInit(ren3d_Vert* verts, uint64_t vertCount, uint32_t* indic
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t), indicies, GL_STATIC_DRAW);
     out.indexCount = indexCount;
 
+    snzr_resourceTrack(SNZR_RK_VERTEX_ARRAY, out.vaId, 0);
+    snzr_resourceTrack(SNZR_RK_BUFFER, out.vertexBufferId, vertCount * vertSize);
+    snzr_resourceTrack(SNZR_RK_BUFFER, out.indexBufferId, indexCount * sizeof(uint32_t));
+
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertSize, NULL);  // position
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, vertSize, (void*)offsetof(ren3d_Vert, color));  // color
@@ -66,32 +70,39 @@ ren3d_Mesh ren3d_meshInit(ren3d_Vert* verts, uint64_t vertCount, uint32_t* indic
 }
 
 void ren3d_meshDeinit(ren3d_Mesh* mesh) {
-    glDeleteVertexArrays(1, &mesh->vaId);
-    glDeleteBuffers(1, &mesh->vertexBufferId);
+    snzr_resourceRelease(SNZR_RK_VERTEX_ARRAY, mesh->vaId);
+    snzr_resourceRelease(SNZR_RK_BUFFER, mesh->vertexBufferId);
+    snzr_resourceRelease(SNZR_RK_BUFFER, mesh->indexBufferId);
     memset(mesh, 0, sizeof(*mesh));
 }
 
 static uint32_t _ren3d_flatId;
+static uint32_t _ren3d_surfaceId;
 
 void ren3d_init(snz_Arena* scratch) {
     const char* vertSrc = _ren3d_loadFileToStr("res/shaders/flat.vert", scratch);
     const char* fragSrc = _ren3d_loadFileToStr("res/shaders/flat.frag", scratch);
+    const char* prevOwner = snzr_resourceOwnerSet("ren3d");
     _ren3d_flatId = snzr_shaderInit(vertSrc, fragSrc, scratch);
+    vertSrc = _ren3d_loadFileToStr("res/shaders/surface.vert", scratch);
+    fragSrc = _ren3d_loadFileToStr("res/shaders/surface.frag", scratch);
+    _ren3d_surfaceId = snzr_shaderInit(vertSrc, fragSrc, scratch);
+    snzr_resourceOwnerSet(prevOwner);
 }
 
-void ren3d_drawMesh(const ren3d_Mesh* mesh, HMM_Mat4 vp, HMM_Mat4 model) {
-    snzr_callGLFnOrError(glUseProgram(_ren3d_flatId));
-
-    // FIXME: gl safe uniform loc calls
-    int loc = glGetUniformLocation(_ren3d_flatId, "uVP");
-    snzr_callGLFnOrError(glUniformMatrix4fv(loc, 1, false, (float*)&vp));
+void ren3d_deinit() {
+    snzr_resourceRelease(SNZR_RK_PROGRAM, _ren3d_flatId);
+    _ren3d_flatId = 0;
+    snzr_resourceRelease(SNZR_RK_PROGRAM, _ren3d_surfaceId);
+    _ren3d_surfaceId = 0;
+}
 
-    loc = glGetUniformLocation(_ren3d_flatId, "uModel");
-    snzr_callGLFnOrError(glUniformMatrix4fv(loc, 1, false, (float*)&model));
+void ren3d_drawMesh(const ren3d_Mesh* mesh, HMM_Mat4 vp, HMM_Mat4 model) {
+    snzr_drawMesh(_ren3d_flatId, mesh->vaId, mesh->indexCount, vp, model);
+}
 
-    snzr_callGLFnOrError(glBindVertexArray(mesh->vaId));
-    snzr_callGLFnOrError(glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBufferId));
-    snzr_callGLFnOrError(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBufferId));
-    // snzr_callGLFnOrError(glDrawArrays(GL_TRIANGLES, 0, mesh->indexCount / 5));
-    snzr_callGLFnOrError(glDrawElements(GL_TRIANGLES, mesh->indexCount, GL_UNSIGNED_INT, NULL));
+// for unit spheres, surface is mapped equirectangularly and the verts color shows until its tiles are resident
+void ren3d_drawSphereSurface(const ren3d_Mesh* mesh, const snzr_VirtualTexture* surface, HMM_Mat4 vp, HMM_Mat4 model) {
+    snzr_virtualTextureBind(surface, _ren3d_surfaceId);
+    snzr_drawMesh(_ren3d_surfaceId, mesh->vaId, mesh->indexCount, vp, model);
 }
@@ -23,6 +23,7 @@ UTILITIES:
     SNZ_SLICE, SNZ_SLICE_NAMED  Macros that define a 'slice' struct.
         Just contains ptr and length fields. Used in combo with arenas for some
         convienent things. (see SNZ_ARENA_ARR_BEGIN)
+    snz_hashBytes               FNV-1a, chainable, start from SNZ_HASH_SEED
 
 ARENAS:
     Standard allocation solution so you never have to remember to free things.
@@ -43,18 +44,68 @@ ARENAS:
 
     There are other functions that can be useful, but these are the ones you should know.
 
+JOBS:
+    A tiny worker thread pool, started by snz_main. Jobs are fire and forget function pointers.
+
+    snz_jobPush - queues a function to run on a worker thread
+    snz_jobGroupPush - same, but counts it against a snz_JobGroup
+    snz_jobGroupWait - blocks (and helps out with queued jobs) until every job in a group is done
+
 RENDER:
     Some basic openGL stuff to make the UI library work, occasionally useful in user code too.
     Relatively self explanitory, but you probably need to know opengl to use it.
 
     snzr_shaderInit: wrapper code to make a shader in openGL
+        (linked binaries are cached in 'shader.cache' next to the log, keyed by source and driver)
+    snzr_shaderPermutationGet: one source, variants picked by a key of #define feature bits, compiled on first use
     snzr_textureInitRGBA: wrapper code to make a texture in openGL
+        (the Filtered variants take a snzr_TextureFilter, trilinear builds a mip chain)
+    snzr_textureLoadAsync: decodes an image on a worker, uploads it a slice per frame, placeholder until then
+    snzr_virtualTextureInit: a huge image baked into tiles (snzr_virtualTextureBake), only the tiles asked for
+        with snzr_virtualTextureRequest get streamed into a fixed size cache. Sample with snzr_virtualTextureBind.
+        snzr_virtualTextureIsCurrent says whether a bake is complete and matches its image.
+    snzr_atlasAdd: packs small images into shared pages, returns a snzr_TextureRegion (texture + uvs)
+        so icon heavy UI draws from one texture. Async loads can go into an atlas too.
     snzr_frameBufferInit: wrapper code to make a framebuffere in openGL
-    snzr_drawRect: invokes the rectangle shader (FIXME: doing this for every rectangle in the UI is hella inefficent, look into call batching)
+    snzr_resourceStatsGet: every gl object made through snooze is tracked, with an estimated size and an owner
+        (snzr_resourceOwnerSet). Deinits release, and the delete waits out the frames in flight.
+        Whatever is still live at shutdown gets logged as a leak.
+    snzr_frameBufferInitAA: same, but with msaa or fxaa. Draw, then snzr_frameBufferResolve before sampling.
+        (the window itself never has msaa, rect edges are anti-aliased in the shader)
+    snzr_frameBufferPoolAcquire: gets a region of a pooled framebuffer, for targets that resize a lot.
+        Sizes are rounded up to classes, smaller requests render into a corner of bigger targets,
+        and unused targets get freed after a while. snzr_frameBufferPoolFrameEnd releases everything,
+        except regions held onto with snzr_frameBufferPoolRetain, to be shown again without redrawing.
+        Pools can have aa too, regions get snzr_frameBufferRegionResolve.
+        snzr_drawUpscaled stretches a region over a bigger target with a sharper filter than bilinear.
+    snzr_passGraphExecute: runs passes that declare the targets they read and write, in dependency order.
+        Targets come from a pool and get shared between passes that don't overlap, unused passes are skipped.
+    snzr_drawRect: draws a rectangle with the rect shader
+        (snzr_drawRectTextureRegion only samples part of the texture, i.e. a framebuffer region)
 
     snzr_strSize: how large a string would be in pixels if rendered // this one is very useful
+        (layouts are cached across frames and shared with drawing, see snzr_textCacheStatsGet)
     snzr_drawText: draws a string on screen
+    snzr_paragraphLayout: wraps text to a width (tab stops, kerning, ellipsis past maxLines) into a table of lines,
+        snzr_paragraphEdit updates it after an edit without redoing all of it, snzr_drawParagraph draws it
     snzr_drawLine: draws a line on screen
+        (snzr_lineBatchBegin/Add/End puts lots of them, each with their own style, into one draw)
+    snzr_drawRing: draws a circle outline as one instanced quad, for lots of them (orbits etc.)
+    snzr_drawMesh: draws an indexed VAO with a user shader
+
+    snzr_cmdListBegin/End/Submit: between begin and end, every snzr_drawXXXX call is recorded
+        into the list instead of hitting GL. Submit sorts by layer (snzr_cmdListSetLayer) and then
+        record order, and merges neighbouring rects and text into instanced draws.
+        Outside of a list draws are submitted immediately. snzu records the whole tree into one.
+    snzr_cpuRasterize: draws a recorded command list into an RGBA8 snzr_CpuTarget on the CPU instead,
+        no GPU needed. Good as a reference to diff GL output against. Skips meshes & color textures.
+
+    snzr_gpuZone: times the GL work inside it, i.e. snzr_gpuZone("scene") { ... }
+        results trail by a few frames, read with snzr_gpuZoneGetStats or snzr_gpuProfilerDumpCSV
+        zones time GL calls, so around a command list wrap the submit, not the recording
+    snzr_dynamicResolutionUpdate: scales a target down and back up to keep a gpu zone under a budget in ms.
+    snzr_captureFrame: writes the frame to a QOI file in a directory, without stalling.
+        Read back through a ring of buffers a couple frames late and encoded on a worker.
 
 UI:
     This is the complicated one.
@@ -66,6 +117,7 @@ UI:
         snzu_instanceSelect: makes following functions use an instance ^^^^^^^^^^^^^^^^^^^^^^^^^
         snzu_frameStart: begin frame
         snzu_frameDrawAndGenInteractions: ends frame, draws it to the screen
+            (skips transparent, clipped and covered boxes, and whole subtrees outside of the clip, see snzu_cullStatsGet)
 
     This UI library is based on 'boxes,' which are rectangles on the screen.
     They nest inside each other, process inputs, and contain text
@@ -94,6 +146,7 @@ UI:
             the box is no longer gonna fill the parent. Its a one time command.
     snzu_boxSetColor: sets fill color of a box
     snzu_boxSetDisplayStr: renders a string in the middle of the box
+    snzu_boxSetParagraph: renders a wrapped snzr_Paragraph from the top left of the box
     snzu_boxSetSizeFitText: does as the name suggests
 
     SNZU_USE_MEM:
@@ -146,13 +199,30 @@ MAIN LOOP HANDLING:
     snz_main: wraps up SDL, openGL, snz initialization into something convinent.
     i.e.:
         int main() {
-            snz_main("this is the app", NULL, myInitFunc, myLoopFunc)
+            snz_main("this is the app", NULL, myInitFunc, myLoopFunc, myDeinitFunc)
             return 0;
         }
+        (deinit may be null, whatever gpu resources are left get logged as leaks on the way out)
+
+    snz_mainHeadless: same init & frame functions, but no window. Runs a fixed number of
+        frames into an offscreen framebuffer on a surfaceless EGL context, for benchmarks & CI.
+        i.e. snz_mainHeadless(1920, 1080, 600, "last_frame.ppm", myInitFunc, myLoopFunc, myDeinitFunc);
 
     snz_quit: used to exit the app from user code. Doesn't immediately quit, waits
               until the next frame starts.
 
+    snz_pacingSetMode: vsync (default), adaptive vsync, or a fixed fps cap done on the cpu.
+        In every mode input is sampled as late as the measured build time allows, to cut latency.
+        snz_pacingStatsGet has frame times, input to present latency and missed deadline counts.
+
+    snz_requestRedraw: snz_main skips drawing and presenting frames where the UI box tree
+        hashes the same as last frame and no snzu_easeExp is still moving, and sleeps until
+        the next event when idle. Anything drawn outside of the tree (i.e. raw gl into a
+        framebuffer shown with snzu_boxSetTexture) has to call this every frame it changes.
+
+    snzr_frameBufferBindScreen: binds whatever is presented (window or headless target),
+        use it instead of binding framebuffer 0 after rendering to your own framebuffers.
+
 UI COMPONENTS:
     snzuc_button: a button implementation
     snzuc_scrollArea: a scroll area implementation
@@ -169,6 +239,26 @@ UI COMPONENTS:
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define _SNZR_CPU_SSE2
+#endif
+
+// long is 32 bits on windows, so seeks and sizes that can go past 2gb use these
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#define _SNZ_MKDIR(path) _mkdir(path)
+#define _SNZ_FSEEK64(file, offset, origin) _fseeki64(file, offset, origin)
+typedef struct _stat64 _snz_Stat;
+#define _SNZ_STAT(path, outStat) _stat64(path, outStat)
+#else
+#define _SNZ_MKDIR(path) mkdir(path, 0755)
+#define _SNZ_FSEEK64(file, offset, origin) fseeko(file, (off_t)(offset), origin)
+typedef struct stat _snz_Stat;
+#define _SNZ_STAT(path, outStat) stat(path, outStat)
+#endif
+
 #define SDL_MAIN_HANDLED
 #include "GLAD/include/glad/glad.h"
 #include "HMM/HandmadeMath.h"
@@ -189,15 +279,18 @@ FILE* _snz_logFile;
 void _snz_logF(const char* file, int64_t line, const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
+    va_list argsCopy;  // a va_list can only be walked once
+    va_copy(argsCopy, args);
 
     fprintf(_snz_logFile, "[%s:%lld]: ", file, line);
     vfprintf(_snz_logFile, fmt, args);
     fputc('\n', _snz_logFile);
 
     printf("[%s:%lld]: ", file, line);
-    vprintf(fmt, args);
+    vprintf(fmt, argsCopy);
     printf("\n");
 
+    va_end(argsCopy);
     va_end(args);
 }
 
@@ -216,13 +309,16 @@ void _snz_assertf(bool cond, const char* fmt, const char* file, int64_t line, ..
     if (!cond) {
         va_list args;
         va_start(args, line);
+        va_list argsCopy;
+        va_copy(argsCopy, args);
         printf("[%s:%lld]: [ASSERTION FAILED]: ", file, line);
         vprintf(fmt, args);
         printf("\n");
 
         fprintf(_snz_logFile, "[%s:%lld]: [ASSERTION FAILED]: ", file, line);
-        vfprintf(_snz_logFile, fmt, args);
+        vfprintf(_snz_logFile, fmt, argsCopy);
         fprintf(_snz_logFile, "\n");
+        va_end(argsCopy);
         va_end(args);
 
         fclose(_snz_logFile);
@@ -269,6 +365,18 @@ SNZ_SLICE(uint8_t);
 
 // FIXME: multiple def guards
 
+#define SNZ_HASH_SEED 14695981039346656037ull
+
+// FNV-1a, chain calls by passing the last result as hash (start with SNZ_HASH_SEED)
+uint64_t snz_hashBytes(uint64_t hash, const void* data, uint64_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (uint64_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
 // UTILITIES ==================================================================
 // UTILITIES ==================================================================
 // UTILITIES ==================================================================
@@ -326,16 +434,17 @@ void* snz_arenaPush(snz_Arena* a, int64_t size, int64_t count) {
                 a->name, a->arrModeTypeName, a->arrModeElemSize, size);
     a->arrModeElemCount += count;  // this will always be correct when inside arr mode, and it will just get reset on enter, so we don't need to branch here.
 
+    int64_t total = size * count;
     if (!a->arrModeElemSize) {  // only align allocations when not in array mode
-        size += sizeof(uint64_t) - (size % sizeof(uint64_t));
+        total += (16 - (total % 16)) % 16;  // align the whole thing, not each elem. 16 because HMM types can be SSE backed
     }
     char* o = (char*)(a->end);
-    if (!(o + (size * count) < (char*)(a->start) + a->reserved)) {
+    if (!(o + total < (char*)(a->start) + a->reserved)) {
         SNZ_ASSERTF(false,
                     "arena push failed for '%s'. Cap: %lld, Used: %llu, Requested: %llu",
-                    a->name, a->reserved, (uint64_t)a->end - (uint64_t)a->start, count * size);
+                    a->name, a->reserved, (uint64_t)a->end - (uint64_t)a->start, total);
     }
-    a->end = o + (size * count);
+    a->end = o + total;
     return o;
 }
 
@@ -369,9 +478,12 @@ char* snz_arenaCopyStr(snz_Arena* arena, const char* str) {
 }
 
 char* snz_arenaFormatStrV(snz_Arena* arena, const char* fmt, va_list args) {
+    va_list argsCopy;  // a va_list can only be walked once
+    va_copy(argsCopy, args);
     uint64_t len = vsnprintf(NULL, 0, fmt, args);
     char* out = SNZ_ARENA_PUSH_ARR(arena, len + 1, char);
-    vsprintf_s(out, len + 1, fmt, args);
+    vsprintf_s(out, len + 1, fmt, argsCopy);
+    va_end(argsCopy);
     return out;
 }
 
@@ -411,6 +523,151 @@ void _snz_arenaArrEnd(snz_Arena* a, int64_t elemSize) {
 // ARENAS ======================================================================
 // ARENAS ======================================================================
 
+// JOBS ========================================================================
+// JOBS ========================================================================
+// JOBS ========================================================================
+
+typedef void (*snz_JobFunc)(void* userData);
+
+typedef struct {
+    SDL_atomic_t remaining;
+} snz_JobGroup;
+
+typedef struct {
+    snz_JobFunc func;
+    void* userData;
+    snz_JobGroup* group;  // may be null
+} _snz_Job;
+
+#define _SNZ_JOB_QUEUE_SIZE 4096
+#define _SNZ_JOB_MAX_WORKERS 16
+
+struct {
+    SDL_mutex* mutex;
+    SDL_cond* jobAvailable;
+    _snz_Job queue[_SNZ_JOB_QUEUE_SIZE];  // ring buffer
+    int64_t queueStart;
+    int64_t queueCount;
+
+    SDL_Thread* workers[_SNZ_JOB_MAX_WORKERS];
+    int64_t workerCount;
+    bool shouldQuit;
+} _snz_jobGlobs;
+
+// returns false if there was nothing to take, expects the mutex to be locked
+static bool _snz_jobTakeLocked(_snz_Job* out) {
+    if (_snz_jobGlobs.queueCount == 0) {
+        return false;
+    }
+    *out = _snz_jobGlobs.queue[_snz_jobGlobs.queueStart];
+    _snz_jobGlobs.queueStart = (_snz_jobGlobs.queueStart + 1) % _SNZ_JOB_QUEUE_SIZE;
+    _snz_jobGlobs.queueCount--;
+    return true;
+}
+
+static void _snz_jobRun(_snz_Job* job) {
+    job->func(job->userData);
+    if (job->group) {
+        SDL_AtomicAdd(&job->group->remaining, -1);
+    }
+}
+
+static int _snz_jobWorkerMain(void* unused) {
+    (void)unused;
+    while (true) {
+        _snz_Job job = { 0 };
+        SDL_LockMutex(_snz_jobGlobs.mutex);
+        bool took = false;
+        while (!(took = _snz_jobTakeLocked(&job)) && !_snz_jobGlobs.shouldQuit) {
+            SDL_CondWait(_snz_jobGlobs.jobAvailable, _snz_jobGlobs.mutex);
+        }
+        SDL_UnlockMutex(_snz_jobGlobs.mutex);
+
+        if (!took) {
+            return 0;  // quitting and the queue is drained
+        }
+        _snz_jobRun(&job);
+    }
+}
+
+// workerCount <= 0 picks one less than the number of cores (min 1)
+void snz_jobsInit(int64_t workerCount) {
+    memset(&_snz_jobGlobs, 0, sizeof(_snz_jobGlobs));
+    if (workerCount <= 0) {
+        workerCount = SNZ_MAX(SDL_GetCPUCount() - 1, 1);
+    }
+    workerCount = SNZ_MIN(workerCount, _SNZ_JOB_MAX_WORKERS);
+
+    _snz_jobGlobs.mutex = SDL_CreateMutex();
+    _snz_jobGlobs.jobAvailable = SDL_CreateCond();
+    SNZ_ASSERT(_snz_jobGlobs.mutex && _snz_jobGlobs.jobAvailable, "creating job sync primitives failed.");
+    for (int64_t i = 0; i < workerCount; i++) {
+        _snz_jobGlobs.workers[i] = SDL_CreateThread(_snz_jobWorkerMain, "snz worker", NULL);
+        SNZ_ASSERT(_snz_jobGlobs.workers[i], "creating job worker thread failed.");
+    }
+    _snz_jobGlobs.workerCount = workerCount;
+}
+
+// finishes whatever jobs are already queued, then joins all workers
+void snz_jobsDeinit() {
+    SDL_LockMutex(_snz_jobGlobs.mutex);
+    _snz_jobGlobs.shouldQuit = true;
+    SDL_CondBroadcast(_snz_jobGlobs.jobAvailable);
+    SDL_UnlockMutex(_snz_jobGlobs.mutex);
+
+    for (int64_t i = 0; i < _snz_jobGlobs.workerCount; i++) {
+        SDL_WaitThread(_snz_jobGlobs.workers[i], NULL);
+    }
+    SDL_DestroyCond(_snz_jobGlobs.jobAvailable);
+    SDL_DestroyMutex(_snz_jobGlobs.mutex);
+    memset(&_snz_jobGlobs, 0, sizeof(_snz_jobGlobs));
+}
+
+// group may be null
+// asserts if the queue is full
+void snz_jobGroupPush(snz_JobGroup* group, snz_JobFunc func, void* userData) {
+    SNZ_ASSERT(_snz_jobGlobs.mutex != NULL, "job push failed, jobs weren't initialized.");
+    if (group) {
+        SDL_AtomicAdd(&group->remaining, 1);
+    }
+
+    SDL_LockMutex(_snz_jobGlobs.mutex);
+    SNZ_ASSERTF(_snz_jobGlobs.queueCount < _SNZ_JOB_QUEUE_SIZE, "job push failed, queue full (%d jobs).", _SNZ_JOB_QUEUE_SIZE);
+    int64_t idx = (_snz_jobGlobs.queueStart + _snz_jobGlobs.queueCount) % _SNZ_JOB_QUEUE_SIZE;
+    _snz_jobGlobs.queue[idx] = (_snz_Job){
+        .func = func,
+        .userData = userData,
+        .group = group,
+    };
+    _snz_jobGlobs.queueCount++;
+    SDL_CondSignal(_snz_jobGlobs.jobAvailable);
+    SDL_UnlockMutex(_snz_jobGlobs.mutex);
+}
+
+void snz_jobPush(snz_JobFunc func, void* userData) {
+    snz_jobGroupPush(NULL, func, userData);
+}
+
+// runs queued jobs on the calling thread while waiting, so this won't deadlock with a small pool
+void snz_jobGroupWait(snz_JobGroup* group) {
+    while (SDL_AtomicGet(&group->remaining) > 0) {
+        _snz_Job job = { 0 };
+        SDL_LockMutex(_snz_jobGlobs.mutex);
+        bool took = _snz_jobTakeLocked(&job);
+        SDL_UnlockMutex(_snz_jobGlobs.mutex);
+
+        if (took) {
+            _snz_jobRun(&job);
+        } else {
+            SDL_Delay(0);
+        }
+    }
+}
+
+// JOBS ========================================================================
+// JOBS ========================================================================
+// JOBS ========================================================================
+
 // RENDER ======================================================================
 // RENDER ======================================================================
 // RENDER ======================================================================
@@ -418,10 +675,17 @@ void _snz_arenaArrEnd(snz_Arena* a, int64_t elemSize) {
 #define _SNZR_FONT_ATLAS_W 2000
 #define _SNZR_FONT_ATLAS_H 2000
 
+typedef enum {
+    SNZR_TF_LINEAR,     // one level, bilinear
+    SNZR_TF_NEAREST,    // one level, no filtering
+    SNZR_TF_TRILINEAR,  // mip chain (built with glGenerateMipmap), linear between levels
+} snzr_TextureFilter;
+
 typedef struct {
     uint32_t glId;
     uint32_t width;
     uint32_t height;
+    snzr_TextureFilter filter;
 } snzr_Texture;  // doesn't own or point pixel memory, assumed to be loaded on the gpu already
 
 typedef struct {
@@ -431,16 +695,27 @@ typedef struct {
     float lineGap;
     stbtt_pack_range packRange;
     snzr_Texture atlas;
+    uint8_t* atlasPixels;  // kept CPU side for snzr_cpuRasterize, in the data arena
+    float* kerning;  // pairs of printable ascii, in pixels at renderedSize. Null if the font doesn't kern
+    uint64_t generation;  // unique per snzr_fontInit, gl reuses the atlas id once a font is freed
 } snzr_Font;
 
 struct {
     HMM_Vec2 screenSize;
 
-    uint32_t rectShaderId;
     uint32_t lineShaderId;
-    uint32_t lineShaderSSBOId;
+    uint32_t lineShaderSSBOId;  // points of every line in a submit, back to back
+    uint32_t lineHeaderSSBOId;  // a _snzr_LineHeader per line
 
     snzr_Texture solidTex;
+    snzr_Texture placeholderTex;
+
+    uint32_t screenFrameBufferId;  // 0 when there's a window, an offscreen target when headless
+
+    uint32_t fxaaShaderId;
+    uint32_t upscaleShaderId;
+    uint32_t fullscreenVaId;  // empty, the fullscreen triangle comes from gl_VertexID
+    int32_t maxSamples;
 } _snzr_globs;
 
 static void _snzr_glDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const char* message, const void* userParam) {
@@ -462,6 +737,269 @@ static void _snzr_glDebugCallback(GLenum source, GLenum type, GLuint id, GLenum
         }                                                                                   \
     } while (0)
 
+// Every gl object snooze (and ren3d) makes is tracked here, with a size estimate and an owner tag,
+// so there's a live readout of what is using vram and a report at shutdown of whatever never got freed.
+// Deinit functions release instead of deleting, and the delete happens a few frames later once
+// nothing in flight can still be using it. That makes it safe to free something that was drawn this frame.
+// Tracking is by kind + gl id since that's what the snzr_ structs already carry around.
+typedef enum {
+    SNZR_RK_TEXTURE,
+    SNZR_RK_RENDERBUFFER,
+    SNZR_RK_BUFFER,
+    SNZR_RK_FRAMEBUFFER,
+    SNZR_RK_VERTEX_ARRAY,
+    SNZR_RK_PROGRAM,
+    SNZR_RK_COUNT,
+} snzr_ResourceKind;
+
+typedef struct {
+    snzr_ResourceKind kind;
+    uint32_t glId;
+    uint64_t bytes;  // estimate, what the driver actually uses isn't queryable
+    const char* owner;
+    int64_t releasedFrame;  // -1 while live
+} _snzr_Resource;
+
+#define _SNZR_RESOURCE_FRAME_LAG 3
+#define _SNZR_RESOURCE_MAX_OWNERS 16
+
+typedef struct {
+    uint64_t bytes[SNZR_RK_COUNT];
+    uint64_t counts[SNZR_RK_COUNT];
+    uint64_t pendingBytes;  // released, waiting on frames in flight before being deleted
+    uint64_t pendingCount;
+
+    const char* ownerNames[_SNZR_RESOURCE_MAX_OWNERS];
+    uint64_t ownerBytes[_SNZR_RESOURCE_MAX_OWNERS];
+    int64_t ownerCount;  // owners past the max are left out
+} snzr_ResourceStats;
+
+struct {
+    _snzr_Resource* entries;
+    int64_t count;
+    int64_t capacity;
+    int64_t frame;
+    const char* owner;
+
+    // open addressed index over entries by kind + gl id, each slot is an entry index + 1, 0 when empty
+    // kept at most half full. gl can't reuse an id until it's deleted, so released entries never collide with live ones.
+    int64_t* slots;
+    int64_t slotCount;
+} _snzr_resourceGlobs;
+
+static const char* _snzr_resourceKindNames[SNZR_RK_COUNT] = {
+    "texture", "renderbuffer", "buffer", "framebuffer", "vertex array", "program",
+};
+
+static const char* _snzr_resourceOwner() {
+    return _snzr_resourceGlobs.owner ? _snzr_resourceGlobs.owner : "snooze";
+}
+
+// tags everything tracked from here on, until the next call. Returns the previous owner so it can be put back.
+// string must be static. Things are owned by "snooze" when nothing else was set.
+// Things that make resources lazily (pools, atlases, async loads) keep the owner from when they were made.
+const char* snzr_resourceOwnerSet(const char* owner) {
+    const char* prev = _snzr_resourceOwner();
+    _snzr_resourceGlobs.owner = owner;
+    return prev;
+}
+
+static int64_t _snzr_resourceSlotHome(snzr_ResourceKind kind, uint32_t glId) {
+    uint64_t key = ((uint64_t)kind << 32) | glId;
+    return (int64_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (_snzr_resourceGlobs.slotCount - 1);
+}
+
+// the slot holding kind + glId, or the empty slot it would go in
+static int64_t _snzr_resourceSlotFind(snzr_ResourceKind kind, uint32_t glId) {
+    int64_t mask = _snzr_resourceGlobs.slotCount - 1;
+    int64_t slot = _snzr_resourceSlotHome(kind, glId);
+    for (; _snzr_resourceGlobs.slots[slot]; slot = (slot + 1) & mask) {
+        const _snzr_Resource* r = &_snzr_resourceGlobs.entries[_snzr_resourceGlobs.slots[slot] - 1];
+        if (r->kind == kind && r->glId == glId) {
+            break;
+        }
+    }
+    return slot;
+}
+
+static void _snzr_resourceIndexRebuild(int64_t slotCount) {
+    free(_snzr_resourceGlobs.slots);
+    _snzr_resourceGlobs.slots = calloc(slotCount, sizeof(int64_t));
+    SNZ_ASSERT(_snzr_resourceGlobs.slots, "growing gpu resource index failed.");
+    _snzr_resourceGlobs.slotCount = slotCount;
+    for (int64_t i = 0; i < _snzr_resourceGlobs.count; i++) {
+        const _snzr_Resource* r = &_snzr_resourceGlobs.entries[i];
+        _snzr_resourceGlobs.slots[_snzr_resourceSlotFind(r->kind, r->glId)] = i + 1;
+    }
+}
+
+// empties a slot, shifting back anything after it that probed past it so lookups don't stop early
+static void _snzr_resourceSlotClear(int64_t slot) {
+    int64_t mask = _snzr_resourceGlobs.slotCount - 1;
+    int64_t hole = slot;
+    for (int64_t i = (slot + 1) & mask; _snzr_resourceGlobs.slots[i]; i = (i + 1) & mask) {
+        const _snzr_Resource* r = &_snzr_resourceGlobs.entries[_snzr_resourceGlobs.slots[i] - 1];
+        int64_t home = _snzr_resourceSlotHome(r->kind, r->glId);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            _snzr_resourceGlobs.slots[hole] = _snzr_resourceGlobs.slots[i];
+            hole = i;
+        }
+    }
+    _snzr_resourceGlobs.slots[hole] = 0;
+}
+
+// swap removes, keeping the index pointing at the right entries
+static void _snzr_resourceRemove(int64_t idx) {
+    const _snzr_Resource* r = &_snzr_resourceGlobs.entries[idx];
+    _snzr_resourceSlotClear(_snzr_resourceSlotFind(r->kind, r->glId));
+    int64_t last = --_snzr_resourceGlobs.count;
+    if (idx != last) {
+        const _snzr_Resource* moved = &_snzr_resourceGlobs.entries[last];
+        _snzr_resourceGlobs.slots[_snzr_resourceSlotFind(moved->kind, moved->glId)] = idx + 1;
+        _snzr_resourceGlobs.entries[idx] = *moved;
+    }
+}
+
+static _snzr_Resource* _snzr_resourceFind(snzr_ResourceKind kind, uint32_t glId) {
+    if (_snzr_resourceGlobs.slotCount == 0) {
+        return NULL;
+    }
+    int64_t entry = _snzr_resourceGlobs.slots[_snzr_resourceSlotFind(kind, glId)];
+    if (entry == 0) {
+        return NULL;
+    }
+    _snzr_Resource* r = &_snzr_resourceGlobs.entries[entry - 1];
+    return r->releasedFrame < 0 ? r : NULL;
+}
+
+// for gl objects made outside of the snzr_ init functions, pair with snzr_resourceRelease
+void snzr_resourceTrack(snzr_ResourceKind kind, uint32_t glId, uint64_t bytes) {
+    SNZ_ASSERTF(glId != 0, "tracking a %s with an id of 0.", _snzr_resourceKindNames[kind]);
+    SNZ_ASSERTF(!_snzr_resourceFind(kind, glId), "%s %u was tracked twice.", _snzr_resourceKindNames[kind], glId);
+    if (_snzr_resourceGlobs.count == _snzr_resourceGlobs.capacity) {
+        _snzr_resourceGlobs.capacity = SNZ_MAX(_snzr_resourceGlobs.capacity * 2, 64);
+        _snzr_resourceGlobs.entries = realloc(_snzr_resourceGlobs.entries, _snzr_resourceGlobs.capacity * sizeof(_snzr_Resource));
+        SNZ_ASSERT(_snzr_resourceGlobs.entries, "growing gpu resource registry failed.");
+    }
+    if ((_snzr_resourceGlobs.count + 1) * 2 > _snzr_resourceGlobs.slotCount) {
+        _snzr_resourceIndexRebuild(SNZ_MAX(_snzr_resourceGlobs.slotCount * 2, 128));
+    }
+    _snzr_resourceGlobs.slots[_snzr_resourceSlotFind(kind, glId)] = _snzr_resourceGlobs.count + 1;
+    _snzr_resourceGlobs.entries[_snzr_resourceGlobs.count++] = (_snzr_Resource){
+        .kind = kind,
+        .glId = glId,
+        .bytes = bytes,
+        .owner = _snzr_resourceOwner(),
+        .releasedFrame = -1,
+    };
+}
+
+// for buffers that get resized after they're made
+void snzr_resourceSetBytes(snzr_ResourceKind kind, uint32_t glId, uint64_t bytes) {
+    _snzr_Resource* r = _snzr_resourceFind(kind, glId);
+    SNZ_ASSERTF(r, "resizing untracked %s %u.", _snzr_resourceKindNames[kind], glId);
+    r->bytes = bytes;
+}
+
+// the gl object gets deleted once the frames in flight are done with it. Releasing 0 does nothing.
+// asserts if glId isn't tracked, which catches double frees.
+void snzr_resourceRelease(snzr_ResourceKind kind, uint32_t glId) {
+    if (glId == 0) {
+        return;
+    }
+    _snzr_Resource* r = _snzr_resourceFind(kind, glId);
+    SNZ_ASSERTF(r, "releasing untracked %s %u, freed twice?", _snzr_resourceKindNames[kind], glId);
+    r->releasedFrame = _snzr_resourceGlobs.frame;
+}
+
+static void _snzr_resourceDelete(const _snzr_Resource* r) {
+    switch (r->kind) {
+        case SNZR_RK_TEXTURE: glDeleteTextures(1, &r->glId); break;
+        case SNZR_RK_RENDERBUFFER: glDeleteRenderbuffers(1, &r->glId); break;
+        case SNZR_RK_BUFFER: glDeleteBuffers(1, &r->glId); break;
+        case SNZR_RK_FRAMEBUFFER: glDeleteFramebuffers(1, &r->glId); break;
+        case SNZR_RK_VERTEX_ARRAY: glDeleteVertexArrays(1, &r->glId); break;
+        case SNZR_RK_PROGRAM: glDeleteProgram(r->glId); break;
+        default: SNZ_ASSERTF(false, "invalid resource kind %d.", r->kind);
+    }
+}
+
+// deletes released things that are old enough, or everything released when all is set
+static void _snzr_resourceCollect(bool all) {
+    for (int64_t i = 0; i < _snzr_resourceGlobs.count; i++) {
+        _snzr_Resource* r = &_snzr_resourceGlobs.entries[i];
+        if (r->releasedFrame < 0) {
+            continue;
+        } else if (!all && _snzr_resourceGlobs.frame - r->releasedFrame < _SNZR_RESOURCE_FRAME_LAG) {
+            continue;
+        }
+        _snzr_resourceDelete(r);
+        _snzr_resourceRemove(i);
+        i--;
+    }
+}
+
+static void _snzr_resourceFrameEnd() {
+    _snzr_resourceGlobs.frame++;
+    _snzr_resourceCollect(false);
+}
+
+snzr_ResourceStats snzr_resourceStatsGet() {
+    snzr_ResourceStats out = { 0 };
+    for (int64_t i = 0; i < _snzr_resourceGlobs.count; i++) {
+        const _snzr_Resource* r = &_snzr_resourceGlobs.entries[i];
+        if (r->releasedFrame >= 0) {
+            out.pendingBytes += r->bytes;
+            out.pendingCount++;
+            continue;
+        }
+        out.bytes[r->kind] += r->bytes;
+        out.counts[r->kind]++;
+
+        int64_t owner = 0;
+        for (; owner < out.ownerCount; owner++) {
+            if (strcmp(out.ownerNames[owner], r->owner) == 0) {
+                break;
+            }
+        }
+        if (owner == out.ownerCount) {
+            if (out.ownerCount == _SNZR_RESOURCE_MAX_OWNERS) {
+                continue;
+            }
+            out.ownerNames[out.ownerCount++] = r->owner;
+        }
+        out.ownerBytes[owner] += r->bytes;
+    }
+    return out;
+}
+
+const char* snzr_resourceKindName(snzr_ResourceKind kind) {
+    SNZ_ASSERTF(kind >= 0 && kind < SNZR_RK_COUNT, "invalid resource kind %d.", kind);
+    return _snzr_resourceKindNames[kind];
+}
+
+// deletes everything pending and logs whatever is still live, by owner. Called at shutdown.
+static void _snzr_resourceLeakReport() {
+    glFinish();
+    _snzr_resourceCollect(true);
+    if (_snzr_resourceGlobs.count == 0) {
+        SNZ_LOG("No gpu resources leaked.");
+    } else {
+        snzr_ResourceStats stats = snzr_resourceStatsGet();
+        SNZ_LOGF("%lld gpu resources leaked:", _snzr_resourceGlobs.count);
+        for (int64_t i = 0; i < _snzr_resourceGlobs.count; i++) {
+            const _snzr_Resource* r = &_snzr_resourceGlobs.entries[i];
+            SNZ_LOGF("    %s %u, %llu bytes, owned by %s.", _snzr_resourceKindNames[r->kind], r->glId, r->bytes, r->owner);
+        }
+        for (int64_t i = 0; i < stats.ownerCount; i++) {
+            SNZ_LOGF("    %s leaked %llu bytes in total.", stats.ownerNames[i], stats.ownerBytes[i]);
+        }
+    }
+    free(_snzr_resourceGlobs.entries);
+    free(_snzr_resourceGlobs.slots);
+    memset(&_snzr_resourceGlobs, 0, sizeof(_snzr_resourceGlobs));
+}
+
 // step kind should be GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
 // asserts on failure of any kind, including opening the file and compiling the shader stage
 static uint32_t _snzr_loadShaderStep(const char* src, GLenum stepKind, snz_Arena* scratch) {
@@ -472,603 +1010,4536 @@ static uint32_t _snzr_loadShaderStep(const char* src, GLenum stepKind, snz_Arena
     glCompileShader(id);
 
     int compileSucceded = false;
-    char* logBuffer = SNZ_ARENA_PUSH_ARR(scratch, 512, char);  // FIXME: this is gross
     glGetShaderiv(id, GL_COMPILE_STATUS, &compileSucceded);
     if (!compileSucceded) {
-        glGetShaderInfoLog(id, 512, NULL, logBuffer);
+        int logLength = 0;
+        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &logLength);
+        char* logBuffer = SNZ_ARENA_PUSH_ARR(scratch, logLength + 1, char);
+        glGetShaderInfoLog(id, logLength + 1, NULL, logBuffer);
         SNZ_ASSERTF(false, "Compiling shader stage \"%d\" from failied: %s.", stepKind, logBuffer);
     };
 
     return id;
 }
 
-// returns the openGL id of the shader
+#define _SNZR_SHADER_CACHE_PATH "shader.cache"
+#define _SNZR_SHADER_CACHE_TEMP_PATH "shader.cache.tmp"
+#define _SNZR_SHADER_CACHE_MAGIC 0x535a4e53
+#define _SNZR_SHADER_CACHE_MAX_FORMATS 8
+#define _SNZR_SHADER_CACHE_MAX_KEPT 128
+
+// the cache file is one of these, then entries (each an entry header followed by the binary)
+typedef struct {
+    uint32_t magic;
+    uint32_t pad;
+    uint64_t driverHash;
+} _snzr_ShaderCacheHeader;
+
+typedef struct {
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+} _snzr_ShaderCacheEntryHeader;
+
+typedef struct {
+    _snzr_ShaderCacheEntryHeader header;
+    const uint8_t* binary;  // into the file's entries, or malloced when owned
+    bool owned;
+} _snzr_ShaderCacheKept;
+
+// linked program binaries from previous runs, so startup doesn't have to compile anything it's seen before
+// keyed by the hash of the sources, and the whole file is thrown out when the driver changes
+// New binaries are appended as they're made so a crash doesn't lose them. Once anything was stored or rejected
+// the file gets compacted at shutdown, down to the newest binary for each key used this run,
+// which is what drops binaries for sources that have since been edited.
+static struct {
+    bool enabled;
+    uint64_t driverHash;
+    int32_t formats[_SNZR_SHADER_CACHE_MAX_FORMATS];  // what the driver takes, formats past the max are treated as unknown
+    int64_t formatCount;
+    snz_Arena fileArena;  // entries from the last run, new ones only go to the file
+    const uint8_t* entries;
+    uint64_t entriesSize;
+
+    _snzr_ShaderCacheKept kept[_SNZR_SHADER_CACHE_MAX_KEPT];  // keys past the max are left out of the compacted file
+    int64_t keptCount;
+    bool stale;  // the file has entries nothing will read again
+} _snzr_shaderCacheGlobs;
+
+static void _snzr_shaderCacheInit() {
+    int formatCount = 0;
+    snzr_callGLFnOrError(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount));
+    if (formatCount == 0) {
+        SNZ_LOG("Driver supports no program binary formats, shader cache disabled.");
+        return;
+    }
+    _snzr_shaderCacheGlobs.enabled = true;
+    int32_t* formats = malloc(formatCount * sizeof(int32_t));
+    SNZ_ASSERT(formats, "allocating binary formats failed.");
+    snzr_callGLFnOrError(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats));
+    _snzr_shaderCacheGlobs.formatCount = SNZ_MIN(formatCount, _SNZR_SHADER_CACHE_MAX_FORMATS);
+    memcpy(_snzr_shaderCacheGlobs.formats, formats, _snzr_shaderCacheGlobs.formatCount * sizeof(int32_t));
+    free(formats);
+
+    uint64_t hash = SNZ_HASH_SEED;
+    GLenum strs[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (int i = 0; i < 3; i++) {
+        const char* str = (const char*)glGetString(strs[i]);
+        hash = snz_hashBytes(hash, str, strlen(str));
+    }
+    _snzr_shaderCacheGlobs.driverHash = hash;
+
+    bool valid = false;
+    FILE* f = fopen(_SNZR_SHADER_CACHE_PATH, "rb");
+    if (f != NULL) {
+        fseek(f, 0, SEEK_END);
+        int64_t size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        _snzr_ShaderCacheHeader header = { 0 };
+        if (size >= (int64_t)sizeof(header) && fread(&header, sizeof(header), 1, f) == 1) {
+            valid = header.magic == _SNZR_SHADER_CACHE_MAGIC && header.driverHash == hash;
+        }
+        if (valid) {
+            uint64_t entriesSize = size - sizeof(header);
+            _snzr_shaderCacheGlobs.fileArena = snz_arenaInit(entriesSize + 16, "snzr shader cache arena");  // pushes get padded to 16
+            uint8_t* entries = SNZ_ARENA_PUSH_ARR(&_snzr_shaderCacheGlobs.fileArena, entriesSize, uint8_t);
+            _snzr_shaderCacheGlobs.entriesSize = fread(entries, 1, entriesSize, f);
+            _snzr_shaderCacheGlobs.entries = entries;
+        }
+        fclose(f);
+    }
+
+    if (!valid) {
+        f = fopen(_SNZR_SHADER_CACHE_PATH, "wb");
+        if (f != NULL) {
+            _snzr_ShaderCacheHeader header = { .magic = _SNZR_SHADER_CACHE_MAGIC, .driverHash = hash };
+            fwrite(&header, sizeof(header), 1, f);
+            fclose(f);
+        }
+    }
+    SNZ_LOGF("Shader cache has %llu bytes of binaries.", _snzr_shaderCacheGlobs.entriesSize);
+}
+
+// remembers binary as the newest for its key, so compacting keeps it. Takes ownership of it when owned.
+static void _snzr_shaderCacheKeep(_snzr_ShaderCacheEntryHeader header, const uint8_t* binary, bool owned) {
+    _snzr_ShaderCacheKept* kept = NULL;
+    for (int64_t i = 0; i < _snzr_shaderCacheGlobs.keptCount; i++) {
+        if (_snzr_shaderCacheGlobs.kept[i].header.key == header.key) {
+            kept = &_snzr_shaderCacheGlobs.kept[i];
+            break;
+        }
+    }
+    if (kept) {
+        if (kept->owned) {
+            free((void*)kept->binary);
+        }
+    } else if (_snzr_shaderCacheGlobs.keptCount < _SNZR_SHADER_CACHE_MAX_KEPT) {
+        kept = &_snzr_shaderCacheGlobs.kept[_snzr_shaderCacheGlobs.keptCount++];
+    } else {
+        if (owned) {
+            free((void*)binary);
+        }
+        return;
+    }
+    *kept = (_snzr_ShaderCacheKept){ .header = header, .binary = binary, .owned = owned };
+}
+
+// zero if there's no cached binary or the driver rejected it, in which case the caller should compile
+static uint32_t _snzr_shaderCacheLoad(uint64_t key) {
+    if (!_snzr_shaderCacheGlobs.enabled) {
+        return 0;
+    }
+
+    // last match wins, a binary that got rejected and rebuilt is appended again
+    _snzr_ShaderCacheEntryHeader found = { 0 };
+    const uint8_t* foundBinary = NULL;
+    uint64_t offset = 0;
+    while (offset + sizeof(_snzr_ShaderCacheEntryHeader) <= _snzr_shaderCacheGlobs.entriesSize) {
+        _snzr_ShaderCacheEntryHeader entry = { 0 };
+        memcpy(&entry, &_snzr_shaderCacheGlobs.entries[offset], sizeof(entry));
+        offset += sizeof(entry);
+        if (offset + entry.length > _snzr_shaderCacheGlobs.entriesSize) {
+            break;  // truncated write from a crash, ignore the rest
+        }
+        if (entry.key == key) {
+            found = entry;
+            foundBinary = &_snzr_shaderCacheGlobs.entries[offset];
+        }
+        offset += entry.length;
+    }
+    if (foundBinary == NULL) {
+        return 0;
+    }
+
+    // unknown formats are an error instead of a failed link, so they get checked for first
+    bool knownFormat = false;
+    for (int64_t i = 0; i < _snzr_shaderCacheGlobs.formatCount; i++) {
+        knownFormat |= (uint32_t)_snzr_shaderCacheGlobs.formats[i] == found.format;
+    }
+    if (!knownFormat) {
+        SNZ_LOG("Cached shader binary is in a format the driver doesn't take, compiling instead.");
+        _snzr_shaderCacheGlobs.stale = true;
+        return 0;
+    }
+
+    uint32_t id = glCreateProgram();
+    snzr_callGLFnOrError(glProgramBinary(id, found.format, foundBinary, found.length));
+    int linked = false;
+    glGetProgramiv(id, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        SNZ_LOG("Driver rejected a cached shader binary, compiling instead.");
+        glDeleteProgram(id);
+        _snzr_shaderCacheGlobs.stale = true;
+        return 0;
+    }
+    _snzr_shaderCacheKeep(found, foundBinary, false);
+    return id;
+}
+
+static void _snzr_shaderCacheStore(uint64_t key, uint32_t id) {
+    if (!_snzr_shaderCacheGlobs.enabled) {
+        return;
+    }
+
+    int length = 0;
+    snzr_callGLFnOrError(glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0) {
+        return;
+    }
+    uint8_t* binary = malloc(length);
+    SNZ_ASSERT(binary, "allocating shader binary failed.");
+    GLenum format = 0;
+    snzr_callGLFnOrError(glGetProgramBinary(id, length, NULL, &format, binary));
+    _snzr_ShaderCacheEntryHeader entry = { .key = key, .format = format, .length = length };
+    _snzr_shaderCacheKeep(entry, binary, true);
+    _snzr_shaderCacheGlobs.stale = true;  // whatever was cached for this key's old sources, if they were edited
+
+    FILE* f = fopen(_SNZR_SHADER_CACHE_PATH, "ab");
+    if (f == NULL) {
+        return;  // not being able to cache shouldn't stop anything
+    }
+    fwrite(&entry, sizeof(entry), 1, f);
+    fwrite(binary, 1, length, f);
+    fclose(f);
+}
+
+// compacts the file if it has gone stale, see _snzr_shaderCacheGlobs, and frees everything the cache holds
+static void _snzr_shaderCacheDeinit() {
+    if (_snzr_shaderCacheGlobs.stale) {
+        // written to the side and moved over so a crash partway through doesn't cost the whole cache
+        FILE* f = fopen(_SNZR_SHADER_CACHE_TEMP_PATH, "wb");
+        if (f != NULL) {
+            _snzr_ShaderCacheHeader header = { .magic = _SNZR_SHADER_CACHE_MAGIC, .driverHash = _snzr_shaderCacheGlobs.driverHash };
+            bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+            for (int64_t i = 0; i < _snzr_shaderCacheGlobs.keptCount; i++) {
+                const _snzr_ShaderCacheKept* kept = &_snzr_shaderCacheGlobs.kept[i];
+                ok = ok && fwrite(&kept->header, sizeof(kept->header), 1, f) == 1;
+                ok = ok && fwrite(kept->binary, 1, kept->header.length, f) == kept->header.length;
+            }
+            ok = fclose(f) == 0 && ok;
+            if (ok) {
+                remove(_SNZR_SHADER_CACHE_PATH);  // windows won't rename over a file
+                ok = rename(_SNZR_SHADER_CACHE_TEMP_PATH, _SNZR_SHADER_CACHE_PATH) == 0;
+            }
+            if (!ok) {
+                remove(_SNZR_SHADER_CACHE_TEMP_PATH);
+            }
+        }
+    }
+
+    for (int64_t i = 0; i < _snzr_shaderCacheGlobs.keptCount; i++) {
+        if (_snzr_shaderCacheGlobs.kept[i].owned) {
+            free((void*)_snzr_shaderCacheGlobs.kept[i].binary);
+        }
+    }
+    snz_arenaDeinit(&_snzr_shaderCacheGlobs.fileArena);
+    memset(&_snzr_shaderCacheGlobs, 0, sizeof(_snzr_shaderCacheGlobs));
+}
+
+// the binary's length is the closest thing to a size gl will give
+// drivers without any binary formats (the cache is off then) don't have one, and those are tracked as 0
+static void _snzr_shaderTrack(uint32_t id) {
+    int length = 0;
+    if (_snzr_shaderCacheGlobs.enabled) {
+        snzr_callGLFnOrError(glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length));
+    }
+    snzr_resourceTrack(SNZR_RK_PROGRAM, id, SNZ_MAX(length, 0));
+}
+
+// returns the openGL id of the shader, free with snzr_resourceRelease(SNZR_RK_PROGRAM, id)
+// reuses a linked binary from a previous run when the sources and driver match, see _snzr_shaderCacheInit
 uint32_t snzr_shaderInit(const char* vertChars, const char* fragChars, snz_Arena* scratch) {
+    uint64_t key = snz_hashBytes(_snzr_shaderCacheGlobs.driverHash, vertChars, strlen(vertChars) + 1);
+    key = snz_hashBytes(key, fragChars, strlen(fragChars) + 1);
+    uint32_t id = _snzr_shaderCacheLoad(key);
+    if (id) {
+        _snzr_shaderTrack(id);
+        return id;
+    }
+
     uint32_t vert = _snzr_loadShaderStep(vertChars, GL_VERTEX_SHADER, scratch);
     uint32_t frag = _snzr_loadShaderStep(fragChars, GL_FRAGMENT_SHADER, scratch);
-    uint32_t id = glCreateProgram();
+    id = glCreateProgram();
     snzr_callGLFnOrError(glAttachShader(id, vert));
     snzr_callGLFnOrError(glAttachShader(id, frag));
+    snzr_callGLFnOrError(glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
     snzr_callGLFnOrError(glLinkProgram(id));
+
+    int linked = false;
+    glGetProgramiv(id, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        int logLength = 0;
+        glGetProgramiv(id, GL_INFO_LOG_LENGTH, &logLength);
+        char* logBuffer = SNZ_ARENA_PUSH_ARR(scratch, logLength + 1, char);
+        glGetProgramInfoLog(id, logLength + 1, NULL, logBuffer);
+        SNZ_ASSERTF(false, "Linking shader failed: %s.", logBuffer);
+    }
     snzr_callGLFnOrError(glValidateProgram(id));
+
+    snzr_callGLFnOrError(glDetachShader(id, vert));
+    snzr_callGLFnOrError(glDetachShader(id, frag));
+    snzr_callGLFnOrError(glDeleteShader(vert));
+    snzr_callGLFnOrError(glDeleteShader(frag));
+
+    _snzr_shaderCacheStore(key, id);
+    _snzr_shaderTrack(id);
     return id;
 }
 
-// data does not need to be kept alive after this call
-// may be null to indicate undefined contents
-snzr_Texture snzr_textureInitRBGA(int32_t width, int32_t height, uint8_t* data) {
-    snzr_Texture out = { .width = width, .height = height };
+#define _SNZR_SHADER_PERMUTATION_MAX_FEATURES 4
+#define _SNZR_SHADER_PERMUTATION_COUNT (1 << _SNZR_SHADER_PERMUTATION_MAX_FEATURES)
+
+// one shader source compiled into variants, selected by a key where each bit #defines a feature
+// sources shouldn't have a #version line, it goes before the defines
+typedef struct {
+    const char* name;  // just for logs
+    const char* version;
+    const char* vertSrc;
+    const char* fragSrc;
+    const char* featureDefines[_SNZR_SHADER_PERMUTATION_MAX_FEATURES];
+    uint32_t ids[_SNZR_SHADER_PERMUTATION_COUNT];  // zero until first used
+} snzr_ShaderPermutations;
+
+// compiles the variant the first time it's asked for, and returns the cached one after that
+uint32_t snzr_shaderPermutationGet(snzr_ShaderPermutations* perms, uint32_t key, snz_Arena* scratch) {
+    SNZ_ASSERTF(key < _SNZR_SHADER_PERMUTATION_COUNT, "shader permutation key %u out of range.", key);
+    if (perms->ids[key]) {
+        return perms->ids[key];
+    }
+
+    const char* defines = "";
+    for (int i = 0; i < _SNZR_SHADER_PERMUTATION_MAX_FEATURES; i++) {
+        if (key & (1 << i)) {
+            SNZ_ASSERTF(perms->featureDefines[i] != NULL, "shader permutation '%s' has no feature %d.", perms->name, i);
+            defines = snz_arenaFormatStr(scratch, "%s#define %s\n", defines, perms->featureDefines[i]);
+        }
+    }
+    const char* vert = snz_arenaFormatStr(scratch, "%s\n%s%s", perms->version, defines, perms->vertSrc);
+    const char* frag = snz_arenaFormatStr(scratch, "%s\n%s%s", perms->version, defines, perms->fragSrc);
+    SNZ_LOGF("loading permutation %u of the %s shader.", key, perms->name);
+    perms->ids[key] = snzr_shaderInit(vert, frag, scratch);
+    return perms->ids[key];
+}
+
+// releases every variant that got compiled, the sources stay as they were
+void snzr_shaderPermutationsDeinit(snzr_ShaderPermutations* perms) {
+    for (int64_t i = 0; i < _SNZR_SHADER_PERMUTATION_COUNT; i++) {
+        snzr_resourceRelease(SNZR_RK_PROGRAM, perms->ids[i]);
+        perms->ids[i] = 0;
+    }
+}
+
+// maxLevel is the last mip level that will be sampled, -1 for the full chain. Ignored unless filter is trilinear.
+static snzr_Texture _snzr_textureInit(int32_t width, int32_t height, uint8_t* data, GLenum internalFormat, GLenum format, snzr_TextureFilter filter, int32_t maxLevel) {
+    snzr_Texture out = { .width = width, .height = height, .filter = filter };
+    GLenum minFilter = GL_LINEAR;
+    GLenum magFilter = GL_LINEAR;
+    if (filter == SNZR_TF_NEAREST) {
+        minFilter = GL_NEAREST;
+        magFilter = GL_NEAREST;
+    } else if (filter == SNZR_TF_TRILINEAR) {
+        minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    }
+    if (filter != SNZR_TF_TRILINEAR) {
+        maxLevel = 0;
+    }
+
     snzr_callGLFnOrError(glGenTextures(1, &out.glId));
     snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, out.glId));
-    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter));
+    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter));
     snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
     snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-    snzr_callGLFnOrError(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data));
+    if (maxLevel >= 0) {
+        snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel));
+    }
+    snzr_callGLFnOrError(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data));
+    if (data != NULL && filter == SNZR_TF_TRILINEAR) {
+        snzr_callGLFnOrError(glGenerateMipmap(GL_TEXTURE_2D));
+    }
+
+    uint64_t bytes = (uint64_t)width * height * (internalFormat == GL_R8 ? 1 : 4);
+    if (filter == SNZR_TF_TRILINEAR && maxLevel != 0) {
+        bytes = bytes * 4 / 3;  // close enough for a chain of any length
+    }
+    snzr_resourceTrack(SNZR_RK_TEXTURE, out.glId, bytes);
     return out;
 }
 
+// rebuilds every mip level from level 0, for after level 0 has been drawn to or uploaded in pieces
+// does nothing for textures without mips
+void snzr_textureGenMips(snzr_Texture tex) {
+    if (tex.filter != SNZR_TF_TRILINEAR) {
+        return;
+    }
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, tex.glId));
+    snzr_callGLFnOrError(glGenerateMipmap(GL_TEXTURE_2D));
+}
+
+void snzr_textureDeinit(snzr_Texture* tex) {
+    snzr_resourceRelease(SNZR_RK_TEXTURE, tex->glId);
+    memset(tex, 0, sizeof(*tex));
+}
+
 // data does not need to be kept alive after this call
-snzr_Texture snzr_textureInitGrayscale(int32_t width, int32_t height, uint8_t* data) {
-    snzr_Texture out = { .width = width, .height = height };
-    snzr_callGLFnOrError(glGenTextures(1, &out.glId));
-    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, out.glId));
-    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-    snzr_callGLFnOrError(glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, data));
-    return out;
+// may be null to indicate undefined contents, in which case mips aren't built until snzr_textureGenMips
+snzr_Texture snzr_textureInitRBGAFiltered(int32_t width, int32_t height, uint8_t* data, snzr_TextureFilter filter, int32_t maxLevel) {
+    return _snzr_textureInit(width, height, data, GL_RGBA8, GL_RGBA, filter, maxLevel);
+}
+
+// data does not need to be kept alive after this call
+// may be null to indicate undefined contents
+snzr_Texture snzr_textureInitRBGA(int32_t width, int32_t height, uint8_t* data) {
+    return snzr_textureInitRBGAFiltered(width, height, data, SNZR_TF_LINEAR, 0);
 }
 
-// FIXME: there is no method of freeing gl resources built in, that is bad
+// data does not need to be kept alive after this call
+snzr_Texture snzr_textureInitGrayscaleFiltered(int32_t width, int32_t height, uint8_t* data, snzr_TextureFilter filter, int32_t maxLevel) {
+    return _snzr_textureInit(width, height, data, GL_R8, GL_RED, filter, maxLevel);
+}
+
+// data does not need to be kept alive after this call
+snzr_Texture snzr_textureInitGrayscale(int32_t width, int32_t height, uint8_t* data) {
+    return snzr_textureInitGrayscaleFiltered(width, height, data, SNZR_TF_LINEAR, 0);
+}
 
+// part of a texture, for images that were packed into an atlas. Gl uvs, 00 is the bottom left
 typedef struct {
-    uint32_t glId;
-    uint32_t depthBufferId;
     snzr_Texture texture;
-} snzr_FrameBuffer;
+    HMM_Vec2 uvStart;
+    HMM_Vec2 uvEnd;
+} snzr_TextureRegion;
 
-// returns the GLID for a new framebuffer, attacted to tex, and with size of tex + a depth buffer
-snzr_FrameBuffer snzr_frameBufferInit(snzr_Texture tex) {
-    snzr_FrameBuffer out = (snzr_FrameBuffer){
-        .depthBufferId = 0,
-        .glId = 0,
+snzr_TextureRegion snzr_textureRegionWhole(snzr_Texture texture) {
+    return (snzr_TextureRegion){ .texture = texture, .uvStart = HMM_V2(0, 0), .uvEnd = HMM_V2(1, 1) };
+}
+
+// Packs small RGBA images into big shared pages, so that things drawing lots of them (icon lists)
+// sample from one texture and batch together instead of binding a texture per image.
+// Shelf packing: images go left to right along horizontal shelves, each page is a stack of shelves.
+// A new image goes on the shelf that wastes the least height, or opens a new shelf on top.
+// Pages are made when the last one is full, and there is no freeing, images live as long as the allocator.
+// Pages only have the first few mips, images are aligned and spaced to a texel of the
+// smallest one so that shrinking them down never blends neighbours together.
+#define _SNZR_ATLAS_MAX_PAGES 8
+#define _SNZR_ATLAS_MAX_SHELVES 128
+#define _SNZR_ATLAS_MAX_MIP 3
+#define _SNZR_ATLAS_ALIGN (1 << _SNZR_ATLAS_MAX_MIP)  // images start on multiples of this, with at least this many empty texels between
+
+typedef struct {
+    int32_t y;
+    int32_t height;
+    int32_t usedWidth;
+} _snzr_AtlasShelf;
+
+typedef struct {
+    snzr_Texture texture;
+    _snzr_AtlasShelf shelves[_SNZR_ATLAS_MAX_SHELVES];
+    int64_t shelfCount;
+    int32_t usedHeight;
+} _snzr_AtlasPage;
+
+typedef struct {
+    int32_t pageSize;
+    int32_t maxImageSize;  // images bigger than this on either side should get their own textures
+    _snzr_AtlasPage pages[_SNZR_ATLAS_MAX_PAGES];
+    int64_t pageCount;
+    const char* owner;  // of the pages
+} snzr_AtlasAllocator;
+
+// pages are pageSize square, and only get made once something is allocated
+snzr_AtlasAllocator snzr_atlasAllocatorInit(int32_t pageSize, int32_t maxImageSize) {
+    SNZ_ASSERT(maxImageSize + 2 * _SNZR_ATLAS_ALIGN <= pageSize, "atlas images can't be bigger than the pages.");
+    return (snzr_AtlasAllocator){
+        .pageSize = pageSize,
+        .maxImageSize = maxImageSize,
+        .owner = _snzr_resourceOwner(),
+    };
+}
+
+// picks the shelf on page that wastes the least height on a w x h image, opening a new one if none fit
+// returns false when the page is full
+static bool _snzr_atlasPageAlloc(_snzr_AtlasPage* page, int32_t pageSize, int32_t w, int32_t h, int32_t* outX, int32_t* outY) {
+    _snzr_AtlasShelf* best = NULL;
+    for (int64_t i = 0; i < page->shelfCount; i++) {
+        _snzr_AtlasShelf* shelf = &page->shelves[i];
+        if (shelf->height < h || shelf->usedWidth + w > pageSize) {
+            continue;
+        }
+        if (!best || shelf->height < best->height) {
+            best = shelf;
+        }
+    }
+
+    // a shelf more than twice as tall as the image wastes more than a new one would
+    if ((!best || best->height > h * 2) && page->usedHeight + h <= pageSize && page->shelfCount < _SNZR_ATLAS_MAX_SHELVES) {
+        best = &page->shelves[page->shelfCount++];
+        *best = (_snzr_AtlasShelf){ .y = page->usedHeight, .height = h };
+        page->usedHeight += h;
+    }
+
+    if (!best) {
+        return false;
+    }
+    *outX = best->usedWidth;
+    *outY = best->y;
+    best->usedWidth += w;
+    return true;
+}
+
+// reserves space for a width x height image without uploading anything, see snzr_atlasAdd.
+// outX and outY are where the image goes in outRegion.texture, in texels from the bottom left.
+// returns false if the image is bigger than maxImageSize or every page is full.
+bool snzr_atlasAlloc(snzr_AtlasAllocator* a, int32_t width, int32_t height, snzr_TextureRegion* outRegion, int32_t* outX, int32_t* outY) {
+    if (width > a->maxImageSize || height > a->maxImageSize) {
+        return false;
+    }
+    int32_t w = (width + 2 * _SNZR_ATLAS_ALIGN - 1) / _SNZR_ATLAS_ALIGN * _SNZR_ATLAS_ALIGN;
+    int32_t h = (height + 2 * _SNZR_ATLAS_ALIGN - 1) / _SNZR_ATLAS_ALIGN * _SNZR_ATLAS_ALIGN;
+
+    _snzr_AtlasPage* page = NULL;
+    int32_t x = 0;
+    int32_t y = 0;
+    for (int64_t i = 0; i < a->pageCount; i++) {
+        if (_snzr_atlasPageAlloc(&a->pages[i], a->pageSize, w, h, &x, &y)) {
+            page = &a->pages[i];
+            break;
+        }
+    }
+    if (!page) {
+        if (a->pageCount >= _SNZR_ATLAS_MAX_PAGES) {
+            return false;
+        }
+        page = &a->pages[a->pageCount++];
+        memset(page, 0, sizeof(*page));
+        // zeroed so that the space between images is transparent
+        uint8_t* clear = calloc((uint64_t)a->pageSize * a->pageSize, 4);
+        SNZ_ASSERT(clear, "allocating atlas page failed.");
+        const char* prevOwner = snzr_resourceOwnerSet(a->owner);
+        page->texture = snzr_textureInitRBGAFiltered(a->pageSize, a->pageSize, clear, SNZR_TF_TRILINEAR, _SNZR_ATLAS_MAX_MIP);
+        snzr_resourceOwnerSet(prevOwner);
+        free(clear);
+        SNZ_LOGF("Atlas page %lld made, %dx%d.", a->pageCount - 1, a->pageSize, a->pageSize);
+        bool fit = _snzr_atlasPageAlloc(page, a->pageSize, w, h, &x, &y);
+        SNZ_ASSERT(fit, "image didn't fit in an empty atlas page.");
+    }
+
+    // uvs are inset by half a texel so that the full size level never blends in the empty space
+    float size = (float)a->pageSize;
+    *outRegion = (snzr_TextureRegion){
+        .texture = page->texture,
+        .uvStart = HMM_V2((x + 0.5f) / size, (y + 0.5f) / size),
+        .uvEnd = HMM_V2((x + width - 0.5f) / size, (y + height - 0.5f) / size),
+    };
+    *outX = x;
+    *outY = y;
+    return true;
+}
+
+// packs an RGBA8 image into the atlas, pixels don't need to be kept alive after this call.
+// rebuilds the mips of the whole page, so add things at load time and not every frame.
+// returns false without touching outRegion if it doesn't go in the atlas, see snzr_atlasAlloc.
+bool snzr_atlasAdd(snzr_AtlasAllocator* a, int32_t width, int32_t height, const uint8_t* pixels, snzr_TextureRegion* outRegion) {
+    int32_t x = 0;
+    int32_t y = 0;
+    snzr_TextureRegion region = { 0 };
+    if (!snzr_atlasAlloc(a, width, height, &region, &x, &y)) {
+        return false;
+    }
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, region.texture.glId));
+    snzr_callGLFnOrError(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    snzr_textureGenMips(region.texture);
+    *outRegion = region;
+    return true;
+}
+
+void snzr_atlasAllocatorDeinit(snzr_AtlasAllocator* a) {
+    for (int64_t i = 0; i < a->pageCount; i++) {
+        snzr_textureDeinit(&a->pages[i].texture);
+    }
+    memset(a, 0, sizeof(*a));
+}
+
+// decoding runs on a worker thread, should return RGBA8 pixels (or null on failure) and write out the size
+typedef uint8_t* (*snzr_DecodeFunc)(const char* path, int32_t* outWidth, int32_t* outHeight);
+// frees whatever the paired decode func returned
+typedef void (*snzr_DecodedFreeFunc)(uint8_t* pixels);
+
+typedef enum {
+    _SNZR_TLS_EMPTY,
+    _SNZR_TLS_DECODING,
+    _SNZR_TLS_DECODED,
+    _SNZR_TLS_UPLOADING,
+    _SNZR_TLS_RESIDENT,
+    _SNZR_TLS_FAILED,
+} _snzr_TextureLoadState;
+
+typedef struct {
+    snzr_TextureRegion region;  // what gets handed out, placeholder until resident
+    SDL_atomic_t state;    // a _snzr_TextureLoadState
+
+    char path[260];
+    snzr_TextureFilter filter;
+    snzr_DecodeFunc decode;
+    snzr_DecodedFreeFunc decodedFree;
+    snzr_AtlasAllocator* atlas;  // may be null
+    const char* owner;
+
+    // written by the worker before state flips to DECODED
+    uint8_t* pixels;
+    int32_t width;
+    int32_t height;
+
+    // upload progress, main thread only
+    snzr_TextureRegion staging;
+    bool inAtlas;  // then the atlas owns the texture
+    int32_t stagingX;  // where in staging the image goes, non zero when it's in an atlas page
+    int32_t stagingY;
+    int32_t rowsUploaded;
+} _snzr_TextureLoad;
+
+#define _SNZR_TEXTURE_LOADER_MAX 1024
+#define _SNZR_TEXTURE_LOADER_PBO_COUNT 3
+#define _SNZR_TEXTURE_LOADER_CHUNK_BYTES (1024 * 1024)
+
+struct {
+    _snzr_TextureLoad loads[_SNZR_TEXTURE_LOADER_MAX];
+    int64_t loadCount;
+
+    uint32_t pboIds[_SNZR_TEXTURE_LOADER_PBO_COUNT];
+    int64_t nextPbo;
+    float uploadBudgetMs;
+} _snzr_textureLoaderGlobs;
+
+static void _snzr_textureLoadJob(void* userData) {
+    _snzr_TextureLoad* load = (_snzr_TextureLoad*)userData;
+    load->pixels = load->decode(load->path, &load->width, &load->height);
+    SDL_AtomicSet(&load->state, load->pixels ? _SNZR_TLS_DECODED : _SNZR_TLS_FAILED);
+}
+
+// ms of upload work to allow per frame, defaults to 2
+void snzr_textureLoaderSetBudget(float ms) {
+    _snzr_textureLoaderGlobs.uploadBudgetMs = ms;
+}
+
+// queues a decode on a worker thread and returns a handle that is a 1x1 placeholder until
+// the image is uploaded, at which point the pointed to texture is swapped to the real one.
+// Read through the pointer every frame instead of copying it out once.
+// path is copied. Requires snz_jobsInit to have been called.
+// trilinear textures get their mips built once all of level 0 is uploaded.
+// atlas may be null, otherwise images small enough for it get packed into it instead of
+// getting their own textures (filter is ignored for those, see snzr_AtlasAllocator).
+// The atlas has to outlive the load.
+const snzr_TextureRegion* snzr_textureLoadAsync(const char* path, snzr_TextureFilter filter, snzr_DecodeFunc decode, snzr_DecodedFreeFunc decodedFree, snzr_AtlasAllocator* atlas) {
+    SNZ_ASSERT(_snzr_textureLoaderGlobs.loadCount < _SNZR_TEXTURE_LOADER_MAX, "async texture load failed, out of load slots.");
+    SNZ_ASSERTF(strlen(path) < sizeof(((_snzr_TextureLoad*)0)->path), "async texture load failed, path too long: '%s'", path);
+
+    _snzr_TextureLoad* load = &_snzr_textureLoaderGlobs.loads[_snzr_textureLoaderGlobs.loadCount];
+    _snzr_textureLoaderGlobs.loadCount++;
+    memset(load, 0, sizeof(*load));
+
+    strcpy(load->path, path);
+    load->filter = filter;
+    load->decode = decode;
+    load->decodedFree = decodedFree;
+    load->atlas = atlas;
+    load->owner = _snzr_resourceOwner();
+    load->region = snzr_textureRegionWhole(_snzr_globs.placeholderTex);
+    SDL_AtomicSet(&load->state, _SNZR_TLS_DECODING);
+    snz_jobPush(_snzr_textureLoadJob, load);
+    return &load->region;
+}
+
+// uploads the next ~chunk of rows into the staging texture through the PBO ring
+// FIXME: unsynchronized maps of a ring would avoid the orphaning, but this is simple and doesn't stall
+static void _snzr_textureLoadUploadChunk(_snzr_TextureLoad* load) {
+    int64_t rowBytes = (int64_t)load->width * 4;
+    int64_t rowCount = SNZ_MAX(_SNZR_TEXTURE_LOADER_CHUNK_BYTES / rowBytes, 1);
+    rowCount = SNZ_MIN(rowCount, load->height - load->rowsUploaded);
+    int64_t byteCount = rowCount * rowBytes;
+
+    uint32_t pbo = _snzr_textureLoaderGlobs.pboIds[_snzr_textureLoaderGlobs.nextPbo];
+    _snzr_textureLoaderGlobs.nextPbo = (_snzr_textureLoaderGlobs.nextPbo + 1) % _SNZR_TEXTURE_LOADER_PBO_COUNT;
+
+    snzr_callGLFnOrError(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo));
+    snzr_callGLFnOrError(glBufferData(GL_PIXEL_UNPACK_BUFFER, byteCount, NULL, GL_STREAM_DRAW));  // orphan so we never wait on the last upload
+    snzr_resourceSetBytes(SNZR_RK_BUFFER, pbo, byteCount);
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, byteCount, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    SNZ_ASSERT(dst != NULL, "mapping texture upload buffer failed.");
+    memcpy(dst, load->pixels + load->rowsUploaded * rowBytes, byteCount);
+    snzr_callGLFnOrError(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, load->staging.texture.glId));
+    snzr_callGLFnOrError(glTexSubImage2D(GL_TEXTURE_2D, 0, load->stagingX, load->stagingY + load->rowsUploaded, load->width, rowCount, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+    snzr_callGLFnOrError(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    load->rowsUploaded += rowCount;
+}
+
+// called once per frame by snz_main, uploads decoded images until the time budget runs out
+static void _snzr_textureLoaderUpdate() {
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    uint64_t budgetTicks = (uint64_t)(_snzr_textureLoaderGlobs.uploadBudgetMs / 1000.0 * SDL_GetPerformanceFrequency());
+
+    for (int64_t i = 0; i < _snzr_textureLoaderGlobs.loadCount; i++) {
+        _snzr_TextureLoad* load = &_snzr_textureLoaderGlobs.loads[i];
+        int state = SDL_AtomicGet(&load->state);
+        if (state == _SNZR_TLS_FAILED) {
+            SNZ_ASSERTF(false, "decoding texture '%s' failed.", load->path);
+        } else if (state == _SNZR_TLS_DECODED) {
+            load->stagingX = 0;
+            load->stagingY = 0;
+            load->inAtlas = load->atlas && snzr_atlasAlloc(load->atlas, load->width, load->height, &load->staging, &load->stagingX, &load->stagingY);
+            if (!load->inAtlas) {
+                const char* prevOwner = snzr_resourceOwnerSet(load->owner);
+                load->staging = snzr_textureRegionWhole(snzr_textureInitRBGAFiltered(load->width, load->height, NULL, load->filter, -1));
+                snzr_resourceOwnerSet(prevOwner);
+            }
+            load->rowsUploaded = 0;
+            SDL_AtomicSet(&load->state, _SNZR_TLS_UPLOADING);
+            state = _SNZR_TLS_UPLOADING;
+        }
+
+        if (state != _SNZR_TLS_UPLOADING) {
+            continue;
+        }
+
+        while (load->rowsUploaded < load->height) {
+            if (SDL_GetPerformanceCounter() - startTicks > budgetTicks) {
+                return;
+            }
+            _snzr_textureLoadUploadChunk(load);
+        }
+
+        load->decodedFree(load->pixels);
+        load->pixels = NULL;
+        snzr_textureGenMips(load->staging.texture);  // the whole page, for atlased images
+        load->region = load->staging;  // swap in
+        SDL_AtomicSet(&load->state, _SNZR_TLS_RESIDENT);
+        SNZ_LOGF("Async texture '%s' resident.", load->path);
+    }
+}
+
+// true while anything is still decoding or uploading, snz_main won't idle while this is set
+static bool _snzr_textureLoaderBusy() {
+    for (int64_t i = 0; i < _snzr_textureLoaderGlobs.loadCount; i++) {
+        int state = SDL_AtomicGet(&_snzr_textureLoaderGlobs.loads[i].state);
+        if (state == _SNZR_TLS_DECODING || state == _SNZR_TLS_DECODED || state == _SNZR_TLS_UPLOADING) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// frees every texture that loads made for themselves, call with nothing still decoding
+static void _snzr_textureLoaderDeinit() {
+    for (int64_t i = 0; i < _snzr_textureLoaderGlobs.loadCount; i++) {
+        _snzr_TextureLoad* load = &_snzr_textureLoaderGlobs.loads[i];
+        if (load->pixels) {
+            load->decodedFree(load->pixels);
+        }
+        if (!load->inAtlas) {
+            snzr_textureDeinit(&load->staging.texture);
+        }
+        load->region = snzr_textureRegionWhole(_snzr_globs.placeholderTex);
+    }
+    _snzr_textureLoaderGlobs.loadCount = 0;
+    for (int64_t i = 0; i < _SNZR_TEXTURE_LOADER_PBO_COUNT; i++) {
+        snzr_resourceRelease(SNZR_RK_BUFFER, _snzr_textureLoaderGlobs.pboIds[i]);
+    }
+}
+
+// Virtual textures, for images too big to keep on the gpu whole (i.e. 16k planet surfaces).
+// snzr_virtualTextureBake cuts an image up into a mip chain of fixed size tiles in one file, offline or on
+// first run. At runtime only the tiles that get asked for with snzr_virtualTextureRequest are read (on
+// workers) and uploaded into pages of a fixed size cache texture, least recently used pages get reused.
+// An indirection texture with one texel per tile per level points every tile at the closest resident
+// one covering it, so sampling (see snzr_virtualTextureBind) always finds something, just blurrier
+// until the right level streams in. The coarsest tile is never evicted.
+// Tiles have a border copied from their neighbours so that bilinear filtering doesn't bleed between pages.
+#define _SNZR_VT_MAGIC 0x54564e53  // "SNVT"
+#define _SNZR_VT_VERSION 2
+#define _SNZR_VT_TILE_SIZE 128
+#define _SNZR_VT_BORDER 2
+#define _SNZR_VT_PAGE_SIZE (_SNZR_VT_TILE_SIZE + 2 * _SNZR_VT_BORDER)
+#define _SNZR_VT_PAGE_BYTES (_SNZR_VT_PAGE_SIZE * _SNZR_VT_PAGE_SIZE * 4)
+#define _SNZR_VT_MAX_LEVELS 16
+#define _SNZR_VT_MAX_LOADS 32           // tiles being read at once
+#define _SNZR_VT_UPLOADS_PER_FRAME 8    // each is a _SNZR_VT_PAGE_BYTES glTexSubImage2D
+#define _SNZR_VT_TEXTURE_UNIT 2         // and the one after, nothing else in snooze binds these
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;  // of level 0, in texels
+    uint32_t height;
+    uint32_t tileSize;
+    uint32_t border;
+    uint32_t levelCount;
+    uint32_t unused;
+    uint64_t sourceSize;  // of the image file it was baked from, with its modified time, to tell when it changed
+    int64_t sourceModified;
+} _snzr_VtHeader;  // followed by every tile, level 0 first, rows of tiles top down, _SNZR_VT_PAGE_BYTES each
+
+typedef enum {
+    _SNZR_VTS_ABSENT,
+    _SNZR_VTS_LOADING,
+    _SNZR_VTS_RESIDENT,
+    _SNZR_VTS_FAILED,  // couldn't be read, never asked for again. Its ancestors show instead
+} _snzr_VtTileState;
+
+typedef enum {
+    _SNZR_VTL_FREE,
+    _SNZR_VTL_READING,
+    _SNZR_VTL_READ,
+    _SNZR_VTL_FAILED,
+} _snzr_VtLoadState;
+
+typedef struct {
+    SDL_atomic_t state;  // a _snzr_VtLoadState
+    const char* path;
+    int64_t tile;
+    uint8_t* pixels;  // _SNZR_VT_PAGE_BYTES, written by the worker before state flips to READ
+} _snzr_VtLoad;
+
+typedef struct {
+    int64_t tile;  // -1 when empty
+    uint64_t lastUsedFrame;
+} _snzr_VtPage;
+
+typedef struct {
+    uint64_t requested;  // in the frame
+    uint64_t resident;
+    uint64_t loading;
+    uint64_t uploaded;  // lifetime totals from here down
+    uint64_t evicted;
+    uint64_t failed;  // tiles that couldn't be read
+} snzr_VirtualTextureStats;
+
+typedef struct {
+    const char* path;  // copied into the arena
+    uint32_t width;
+    uint32_t height;
+    uint32_t tileSize;  // texels on a side, not counting the border
+    int64_t levelCount;
+    int64_t levelTilesX[_SNZR_VT_MAX_LEVELS];
+    int64_t levelTilesY[_SNZR_VT_MAX_LEVELS];
+    int64_t levelFirstTile[_SNZR_VT_MAX_LEVELS];  // index of the levels first tile in every per tile array
+    int64_t tileCount;
+
+    uint8_t* tileStates;  // _snzr_VtTileState per tile
+    int32_t* tilePages;   // -1 unless resident
+    uint8_t* indirection;  // RGBA per tile, same layout as the texture's levels: page x, page y, level, 255 (0 if nothing)
+    bool indirectionDirty;
+
+    int64_t pagesPerSide;
+    _snzr_VtPage* pages;
+    _snzr_VtLoad* loads;  // _SNZR_VT_MAX_LOADS
+    snz_JobGroup* loadGroup;
+    uint64_t frameIdx;
+    uint64_t requestCount;  // so far this frame
+
+    snzr_Texture cache;  // pagesPerSide * _SNZR_VT_PAGE_SIZE square
+    uint32_t indirectionTexId;
+    snzr_VirtualTextureStats stats;  // as of the last snzr_virtualTextureUpdate
+} snzr_VirtualTexture;
+
+// tile counts halve per level like the indirection textures mips do, until the level is one tile
+static void _snzr_vtLevelsInit(snzr_VirtualTexture* vt) {
+    int64_t tilesX = vt->width / _SNZR_VT_TILE_SIZE;
+    int64_t tilesY = vt->height / _SNZR_VT_TILE_SIZE;
+    vt->tileSize = _SNZR_VT_TILE_SIZE;
+    vt->levelCount = 0;
+    vt->tileCount = 0;
+    while (true) {
+        SNZ_ASSERT(vt->levelCount < _SNZR_VT_MAX_LEVELS, "virtual texture has too many levels.");
+        vt->levelTilesX[vt->levelCount] = tilesX;
+        vt->levelTilesY[vt->levelCount] = tilesY;
+        vt->levelFirstTile[vt->levelCount] = vt->tileCount;
+        vt->tileCount += tilesX * tilesY;
+        vt->levelCount++;
+        if (tilesX == 1 && tilesY == 1) {
+            break;
+        }
+        tilesX = SNZ_MAX(tilesX / 2, 1);
+        tilesY = SNZ_MAX(tilesY / 2, 1);
+    }
+}
+
+static bool _snzr_isPow2(uint32_t x) {
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+// what a complete file with this header is in bytes, -1 when the header doesn't describe a layout this version makes
+static int64_t _snzr_vtFileSize(const _snzr_VtHeader* header) {
+    if (header->magic != _SNZR_VT_MAGIC || header->version != _SNZR_VT_VERSION ||
+        header->tileSize != _SNZR_VT_TILE_SIZE || header->border != _SNZR_VT_BORDER) {
+        return -1;
+    }
+    uint32_t maxSide = _SNZR_VT_TILE_SIZE << (_SNZR_VT_MAX_LEVELS - 1);
+    if (!_snzr_isPow2(header->width) || !_snzr_isPow2(header->height) || header->width < _SNZR_VT_TILE_SIZE ||
+        header->height < _SNZR_VT_TILE_SIZE || header->width > maxSide || header->height > maxSide) {
+        return -1;
+    }
+    snzr_VirtualTexture layout = { .width = header->width, .height = header->height };
+    _snzr_vtLevelsInit(&layout);
+    if (layout.levelCount != (int64_t)header->levelCount) {
+        return -1;
+    }
+    return (int64_t)sizeof(_snzr_VtHeader) + layout.tileCount * _SNZR_VT_PAGE_BYTES;
+}
+
+// false if vtPath is missing, didn't finish baking, is from an older version, or srcPath has changed since
+// (by size and modified time). Rebake with snzr_virtualTextureBake when it is.
+bool snzr_virtualTextureIsCurrent(const char* srcPath, const char* vtPath) {
+    _snz_Stat srcStat = { 0 };
+    _snz_Stat vtStat = { 0 };
+    if (_SNZ_STAT(srcPath, &srcStat) != 0 || _SNZ_STAT(vtPath, &vtStat) != 0) {
+        return false;
+    }
+    FILE* f = fopen(vtPath, "rb");
+    if (f == NULL) {
+        return false;
+    }
+    _snzr_VtHeader header = { 0 };
+    bool read = fread(&header, sizeof(header), 1, f) == 1;
+    fclose(f);
+    return read && _snzr_vtFileSize(&header) == (int64_t)vtStat.st_size &&
+           header.sourceSize == (uint64_t)srcStat.st_size && header.sourceModified == (int64_t)srcStat.st_mtime;
+}
+
+// decodes srcPath and writes every tile of every level to dstPath. Width & height of the image have to be
+// powers of two, and at least a tile (128). Asserts on failures. Holds the whole image and one mip of it
+// in memory, so for really big maps do it offline rather than at startup.
+// Written to dstPath + ".tmp" and moved over dstPath once it's done, so a bake that gets killed doesn't leave
+// something that looks finished.
+void snzr_virtualTextureBake(const char* srcPath, const char* dstPath, snzr_DecodeFunc decode, snzr_DecodedFreeFunc decodedFree) {
+    _snz_Stat srcStat = { 0 };
+    SNZ_ASSERTF(_SNZ_STAT(srcPath, &srcStat) == 0, "virtual texture source '%s' doesn't exist.", srcPath);
+    char tempPath[512];
+    int tempPathLength = snprintf(tempPath, sizeof(tempPath), "%s.tmp", dstPath);
+    SNZ_ASSERTF(tempPathLength < (int)sizeof(tempPath), "virtual texture path '%s' is too long.", dstPath);
+
+    int32_t width = 0;
+    int32_t height = 0;
+    uint8_t* src = decode(srcPath, &width, &height);
+    SNZ_ASSERTF(src != NULL, "decoding virtual texture source '%s' failed.", srcPath);
+    SNZ_ASSERTF(_snzr_isPow2(width) && _snzr_isPow2(height) && width >= _SNZR_VT_TILE_SIZE && height >= _SNZR_VT_TILE_SIZE,
+                "virtual texture source '%s' is %dx%d, sides have to be powers of two and at least %d.",
+                srcPath, width, height, _SNZR_VT_TILE_SIZE);
+
+    snzr_VirtualTexture layout = { .width = width, .height = height };
+    _snzr_vtLevelsInit(&layout);
+
+    FILE* f = fopen(tempPath, "wb");
+    SNZ_ASSERTF(f != NULL, "opening virtual texture '%s' for writing failed.", tempPath);
+    _snzr_VtHeader header = {
+        .magic = _SNZR_VT_MAGIC,
+        .version = _SNZR_VT_VERSION,
+        .width = width,
+        .height = height,
+        .tileSize = _SNZR_VT_TILE_SIZE,
+        .border = _SNZR_VT_BORDER,
+        .levelCount = layout.levelCount,
+        .sourceSize = (uint64_t)srcStat.st_size,
+        .sourceModified = (int64_t)srcStat.st_mtime,
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+    uint8_t* page = malloc(_SNZR_VT_PAGE_BYTES);
+    uint8_t* level = src;
+    int64_t levelW = width;
+    int64_t levelH = height;
+    for (int64_t l = 0; l < layout.levelCount && ok; l++) {
+        if (l > 0) {
+            // 2x2 box down, or 2x1 once one side is already a single tile wide
+            int64_t w = layout.levelTilesX[l] * _SNZR_VT_TILE_SIZE;
+            int64_t h = layout.levelTilesY[l] * _SNZR_VT_TILE_SIZE;
+            int64_t fx = levelW / w;
+            int64_t fy = levelH / h;
+            uint8_t* next = malloc(w * h * 4);
+            for (int64_t y = 0; y < h; y++) {
+                for (int64_t x = 0; x < w; x++) {
+                    for (int64_t c = 0; c < 4; c++) {
+                        uint32_t sum = 0;
+                        for (int64_t sy = 0; sy < fy; sy++) {
+                            for (int64_t sx = 0; sx < fx; sx++) {
+                                sum += level[((y * fy + sy) * levelW + x * fx + sx) * 4 + c];
+                            }
+                        }
+                        next[(y * w + x) * 4 + c] = (uint8_t)((sum + fx * fy / 2) / (fx * fy));
+                    }
+                }
+            }
+            if (level != src) {
+                free(level);
+            }
+            level = next;
+            levelW = w;
+            levelH = h;
+        }
+
+        for (int64_t ty = 0; ty < layout.levelTilesY[l] && ok; ty++) {
+            for (int64_t tx = 0; tx < layout.levelTilesX[l] && ok; tx++) {
+                for (int64_t y = 0; y < _SNZR_VT_PAGE_SIZE; y++) {
+                    int64_t srcY = ty * _SNZR_VT_TILE_SIZE + y - _SNZR_VT_BORDER;
+                    srcY = SNZ_MAX(SNZ_MIN(srcY, levelH - 1), 0);
+                    for (int64_t x = 0; x < _SNZR_VT_PAGE_SIZE; x++) {
+                        int64_t srcX = tx * _SNZR_VT_TILE_SIZE + x - _SNZR_VT_BORDER;
+                        srcX = SNZ_MAX(SNZ_MIN(srcX, levelW - 1), 0);
+                        memcpy(&page[(y * _SNZR_VT_PAGE_SIZE + x) * 4], &level[(srcY * levelW + srcX) * 4], 4);
+                    }
+                }
+                ok = fwrite(page, _SNZR_VT_PAGE_BYTES, 1, f) == 1;
+            }
+        }
+    }
+    if (level != src) {
+        free(level);
+    }
+    free(page);
+    decodedFree(src);
+    ok = (fclose(f) == 0) && ok;
+    if (ok) {
+        remove(dstPath);  // windows won't rename over a file
+        ok = rename(tempPath, dstPath) == 0;
+    }
+    if (!ok) {
+        remove(tempPath);
+    }
+    SNZ_ASSERTF(ok, "writing virtual texture '%s' failed.", dstPath);
+    SNZ_LOGF("Baked virtual texture '%s' from '%s', %lld levels, %lld tiles.", dstPath, srcPath, layout.levelCount, layout.tileCount);
+}
+
+// reads a baked file's header and sets up an empty cache of pagesPerSide^2 pages. Tables go in arena.
+// Asserts if the file is missing, was baked with a different tile layout, or is missing tiles.
+snzr_VirtualTexture snzr_virtualTextureInit(const char* path, int64_t pagesPerSide, snz_Arena* arena) {
+    _snz_Stat fileStat = { 0 };
+    SNZ_ASSERTF(_SNZ_STAT(path, &fileStat) == 0, "opening virtual texture '%s' failed.", path);
+    FILE* f = fopen(path, "rb");
+    SNZ_ASSERTF(f != NULL, "opening virtual texture '%s' failed.", path);
+    _snzr_VtHeader header = { 0 };
+    bool read = fread(&header, sizeof(header), 1, f) == 1;
+    fclose(f);
+    SNZ_ASSERTF(read && header.magic == _SNZR_VT_MAGIC && header.version == _SNZR_VT_VERSION,
+                "'%s' isn't a virtual texture, or is from an old version.", path);
+    SNZ_ASSERTF(header.tileSize == _SNZR_VT_TILE_SIZE && header.border == _SNZR_VT_BORDER,
+                "virtual texture '%s' was baked with a different tile size, rebake it.", path);
+    SNZ_ASSERT(pagesPerSide >= 2 && pagesPerSide <= 256, "virtual texture cache has to be 2x2 to 256x256 pages.");  // page coords are bytes
+
+    snzr_VirtualTexture vt = {
+        .width = header.width,
+        .height = header.height,
+        .pagesPerSide = pagesPerSide,
+    };
+    _snzr_vtLevelsInit(&vt);
+    SNZ_ASSERTF(vt.levelCount == (int64_t)header.levelCount, "virtual texture '%s' has a bad level count.", path);
+    SNZ_ASSERTF(_snzr_vtFileSize(&header) == (int64_t)fileStat.st_size,
+                "virtual texture '%s' is %lld bytes instead of %lld, it didn't finish baking. Rebake it.",
+                path, (int64_t)fileStat.st_size, _snzr_vtFileSize(&header));
+
+    char* pathCopy = SNZ_ARENA_PUSH_ARR(arena, strlen(path) + 1, char);
+    strcpy(pathCopy, path);
+    vt.path = pathCopy;
+
+    vt.tileStates = SNZ_ARENA_PUSH_ARR(arena, vt.tileCount, uint8_t);
+    memset(vt.tileStates, _SNZR_VTS_ABSENT, vt.tileCount);
+    vt.tilePages = SNZ_ARENA_PUSH_ARR(arena, vt.tileCount, int32_t);
+    for (int64_t i = 0; i < vt.tileCount; i++) {
+        vt.tilePages[i] = -1;
+    }
+    vt.indirection = SNZ_ARENA_PUSH_ARR(arena, vt.tileCount * 4, uint8_t);
+    memset(vt.indirection, 0, vt.tileCount * 4);
+
+    vt.pages = SNZ_ARENA_PUSH_ARR(arena, pagesPerSide * pagesPerSide, _snzr_VtPage);
+    for (int64_t i = 0; i < pagesPerSide * pagesPerSide; i++) {
+        vt.pages[i] = (_snzr_VtPage){ .tile = -1 };
+    }
+    vt.loads = SNZ_ARENA_PUSH_ARR(arena, _SNZR_VT_MAX_LOADS, _snzr_VtLoad);
+    memset(vt.loads, 0, sizeof(*vt.loads) * _SNZR_VT_MAX_LOADS);
+    for (int64_t i = 0; i < _SNZR_VT_MAX_LOADS; i++) {
+        vt.loads[i].path = vt.path;
+        vt.loads[i].pixels = SNZ_ARENA_PUSH_ARR(arena, _SNZR_VT_PAGE_BYTES, uint8_t);
+    }
+    vt.loadGroup = SNZ_ARENA_PUSH(arena, snz_JobGroup);
+    memset(vt.loadGroup, 0, sizeof(*vt.loadGroup));
+
+    vt.cache = snzr_textureInitRBGA(pagesPerSide * _SNZR_VT_PAGE_SIZE, pagesPerSide * _SNZR_VT_PAGE_SIZE, NULL);
+
+    // nearest everything, the shader picks the level and each texel is an address, not a color
+    snzr_callGLFnOrError(glGenTextures(1, &vt.indirectionTexId));
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, vt.indirectionTexId));
+    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST));
+    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    snzr_callGLFnOrError(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, vt.levelCount - 1));
+    for (int64_t l = 0; l < vt.levelCount; l++) {
+        snzr_callGLFnOrError(glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, vt.levelTilesX[l], vt.levelTilesY[l], 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                                          &vt.indirection[vt.levelFirstTile[l] * 4]));
+    }
+    snzr_resourceTrack(SNZR_RK_TEXTURE, vt.indirectionTexId, vt.tileCount * 4);
+    return vt;
+}
+
+// waits out tile reads that are still going, then frees the textures. The arena memory is the callers.
+void snzr_virtualTextureDeinit(snzr_VirtualTexture* vt) {
+    snz_jobGroupWait(vt->loadGroup);
+    snzr_textureDeinit(&vt->cache);
+    snzr_resourceRelease(SNZR_RK_TEXTURE, vt->indirectionTexId);
+    memset(vt, 0, sizeof(*vt));
+}
+
+static void _snzr_vtLoadJob(void* userData) {
+    _snzr_VtLoad* load = (_snzr_VtLoad*)userData;
+    bool ok = false;
+    FILE* f = fopen(load->path, "rb");
+    if (f) {
+        int64_t offset = (int64_t)sizeof(_snzr_VtHeader) + load->tile * _SNZR_VT_PAGE_BYTES;
+        ok = _SNZ_FSEEK64(f, offset, SEEK_SET) == 0 && fread(load->pixels, _SNZR_VT_PAGE_BYTES, 1, f) == 1;
+        fclose(f);
+    }
+    SDL_AtomicSet(&load->state, ok ? _SNZR_VTL_READ : _SNZR_VTL_FAILED);
+}
+
+// marks a tile as needed this frame. Starts reading it if it isn't resident, or keeps it from getting
+// evicted if it is. Ask for coarse tiles before fine ones, reads start in the order they're asked for and
+// get skipped (until a later frame) once _SNZR_VT_MAX_LOADS are in flight.
+void snzr_virtualTextureRequest(snzr_VirtualTexture* vt, int64_t level, int64_t x, int64_t y) {
+    SNZ_ASSERTF(level >= 0 && level < vt->levelCount, "virtual texture level %lld out of range.", level);
+    SNZ_ASSERTF(x >= 0 && y >= 0 && x < vt->levelTilesX[level] && y < vt->levelTilesY[level],
+                "virtual texture tile %lld, %lld out of range for level %lld.", x, y, level);
+    int64_t tile = vt->levelFirstTile[level] + y * vt->levelTilesX[level] + x;
+    vt->requestCount++;
+
+    if (vt->tileStates[tile] == _SNZR_VTS_RESIDENT) {
+        vt->pages[vt->tilePages[tile]].lastUsedFrame = vt->frameIdx;
+        return;
+    } else if (vt->tileStates[tile] == _SNZR_VTS_LOADING || vt->tileStates[tile] == _SNZR_VTS_FAILED) {
+        return;
+    }
+
+    for (int64_t i = 0; i < _SNZR_VT_MAX_LOADS; i++) {
+        _snzr_VtLoad* load = &vt->loads[i];
+        if (SDL_AtomicGet(&load->state) != _SNZR_VTL_FREE) {
+            continue;
+        }
+        load->tile = tile;
+        SDL_AtomicSet(&load->state, _SNZR_VTL_READING);
+        vt->tileStates[tile] = _SNZR_VTS_LOADING;
+        snz_jobGroupPush(vt->loadGroup, _snzr_vtLoadJob, load);
+        return;
+    }
+}
+
+// a page not used this frame, empty ones first and then the least recently used. -1 if every page is in use.
+static int64_t _snzr_vtPageFind(snzr_VirtualTexture* vt) {
+    int64_t coarsest = vt->tileCount - 1;
+    int64_t best = -1;
+    for (int64_t i = 0; i < vt->pagesPerSide * vt->pagesPerSide; i++) {
+        _snzr_VtPage* p = &vt->pages[i];
+        if (p->tile < 0) {
+            return i;
+        }
+        if (p->tile == coarsest || p->lastUsedFrame == vt->frameIdx) {
+            continue;
+        }
+        if (best < 0 || p->lastUsedFrame < vt->pages[best].lastUsedFrame) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// points every tile that isn't resident at its closest resident ancestor, coarse levels first so parents are done
+static void _snzr_vtIndirectionBuild(snzr_VirtualTexture* vt) {
+    for (int64_t l = vt->levelCount - 1; l >= 0; l--) {
+        int64_t tilesX = vt->levelTilesX[l];
+        int64_t tilesY = vt->levelTilesY[l];
+        for (int64_t y = 0; y < tilesY; y++) {
+            for (int64_t x = 0; x < tilesX; x++) {
+                int64_t tile = vt->levelFirstTile[l] + y * tilesX + x;
+                uint8_t* entry = &vt->indirection[tile * 4];
+                int32_t page = vt->tilePages[tile];
+                if (page >= 0) {
+                    entry[0] = (uint8_t)(page % vt->pagesPerSide);
+                    entry[1] = (uint8_t)(page / vt->pagesPerSide);
+                    entry[2] = (uint8_t)l;
+                    entry[3] = 255;
+                } else if (l == vt->levelCount - 1) {
+                    memset(entry, 0, 4);
+                } else {
+                    int64_t px = x * vt->levelTilesX[l + 1] / tilesX;
+                    int64_t py = y * vt->levelTilesY[l + 1] / tilesY;
+                    int64_t parent = vt->levelFirstTile[l + 1] + py * vt->levelTilesX[l + 1] + px;
+                    memcpy(entry, &vt->indirection[parent * 4], 4);
+                }
+            }
+        }
+    }
+
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, vt->indirectionTexId));
+    for (int64_t l = 0; l < vt->levelCount; l++) {
+        snzr_callGLFnOrError(glTexSubImage2D(GL_TEXTURE_2D, l, 0, 0, vt->levelTilesX[l], vt->levelTilesY[l], GL_RGBA, GL_UNSIGNED_BYTE,
+                                             &vt->indirection[vt->levelFirstTile[l] * 4]));
+    }
+}
+
+// call once a frame, after this frames requests and before drawing with it.
+// uploads up to _SNZR_VT_UPLOADS_PER_FRAME tiles that finished reading and updates the indirection.
+void snzr_virtualTextureUpdate(snzr_VirtualTexture* vt) {
+    int64_t uploads = 0;
+    for (int64_t i = 0; i < _SNZR_VT_MAX_LOADS && uploads < _SNZR_VT_UPLOADS_PER_FRAME; i++) {
+        _snzr_VtLoad* load = &vt->loads[i];
+        int state = SDL_AtomicGet(&load->state);
+        if (state == _SNZR_VTL_FAILED) {
+            if (vt->stats.failed == 0) {  // the rest are likely the same problem
+                SNZ_LOGF("Reading tile %lld of virtual texture '%s' failed, showing coarser tiles in its place.", load->tile, vt->path);
+            }
+            vt->tileStates[load->tile] = _SNZR_VTS_FAILED;
+            vt->stats.failed++;
+            SDL_AtomicSet(&load->state, _SNZR_VTL_FREE);
+            continue;
+        } else if (state != _SNZR_VTL_READ) {
+            continue;
+        }
+
+        int64_t page = _snzr_vtPageFind(vt);
+        if (page < 0) {  // everything is on screen, the request gets made again next frame
+            vt->tileStates[load->tile] = _SNZR_VTS_ABSENT;
+            SDL_AtomicSet(&load->state, _SNZR_VTL_FREE);
+            continue;
+        }
+        _snzr_VtPage* p = &vt->pages[page];
+        if (p->tile >= 0) {
+            vt->tileStates[p->tile] = _SNZR_VTS_ABSENT;
+            vt->tilePages[p->tile] = -1;
+            vt->stats.evicted++;
+        }
+
+        int64_t x = (page % vt->pagesPerSide) * _SNZR_VT_PAGE_SIZE;
+        int64_t y = (page / vt->pagesPerSide) * _SNZR_VT_PAGE_SIZE;
+        snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, vt->cache.glId));
+        snzr_callGLFnOrError(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, _SNZR_VT_PAGE_SIZE, _SNZR_VT_PAGE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, load->pixels));
+
+        *p = (_snzr_VtPage){ .tile = load->tile, .lastUsedFrame = vt->frameIdx };
+        vt->tileStates[load->tile] = _SNZR_VTS_RESIDENT;
+        vt->tilePages[load->tile] = (int32_t)page;
+        vt->indirectionDirty = true;
+        SDL_AtomicSet(&load->state, _SNZR_VTL_FREE);
+        uploads++;
+        vt->stats.uploaded++;
+    }
+
+    if (vt->indirectionDirty) {
+        _snzr_vtIndirectionBuild(vt);
+        vt->indirectionDirty = false;
+    }
+
+    vt->stats.requested = vt->requestCount;
+    vt->requestCount = 0;
+    vt->stats.resident = 0;
+    for (int64_t i = 0; i < vt->pagesPerSide * vt->pagesPerSide; i++) {
+        vt->stats.resident += vt->pages[i].tile >= 0;
+    }
+    vt->stats.loading = 0;
+    for (int64_t i = 0; i < _SNZR_VT_MAX_LOADS; i++) {
+        vt->stats.loading += SDL_AtomicGet(&vt->loads[i].state) != _SNZR_VTL_FREE;
+    }
+    vt->frameIdx++;
+}
+
+// uses shaderId and sets the uniforms a shader sampling vt expects, and binds vt's textures to units
+// _SNZR_VT_TEXTURE_UNIT and the one after. Nothing else binds those, so this holds until the mesh draws even
+// when it's recorded into a command list. The uniforms are:
+//     sampler2D uVtIndirection, sampler2D uVtCache (the pages, bilinear)
+//     vec4 uVtInfo: tiles across & down level 0, level count, tile size in texels
+//     vec4 uVtPageInfo: border in texels, page size in texels, cache size in texels, unused
+// see res/shaders/surface.frag for sampling with them.
+void snzr_virtualTextureBind(const snzr_VirtualTexture* vt, uint32_t shaderId) {
+    snzr_callGLFnOrError(glUseProgram(shaderId));
+    snzr_callGLFnOrError(glUniform1i(glGetUniformLocation(shaderId, "uVtIndirection"), _SNZR_VT_TEXTURE_UNIT));
+    snzr_callGLFnOrError(glUniform1i(glGetUniformLocation(shaderId, "uVtCache"), _SNZR_VT_TEXTURE_UNIT + 1));
+    snzr_callGLFnOrError(glUniform4f(glGetUniformLocation(shaderId, "uVtInfo"),
+                                     vt->levelTilesX[0], vt->levelTilesY[0], vt->levelCount, _SNZR_VT_TILE_SIZE));
+    snzr_callGLFnOrError(glUniform4f(glGetUniformLocation(shaderId, "uVtPageInfo"),
+                                     _SNZR_VT_BORDER, _SNZR_VT_PAGE_SIZE, vt->cache.width, 0));
+
+    snzr_callGLFnOrError(glActiveTexture(GL_TEXTURE0 + _SNZR_VT_TEXTURE_UNIT));
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, vt->indirectionTexId));
+    snzr_callGLFnOrError(glActiveTexture(GL_TEXTURE0 + _SNZR_VT_TEXTURE_UNIT + 1));
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, vt->cache.glId));
+    snzr_callGLFnOrError(glActiveTexture(GL_TEXTURE0));
+}
+
+typedef enum {
+    SNZR_AA_NONE,
+    SNZR_AA_MSAA,  // draws go to multisampled renderbuffers, the resolve blits them down into the texture
+    SNZR_AA_FXAA,  // draws go to a plain texture, the resolve filters edges out of it into the texture
+    SNZR_AA_COUNT,
+} snzr_AntiAliasing;
+
+typedef struct {
+    uint32_t glId;  // draw into this one
+    uint32_t depthBufferId;
+    snzr_Texture texture;  // sample this one, only valid after snzr_frameBufferResolve when aa isn't none
+
+    snzr_AntiAliasing aa;
+    uint32_t msaaColorBufferId;
+    uint32_t resolveGlId;     // attached to texture when glId isn't, 0 when aa is none
+    snzr_Texture fxaaSource;  // what glId draws into for fxaa
+} snzr_FrameBuffer;
+
+// makes a framebuffer attached to tex and leaves it bound
+static uint32_t _snzr_frameBufferGenWithTexture(snzr_Texture tex) {
+    uint32_t id = 0;
+    snzr_callGLFnOrError(glGenFramebuffers(1, &id));
+    snzr_resourceTrack(SNZR_RK_FRAMEBUFFER, id, 0);
+    snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, id));
+    snzr_callGLFnOrError(glActiveTexture(GL_TEXTURE0));
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, tex.glId));
+    snzr_callGLFnOrError(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex.glId, 0));
+    return id;
+}
+
+// a framebuffer that draws into tex, with the size of tex + a depth buffer
+// what aa actually gets used, clamps samples to what the driver supports.
+// msaa falls back to none when the driver can't do at least 2.
+static snzr_AntiAliasing _snzr_aaSupported(snzr_AntiAliasing aa, int32_t* samples) {
+    SNZ_ASSERTF(aa >= 0 && aa < SNZR_AA_COUNT, "invalid anti-aliasing mode %d.", aa);
+    if (aa == SNZR_AA_MSAA) {
+        if (_snzr_globs.maxSamples == 0) {
+            snzr_callGLFnOrError(glGetIntegerv(GL_MAX_SAMPLES, &_snzr_globs.maxSamples));
+        }
+        *samples = SNZ_MIN(*samples, _snzr_globs.maxSamples);
+        if (*samples < 2) {
+            SNZ_LOGF("msaa with %d samples isn't supported, falling back to none.", *samples);
+            aa = SNZR_AA_NONE;
+        }
+    }
+    return aa;
+}
+
+// samples is only read for msaa, see _snzr_aaSupported for fallbacks
+snzr_FrameBuffer snzr_frameBufferInitAA(snzr_Texture tex, snzr_AntiAliasing aa, int32_t samples) {
+    aa = _snzr_aaSupported(aa, &samples);
+
+    snzr_FrameBuffer out = (snzr_FrameBuffer){
         .texture = tex,
+        .aa = aa,
+    };
+
+    if (aa == SNZR_AA_NONE) {
+        out.glId = _snzr_frameBufferGenWithTexture(tex);
+    } else if (aa == SNZR_AA_FXAA) {
+        out.fxaaSource = snzr_textureInitRBGA(tex.width, tex.height, NULL);
+        out.glId = _snzr_frameBufferGenWithTexture(out.fxaaSource);
+    } else if (aa == SNZR_AA_MSAA) {
+        snzr_callGLFnOrError(glGenFramebuffers(1, &out.glId));
+        snzr_resourceTrack(SNZR_RK_FRAMEBUFFER, out.glId, 0);
+        snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, out.glId));
+        snzr_callGLFnOrError(glGenRenderbuffers(1, &out.msaaColorBufferId));
+        snzr_callGLFnOrError(glBindRenderbuffer(GL_RENDERBUFFER, out.msaaColorBufferId));
+        snzr_callGLFnOrError(glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, tex.width, tex.height));
+        snzr_resourceTrack(SNZR_RK_RENDERBUFFER, out.msaaColorBufferId, (uint64_t)tex.width * tex.height * 4 * samples);
+        snzr_callGLFnOrError(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, out.msaaColorBufferId));
+    }
+
+    snzr_callGLFnOrError(glGenRenderbuffers(1, &out.depthBufferId));
+    snzr_callGLFnOrError(glBindRenderbuffer(GL_RENDERBUFFER, out.depthBufferId));
+    if (aa == SNZR_AA_MSAA) {
+        snzr_callGLFnOrError(glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT32, tex.width, tex.height));
+    } else {
+        snzr_callGLFnOrError(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32, tex.width, tex.height));
+    }
+    snzr_resourceTrack(SNZR_RK_RENDERBUFFER, out.depthBufferId, (uint64_t)tex.width * tex.height * 4 * (aa == SNZR_AA_MSAA ? samples : 1));
+    snzr_callGLFnOrError(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, out.depthBufferId));
+    SNZ_ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer gen failed.");
+
+    if (aa != SNZR_AA_NONE) {
+        out.resolveGlId = _snzr_frameBufferGenWithTexture(tex);
+        SNZ_ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer resolve target gen failed.");
+    }
+    snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    return out;
+}
+
+// returns the GLID for a new framebuffer, attacted to tex, and with size of tex + a depth buffer
+snzr_FrameBuffer snzr_frameBufferInit(snzr_Texture tex) {
+    return snzr_frameBufferInitAA(tex, SNZR_AA_NONE, 0);
+}
+
+// frees the texture too
+void snzr_frameBufferDeinit(snzr_FrameBuffer* fb) {
+    snzr_resourceRelease(SNZR_RK_FRAMEBUFFER, fb->glId);
+    snzr_resourceRelease(SNZR_RK_FRAMEBUFFER, fb->resolveGlId);
+    snzr_resourceRelease(SNZR_RK_RENDERBUFFER, fb->depthBufferId);
+    snzr_resourceRelease(SNZR_RK_RENDERBUFFER, fb->msaaColorBufferId);
+    snzr_textureDeinit(&fb->texture);
+    snzr_textureDeinit(&fb->fxaaSource);
+    memset(fb, 0, sizeof(*fb));
+}
+
+// resolves the width x height corner of fb into its texture, call between drawing to it and sampling it.
+// does nothing for framebuffers without aa. Leaves the bound framebuffer and viewport changed.
+static void _snzr_frameBufferResolveRegion(snzr_FrameBuffer* fb, uint32_t width, uint32_t height) {
+    if (fb->aa == SNZR_AA_MSAA) {
+        snzr_callGLFnOrError(glBindFramebuffer(GL_READ_FRAMEBUFFER, fb->glId));
+        snzr_callGLFnOrError(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb->resolveGlId));
+        snzr_callGLFnOrError(glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    } else if (fb->aa == SNZR_AA_FXAA) {
+        snzr_Texture src = fb->fxaaSource;
+        HMM_Vec2 texel = HMM_V2(1.0f / src.width, 1.0f / src.height);
+        HMM_Vec2 uvEnd = HMM_V2(width * texel.X, height * texel.Y);
+
+        snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, fb->resolveGlId));
+        snzr_callGLFnOrError(glViewport(0, 0, width, height));
+        bool depthTest = glIsEnabled(GL_DEPTH_TEST);
+        bool blend = glIsEnabled(GL_BLEND);
+        snzr_callGLFnOrError(glDisable(GL_DEPTH_TEST));
+        snzr_callGLFnOrError(glDisable(GL_BLEND));
+
+        uint32_t shader = _snzr_globs.fxaaShaderId;
+        snzr_callGLFnOrError(glUseProgram(shader));
+        snzr_callGLFnOrError(glUniform2f(glGetUniformLocation(shader, "uUvEnd"), uvEnd.X, uvEnd.Y));
+        snzr_callGLFnOrError(glUniform2f(glGetUniformLocation(shader, "uTexelSize"), texel.X, texel.Y));
+        snzr_callGLFnOrError(glUniform1i(glGetUniformLocation(shader, "uSource"), 0));
+        snzr_callGLFnOrError(glActiveTexture(GL_TEXTURE0));
+        snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, src.glId));
+        snzr_callGLFnOrError(glBindVertexArray(_snzr_globs.fullscreenVaId));
+        snzr_callGLFnOrError(glDrawArrays(GL_TRIANGLES, 0, 3));
+        snzr_callGLFnOrError(glBindVertexArray(0));
+
+        if (depthTest) {
+            snzr_callGLFnOrError(glEnable(GL_DEPTH_TEST));
+        }
+        if (blend) {
+            snzr_callGLFnOrError(glEnable(GL_BLEND));
+        }
+    } else {
+        return;
+    }
+    snzr_textureGenMips(fb->texture);
+}
+
+// see _snzr_frameBufferResolveRegion, this does the whole thing
+void snzr_frameBufferResolve(snzr_FrameBuffer* fb) {
+    _snzr_frameBufferResolveRegion(fb, fb->texture.width, fb->texture.height);
+}
+
+// binds whatever is being presented this frame (the window, or the headless target) and sets the viewport to cover it
+void snzr_frameBufferBindScreen() {
+    snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, _snzr_globs.screenFrameBufferId));
+    snzr_callGLFnOrError(glViewport(0, 0, _snzr_globs.screenSize.X, _snzr_globs.screenSize.Y));
+}
+
+// targets are allocated rounded up to this, so resizes within a step reuse the same gl objects
+#define _SNZR_FB_POOL_GRANULARITY 256
+#define _SNZR_FB_POOL_MAX_ENTRIES 16
+
+// a width x height corner (the bottom left one, in gl terms) of a pooled framebuffer
+typedef struct {
+    snzr_FrameBuffer frameBuffer;  // owned by the pool, don't deinit
+    uint32_t width;
+    uint32_t height;
+    HMM_Vec2 uvEnd;  // uvs of the far corner of the region, the near one is 00
+} snzr_FrameBufferRegion;
+
+typedef struct {
+    snzr_FrameBuffer frameBuffer;
+    uint64_t lastFrameUsed;
+    bool inUse;  // this frame
+    bool retained;  // in use past the end of the frame, see snzr_frameBufferPoolRetain
+} _snzr_FrameBufferPoolEntry;
+
+// hands out framebuffers for render targets that change size a lot (animated boxes, etc.)
+// acquired regions are valid until the next snzr_frameBufferPoolFrameEnd, which should be called after they've been drawn
+typedef struct {
+    _snzr_FrameBufferPoolEntry entries[_SNZR_FB_POOL_MAX_ENTRIES];
+    int64_t entryCount;
+    uint64_t frameIdx;
+    uint64_t evictAfterFrames;
+    uint64_t allocCount;  // lifetime total, to check that reuse is actually happening
+    snzr_AntiAliasing aa;  // in use, after falling back from requestedAA if the driver can't do it
+    snzr_AntiAliasing requestedAA;
+    int32_t samples;
+    const char* owner;  // of the framebuffers
+} snzr_FrameBufferPool;
+
+// every target in the pool gets made with aa & samples, see snzr_frameBufferInitAA
+snzr_FrameBufferPool snzr_frameBufferPoolInit(uint64_t evictAfterFrames, snzr_AntiAliasing aa, int32_t samples) {
+    snzr_FrameBufferPool out = { .evictAfterFrames = evictAfterFrames, .requestedAA = aa, .owner = _snzr_resourceOwner() };
+    out.aa = _snzr_aaSupported(aa, &samples);
+    out.samples = samples;
+    return out;
+}
+
+void snzr_frameBufferPoolDeinit(snzr_FrameBufferPool* pool) {
+    for (int64_t i = 0; i < pool->entryCount; i++) {
+        snzr_frameBufferDeinit(&pool->entries[i].frameBuffer);
+    }
+    memset(pool, 0, sizeof(*pool));
+}
+
+static uint32_t _snzr_frameBufferPoolSizeClass(uint32_t size) {
+    return (size + _SNZR_FB_POOL_GRANULARITY - 1) / _SNZR_FB_POOL_GRANULARITY * _SNZR_FB_POOL_GRANULARITY;
+}
+
+// sizes are clamped to at least 1px
+// picks the smallest free target that fits, and only allocates when none do
+snzr_FrameBufferRegion snzr_frameBufferPoolAcquire(snzr_FrameBufferPool* pool, uint32_t width, uint32_t height) {
+    width = SNZ_MAX(width, 1);
+    height = SNZ_MAX(height, 1);
+
+    _snzr_FrameBufferPoolEntry* best = NULL;
+    for (int64_t i = 0; i < pool->entryCount; i++) {
+        _snzr_FrameBufferPoolEntry* e = &pool->entries[i];
+        snzr_Texture t = e->frameBuffer.texture;
+        if (e->inUse || t.width < width || t.height < height) {
+            continue;
+        }
+        // much bigger targets still work, but waste fill on the clear, so they only get picked if nothing tighter is around
+        if (!best || (uint64_t)t.width * t.height < (uint64_t)best->frameBuffer.texture.width * best->frameBuffer.texture.height) {
+            best = e;
+        }
+    }
+
+    if (!best) {
+        SNZ_ASSERTF(pool->entryCount < _SNZR_FB_POOL_MAX_ENTRIES, "framebuffer pool full, max is %d.", _SNZR_FB_POOL_MAX_ENTRIES);
+        best = &pool->entries[pool->entryCount++];
+        const char* prevOwner = snzr_resourceOwnerSet(pool->owner);
+        snzr_Texture t = snzr_textureInitRBGA(_snzr_frameBufferPoolSizeClass(width), _snzr_frameBufferPoolSizeClass(height), NULL);
+        best->frameBuffer = snzr_frameBufferInitAA(t, pool->aa, pool->samples);
+        snzr_resourceOwnerSet(prevOwner);
+        pool->allocCount++;
+    }
+
+    best->inUse = true;
+    best->lastFrameUsed = pool->frameIdx;
+    snzr_Texture t = best->frameBuffer.texture;
+    return (snzr_FrameBufferRegion){
+        .frameBuffer = best->frameBuffer,
+        .width = width,
+        .height = height,
+        .uvEnd = HMM_V2((float)width / t.width, (float)height / t.height),
+    };
+}
+
+// binds and sets the viewport to just the region
+// clears still hit the whole target, which is fine because nothing samples outside of the region
+void snzr_frameBufferRegionBind(snzr_FrameBufferRegion region) {
+    snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, region.frameBuffer.glId));
+    snzr_callGLFnOrError(glViewport(0, 0, region.width, region.height));
+}
+
+// call after drawing to the region and before sampling it, does nothing when the pool doesn't have aa
+void snzr_frameBufferRegionResolve(snzr_FrameBufferRegion region) {
+    _snzr_frameBufferResolveRegion(&region.frameBuffer, region.width, region.height);
+}
+
+// draws src stretched over the bound viewport, with a catmull-rom filter so that a region rendered smaller than
+// where it's going (see snzr_DynamicResolution) stays sharper than plain bilinear would leave it.
+// src has to be resolved already. Doesn't blend, depth test or write depth.
+void snzr_drawUpscaled(snzr_FrameBufferRegion src) {
+    snzr_Texture tex = src.frameBuffer.texture;
+    bool depthTest = glIsEnabled(GL_DEPTH_TEST);
+    bool blend = glIsEnabled(GL_BLEND);
+    snzr_callGLFnOrError(glDisable(GL_DEPTH_TEST));
+    snzr_callGLFnOrError(glDisable(GL_BLEND));
+
+    uint32_t shader = _snzr_globs.upscaleShaderId;
+    snzr_callGLFnOrError(glUseProgram(shader));
+    snzr_callGLFnOrError(glUniform2f(glGetUniformLocation(shader, "uUvEnd"), src.uvEnd.X, src.uvEnd.Y));
+    snzr_callGLFnOrError(glUniform2f(glGetUniformLocation(shader, "uTexelSize"), 1.0f / tex.width, 1.0f / tex.height));
+    snzr_callGLFnOrError(glUniform1i(glGetUniformLocation(shader, "uSource"), 0));
+    snzr_callGLFnOrError(glActiveTexture(GL_TEXTURE0));
+    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, tex.glId));
+    snzr_callGLFnOrError(glBindVertexArray(_snzr_globs.fullscreenVaId));
+    snzr_callGLFnOrError(glDrawArrays(GL_TRIANGLES, 0, 3));
+    snzr_callGLFnOrError(glBindVertexArray(0));
+
+    if (depthTest) {
+        snzr_callGLFnOrError(glEnable(GL_DEPTH_TEST));
+    }
+    if (blend) {
+        snzr_callGLFnOrError(glEnable(GL_BLEND));
+    }
+}
+
+// hands a region back before the end of the frame, so a later acquire this frame can reuse the target.
+// whatever was drawn into it is fair game after this.
+void snzr_frameBufferPoolRelease(snzr_FrameBufferPool* pool, snzr_FrameBufferRegion region) {
+    for (int64_t i = 0; i < pool->entryCount; i++) {
+        if (pool->entries[i].frameBuffer.glId == region.frameBuffer.glId) {
+            SNZ_ASSERT(pool->entries[i].inUse, "releasing a pooled framebuffer that wasn't acquired.");
+            pool->entries[i].inUse = false;
+            pool->entries[i].retained = false;
+            return;
+        }
+    }
+    SNZ_ASSERT(false, "released framebuffer isn't from this pool.");
+}
+
+// keeps an acquired region (and what's drawn in it) through snzr_frameBufferPoolFrameEnd, so it can be shown
+// on later frames without drawing it again. It stays out of acquires and eviction until snzr_frameBufferPoolRelease.
+// Deiniting the pool still frees it.
+void snzr_frameBufferPoolRetain(snzr_FrameBufferPool* pool, snzr_FrameBufferRegion region) {
+    for (int64_t i = 0; i < pool->entryCount; i++) {
+        if (pool->entries[i].frameBuffer.glId == region.frameBuffer.glId) {
+            SNZ_ASSERT(pool->entries[i].inUse, "retaining a pooled framebuffer that wasn't acquired.");
+            pool->entries[i].retained = true;
+            return;
+        }
+    }
+    SNZ_ASSERT(false, "retained framebuffer isn't from this pool.");
+}
+
+// releases everything acquired this frame that isn't retained, and frees targets that haven't been used in evictAfterFrames
+void snzr_frameBufferPoolFrameEnd(snzr_FrameBufferPool* pool) {
+    for (int64_t i = 0; i < pool->entryCount; i++) {
+        _snzr_FrameBufferPoolEntry* e = &pool->entries[i];
+        if (e->retained) {
+            e->lastFrameUsed = pool->frameIdx;
+            continue;
+        }
+        e->inUse = false;
+        if (pool->frameIdx - e->lastFrameUsed > pool->evictAfterFrames) {
+            snzr_frameBufferDeinit(&e->frameBuffer);
+            *e = pool->entries[pool->entryCount - 1];  // swap remove, so don't advance
+            pool->entryCount--;
+            i--;
+        }
+    }
+    pool->frameIdx++;
+}
+
+#define _SNZR_FONT_FIRST_ASCII 32
+#define _SNZR_FONT_ASCII_CHAR_COUNT (255 - _SNZR_FONT_FIRST_ASCII)
+#define _SNZR_FONT_KERN_CHARS (127 - _SNZR_FONT_FIRST_ASCII)  // only printable ascii pairs get kerned
+#define _SNZR_FONT_TAB_SPACES 4
+#define _SNZR_FONT_UNKNOWN_CHAR 9633  // white box, see: https://www.fileformat.info/info/unicode/char/25a1/index.htm
+
+snzr_Font snzr_fontInit(snz_Arena* dataArena, snz_Arena* scratch, const char* path, float size) {
+    static uint64_t generation = 0;
+    snzr_Font out = { .renderedSize = size, .generation = ++generation };
+
+    uint8_t* fileData;
+    {
+        FILE* file = fopen(path, "rb");
+        SNZ_ASSERT(file != NULL, "opening font file '%s' failed.");
+
+        fseek(file, 0L, SEEK_END);
+        uint64_t size = ftell(file);
+        fseek(file, 0L, SEEK_SET);
+
+        fileData = SNZ_ARENA_PUSH_ARR(scratch, size, uint8_t);
+        SNZ_ASSERT(fread(fileData, sizeof(uint8_t), size, file) == size, "reading font file failed.");
+        fclose(file);
+    }
+
+    stbtt_fontinfo font;
+    stbtt_InitFont(&font, fileData, stbtt_GetFontOffsetForIndex(fileData, 0));
+    stbtt_GetScaledFontVMetrics(fileData, 0, out.renderedSize,
+                                &out.ascent,
+                                &out.descent,
+                                &out.lineGap);
+
+    stbtt_pack_context ctx;
+    uint8_t* atlasData = SNZ_ARENA_PUSH_ARR(dataArena, _SNZR_FONT_ATLAS_W * _SNZR_FONT_ATLAS_H, uint8_t);
+    assert(stbtt_PackBegin(&ctx, atlasData,
+        _SNZR_FONT_ATLAS_W,
+        _SNZR_FONT_ATLAS_H,
+        _SNZR_FONT_ATLAS_W,
+        1,
+        NULL));
+    stbtt_PackSetOversampling(&ctx, 1, 1);
+
+    const int glyphCount = _SNZR_FONT_ASCII_CHAR_COUNT + 1;
+    int codepoints[glyphCount];
+    codepoints[0] = _SNZR_FONT_UNKNOWN_CHAR;
+    for (int i = 0; i < _SNZR_FONT_ASCII_CHAR_COUNT; i++) {
+        // skip 0, thats the missing glyph
+        codepoints[i + 1] = _SNZR_FONT_FIRST_ASCII + i;
+    }
+
+    out.packRange = (stbtt_pack_range){
+        .font_size = out.renderedSize,
+        .array_of_unicode_codepoints = codepoints,
+        .num_chars = glyphCount,
+        .chardata_for_range = SNZ_ARENA_PUSH_ARR(dataArena, glyphCount, stbtt_packedchar),
+    };
+    stbtt_PackFontRanges(&ctx, fileData, 0, &out.packRange, 1);
+    stbtt_PackEnd(&ctx);
+
+    out.atlas = snzr_textureInitGrayscale(_SNZR_FONT_ATLAS_W, _SNZR_FONT_ATLAS_H, atlasData);
+    out.atlasPixels = atlasData;
+
+    // the font file doesn't outlive this, so kerning gets baked into a table up front
+    if (font.kern || font.gpos) {
+        float scale = stbtt_ScaleForPixelHeight(&font, out.renderedSize);
+        int glyphIdxs[_SNZR_FONT_KERN_CHARS];
+        for (int i = 0; i < _SNZR_FONT_KERN_CHARS; i++) {
+            glyphIdxs[i] = stbtt_FindGlyphIndex(&font, _SNZR_FONT_FIRST_ASCII + i);
+        }
+        float* kerning = SNZ_ARENA_PUSH_ARR(scratch, _SNZR_FONT_KERN_CHARS * _SNZR_FONT_KERN_CHARS, float);
+        bool any = false;
+        for (int a = 0; a < _SNZR_FONT_KERN_CHARS; a++) {
+            for (int b = 0; b < _SNZR_FONT_KERN_CHARS; b++) {
+                float k = stbtt_GetGlyphKernAdvance(&font, glyphIdxs[a], glyphIdxs[b]) * scale;
+                kerning[a * _SNZR_FONT_KERN_CHARS + b] = k;
+                any |= k != 0;
+            }
+        }
+        if (any) {
+            out.kerning = SNZ_ARENA_PUSH_ARR(dataArena, _SNZR_FONT_KERN_CHARS * _SNZR_FONT_KERN_CHARS, float);
+            memcpy(out.kerning, kerning, _SNZR_FONT_KERN_CHARS * _SNZR_FONT_KERN_CHARS * sizeof(float));
+        }
+    }
+    return out;
+}
+
+// only frees the atlas texture, everything else is in the arenas passed to snzr_fontInit
+void snzr_fontDeinit(snzr_Font* font) {
+    snzr_textureDeinit(&font->atlas);
+}
+
+// one of these per rect or glyph, fed to the rect shader as instanced attributes
+typedef struct {
+    HMM_Vec4 dst;  // start xy, end xy
+    HMM_Vec4 src;  // uv start xy, uv end xy
+    HMM_Vec4 clip;  // start xy, end xy
+    HMM_Vec4 color;
+    HMM_Vec4 borderColor;
+    HMM_Vec4 params;  // corner radius, border thickness, lod bias, 1 if a glyph else 0
+} _snzr_RectInstance;
+
+// one of these per ring, the ring shader expands each to a quad and works the ring out per pixel
+typedef struct {
+    HMM_Vec4 shape;  // center xyz, radius
+    HMM_Vec4 color;
+    HMM_Vec4 falloffOrigin;  // xyz, w unused
+    HMM_Vec4 params;  // thickness in pixels, falloff offset, falloff duration, unused
+} _snzr_RingInstance;
+
+// one of these per line in the line shaders header SSBO, layout matches std430
+typedef struct {
+    HMM_Vec4 color;
+    HMM_Vec4 falloffOrigin;  // xyz, w is thickness
+    float falloffOffset;
+    float falloffDuration;
+    uint32_t firstPt;  // into the point SSBO
+    uint32_t firstVert;  // sum of the vertex counts of every line before this one
+} _snzr_LineHeader;
+
+// one visible glyph of a laid out string
+typedef struct {
+    HMM_Vec4 dst;  // start xy, end xy, relative to where the string starts
+    HMM_Vec4 src;  // uv start xy, uv end xy
+} _snzr_GlyphQuad;
+
+typedef enum {
+    SNZR_CMD_RECT,
+    SNZR_CMD_GLYPH_RUN,
+    SNZR_CMD_LINE,
+    SNZR_CMD_MESH,
+    SNZR_CMD_RING,
+} snzr_CmdKind;
+
+typedef struct _snzr_Cmd _snzr_Cmd;
+struct _snzr_Cmd {
+    _snzr_Cmd* next;
+    uint64_t sortKey;
+    snzr_CmdKind kind;
+    HMM_Mat4 vp;
+    union {
+        struct {
+            _snzr_RectInstance inst;
+            uint32_t textureId;
+        } rect;
+        struct {
+            HMM_Vec2 start;
+            HMM_Vec4 clip;
+            HMM_Vec4 color;
+            const _snzr_GlyphQuad* glyphs;  // laid out relative to start, copied into the lists arena
+            uint64_t glyphCount;
+            const snzr_Font* font;  // also a copy
+            bool snap;
+        } glyphRun;
+        struct {
+            HMM_Vec4* pts;  // copied, with end miters already added on
+            uint64_t ptCount;
+            HMM_Vec4 color;
+            float thickness;
+            HMM_Vec3 falloffOrigin;
+            float falloffOffset;
+            float falloffDuration;
+        } line;
+        struct {
+            uint32_t shaderId;
+            uint32_t vaId;
+            uint32_t indexCount;
+            HMM_Mat4 model;
+        } mesh;
+        struct {
+            _snzr_RingInstance inst;
+        } ring;
+    };
+};
+
+// commands are sorted by layer first, then by the order they were recorded in,
+// so anything on one layer composites exactly as if it had been drawn immediately.
+typedef struct {
+    snz_Arena* arena;
+    _snzr_Cmd* first;
+    _snzr_Cmd* last;
+    uint64_t count;
+    uint8_t layer;
+} snzr_CmdList;
+
+#define _SNZR_CMD_LAYER_SHIFT 56
+
+struct {
+    snzr_CmdList* activeList;  // null means draws are submitted as soon as they're recorded
+    bool lineBatchOpen;  // immediate draws are held until snzr_lineBatchEnd
+    HMM_Mat4 lineBatchVP;
+
+    snz_Arena immediateArena;
+    snzr_CmdList immediateList;
+
+    uint32_t rectVaId;
+    uint32_t rectInstanceBufferId;
+    snzr_ShaderPermutations rectShaders;  // keyed by _snzr_RectFeature bits
+
+    uint32_t ringShaderId;
+    uint32_t ringVaId;
+    uint32_t ringInstanceBufferId;
+} _snzr_cmdGlobs;
+
+// what a rect batch needs the shader to do, anything not set is compiled out
+// a batch uses the union of its instances, every feature is a no-op for instances that don't use it
+typedef enum {
+    _SNZR_RF_TEXTURED = 1 << 0,
+    _SNZR_RF_GLYPH = 1 << 1,
+    _SNZR_RF_ROUNDED = 1 << 2,
+    _SNZR_RF_BORDERED = 1 << 3,
+} _snzr_RectFeature;
+
+struct {
+    uint32_t programId;  // what these were fetched from, zero before the first use
+    int vp;
+    int z;
+    int fontTexture;
+    int colorTexture;
+} _snzr_rectShaderLocations[_SNZR_SHADER_PERMUTATION_COUNT];
+
+static void _snzr_rectShaderLocationsInit(uint32_t key, uint32_t id) {
+    _snzr_rectShaderLocations[key].programId = id;
+    _snzr_rectShaderLocations[key].vp = glGetUniformLocation(id, "uVP");
+    _snzr_rectShaderLocations[key].z = glGetUniformLocation(id, "uZ");
+    _snzr_rectShaderLocations[key].fontTexture = glGetUniformLocation(id, "uFontTexture");
+    _snzr_rectShaderLocations[key].colorTexture = glGetUniformLocation(id, "uColorTexture");
+}
+
+static void _snzr_init(snz_Arena* scratchArena, GLADloadproc glLoader) {
+    {  // initialize gl settings
+        SNZ_ASSERT(gladLoadGLLoader(glLoader), "loading GL functions failed.");
+        glLoadIdentity();
+        snzr_callGLFnOrError(glEnable(GL_DEPTH_TEST));
+        snzr_callGLFnOrError(glDepthFunc(GL_LESS | GL_EQUAL));
+        snzr_callGLFnOrError(glEnable(GL_BLEND));
+        snzr_callGLFnOrError(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+        snzr_callGLFnOrError(glEnable(GL_DEBUG_OUTPUT));
+
+        // snzr_callGLFnOrError(glEnable(GL_CULL_FACE));
+        // snzr_callGLFnOrError(glCullFace(GL_BACK));
+        // snzr_callGLFnOrError(glFrontFace(GL_CCW));
+        snzr_callGLFnOrError(glEnable(GL_MULTISAMPLE));
+        snzr_callGLFnOrError(glDebugMessageCallback(_snzr_glDebugCallback, 0));
+
+        snzr_callGLFnOrError(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        snzr_callGLFnOrError(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    }
+
+    _snzr_shaderCacheInit();
+
+    {
+        const char* vertSrc =
+            "layout(location = 0) in vec4 iDst;"
+            "layout(location = 1) in vec4 iSrc;"
+            "layout(location = 2) in vec4 iClip;"
+            "layout(location = 3) in vec4 iColor;"
+            "layout(location = 4) in vec4 iBorderColor;"
+            "layout(location = 5) in vec4 iParams;"
+            ""
+            "out vec2 vUv;"
+            "out vec2 vCenterFromFragPos;"
+            "out vec2 vRectHalfSize;"
+            "flat out vec4 vColor;"
+            "flat out vec4 vBorderColor;"
+            "flat out vec4 vParams;"
+            ""
+            "uniform mat4 uVP;"
+            "uniform float uZ;"
+            ""
+            "vec2 cornerTable[6] = vec2[]("
+            "    vec2(0, 0),"
+            "    vec2(0, 1),"
+            "    vec2(1, 1),"
+            "    vec2(1, 1),"
+            "    vec2(1, 0),"
+            "    vec2(0, 0)"
+            "    );"
+            ""
+            "void main() {"
+            "    vec2 dstStart = iDst.xy;"
+            "    vec2 dstEnd = iDst.zw;"
+            "    vec2 srcStart = iSrc.xy;"
+            "    vec2 srcEnd = iSrc.zw;"
+            ""
+            "    vec2 uvPos = cornerTable[gl_VertexID % 6];"
+            "    uvPos *= srcEnd - srcStart;"
+            "    uvPos += srcStart;"
+            "    vUv = uvPos;"
+            ""
+            "    vec2 pos = cornerTable[gl_VertexID % 6];"
+            "    pos *= dstEnd - dstStart;"
+            "    pos += dstStart;"
+            ""
+            "    vec2 startDiff = iClip.xy - pos;"
+            "    startDiff = max(startDiff, vec2(0, 0));"
+            "    vec2 endDiff = iClip.zw - pos;"
+            "    endDiff = min(endDiff, vec2(0, 0));"
+            ""
+            "    vec2 totalDiff = startDiff + endDiff;"
+            "    vUv += totalDiff / (dstEnd - dstStart) * (srcEnd - srcStart);"
+            "    pos += totalDiff;"
+            ""
+            "    vRectHalfSize = (dstEnd - dstStart) / 2.0;"
+            "    vCenterFromFragPos = (dstStart + vRectHalfSize) - pos;"
+            "    vColor = iColor;"
+            "    vBorderColor = iBorderColor;"
+            "    vParams = iParams;"
+            "    gl_Position = uVP * vec4(pos, uZ, 1);"
+            "};";
+
+        // preprocessor lines need their own lines, hence the newlines in here
+        const char* fragSrc =
+            "out vec4 color;"
+
+            "in vec2 vUv;"
+            "in vec2 vCenterFromFragPos;"
+            "in vec2 vRectHalfSize;"
+            "flat in vec4 vColor;"
+            "flat in vec4 vBorderColor;"
+            "flat in vec4 vParams;"
+
+            "uniform sampler2D uFontTexture;"
+            "uniform sampler2D uColorTexture;"
+
+            "float roundedRectSDF(float r) {"
+            "    vec2 d2 = abs(vCenterFromFragPos) - abs(vRectHalfSize) + vec2(r, r);"
+            "    return min(max(d2.x, d2.y), 0.0) + length(max(d2, 0.0)) - r;"
+            "}"
+
+            "void main() {"
+            "    color = vColor;\n"
+            "#ifdef SNZR_GLYPH\n"
+            "    float glyph = vParams.w;\n"  // glyphs only read the font atlas, rects only read the color texture
+            "#else\n"
+            "    float glyph = 0.0;\n"
+            "#endif\n"
+            "#ifdef SNZR_TEXTURED\n"
+            "    color *= mix(texture(uColorTexture, vUv, vParams.z), vec4(1.0), glyph);\n"
+            "#endif\n"
+            "#ifdef SNZR_GLYPH\n"
+            "    color.a *= mix(1.0, texture(uFontTexture, vUv).r, glyph);\n"
+            "#endif\n"
+
+            // edges fade out over one pixel, which is why the ui doesn't need msaa.
+            // aa is a pixel in sdf units, taken from the position so it's the same across corners where the sdf gradient jumps
+            // the border is mixed in premultiplied, so transparent fills don't darken its inner edge
+            "#if defined(SNZR_ROUNDED) || defined(SNZR_BORDERED)\n"
+            "    float dist = roundedRectSDF(vParams.x);"
+            "    float aa = max(length(dFdx(vCenterFromFragPos)), 0.0001);\n"
+            "#ifdef SNZR_BORDERED\n"
+            "    float t = clamp(0.5 + (dist + vParams.y) / aa, 0.0, 1.0) * float(vParams.y > 0.0);"
+            "    float a = mix(color.a, vBorderColor.a, t);"
+            "    color.rgb = mix(color.rgb * color.a, vBorderColor.rgb * vBorderColor.a, t) / max(a, 0.0001);"
+            "    color.a = a;\n"
+            "#endif\n"
+            // plain rects sharing the batch keep hard edges, same as the permutation without the sdf
+            "    color.a *= mix(1.0, clamp(0.5 - dist / aa, 0.0, 1.0), float(max(vParams.x, vParams.y) > 0.0));\n"
+            "#endif\n"
+
+            "    if (color.a <= 0.01) { discard; }"
+            "};";
+        _snzr_cmdGlobs.rectShaders = (snzr_ShaderPermutations){
+            .name = "rect",
+            .version = "#version 330 core",
+            .vertSrc = vertSrc,
+            .fragSrc = fragSrc,
+            .featureDefines = { "SNZR_TEXTURED", "SNZR_GLYPH", "SNZR_ROUNDED", "SNZR_BORDERED" },
+        };
+        // the rest compile the first time a batch needs them
+        snzr_shaderPermutationGet(&_snzr_cmdGlobs.rectShaders, 0, scratchArena);
+        snzr_shaderPermutationGet(&_snzr_cmdGlobs.rectShaders, _SNZR_RF_GLYPH, scratchArena);
+
+        snzr_callGLFnOrError(glGenVertexArrays(1, &_snzr_cmdGlobs.rectVaId));
+        snzr_callGLFnOrError(glGenBuffers(1, &_snzr_cmdGlobs.rectInstanceBufferId));
+        snzr_resourceTrack(SNZR_RK_VERTEX_ARRAY, _snzr_cmdGlobs.rectVaId, 0);
+        snzr_resourceTrack(SNZR_RK_BUFFER, _snzr_cmdGlobs.rectInstanceBufferId, 0);
+        snzr_callGLFnOrError(glBindVertexArray(_snzr_cmdGlobs.rectVaId));
+        snzr_callGLFnOrError(glBindBuffer(GL_ARRAY_BUFFER, _snzr_cmdGlobs.rectInstanceBufferId));
+        for (int i = 0; i < 6; i++) {
+            snzr_callGLFnOrError(glEnableVertexAttribArray(i));
+            snzr_callGLFnOrError(glVertexAttribDivisor(i, 1));
+        }
+        snzr_callGLFnOrError(glBindVertexArray(0));
+
+        _snzr_cmdGlobs.immediateArena = snz_arenaInit(4000000, "snzr immediate cmd arena");
+    }
+
+    {
+        const char* vertSrc =
+            "#version 330 core\n"
+            "layout(location = 0) in vec4 iShape;"
+            "layout(location = 1) in vec4 iColor;"
+            "layout(location = 2) in vec4 iFalloffOrigin;"
+            "layout(location = 3) in vec4 iParams;"
+
+            "uniform mat4 uVP;"
+            "uniform vec2 uResolution;"
+
+            "out vec2 vFromCenter;"
+            "flat out vec4 vShape;"
+            "flat out vec4 vColor;"
+            "flat out vec4 vFalloffOrigin;"
+            "flat out vec4 vParams;"
+
+            "vec2 toPixels(vec3 p) {"
+            "    vec4 clip = uVP * vec4(p, 1.0);"
+            "    return clip.xy / clip.w * 0.5 * uResolution;"
+            "}"
+
+            "void main() {"
+            "    vec2 corners[6] = vec2[6]("
+            "        vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),"
+            "        vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));"
+            // how big a pixel is in world units around the center, so the quad reaches half the thickness + a pixel past the ring
+            "    vec2 center = toPixels(iShape.xyz);"
+            "    float pixelsPerUnit = min(length(toPixels(iShape.xyz + vec3(1.0, 0.0, 0.0)) - center),"
+            "                              length(toPixels(iShape.xyz + vec3(0.0, 1.0, 0.0)) - center));"
+            "    float extent = iShape.w + (iParams.x * 0.5 + 1.0) / max(pixelsPerUnit, 0.000001);"
+            "    vFromCenter = corners[gl_VertexID] * extent;"
+            "    gl_Position = uVP * vec4(iShape.xyz + vec3(vFromCenter, 0.0), 1.0);"
+            "    vShape = iShape;"
+            "    vColor = iColor;"
+            "    vFalloffOrigin = iFalloffOrigin;"
+            "    vParams = iParams;"
+            "}";
+        const char* fragSrc =
+            "#version 330 core\n"
+            "out vec4 color;"
+            "in vec2 vFromCenter;"
+            "flat in vec4 vShape;"
+            "flat in vec4 vColor;"
+            "flat in vec4 vFalloffOrigin;"
+            "flat in vec4 vParams;"
+
+            "void main() {"
+            "    float dist = length(vFromCenter);"
+            // distance from the ring in pixels, the derivative handles whatever scaling the vp does
+            "    float pixelDist = abs(dist - vShape.w) / max(length(vec2(dFdx(dist), dFdy(dist))), 0.000001);"
+            "    float coverage = clamp(vParams.x * 0.5 - pixelDist + 0.5, 0.0, 1.0);"
+
+            // same falloff as the line shader, measured from the closest point on the ring
+            "    vec3 onRing = vShape.xyz + vec3(vFromCenter / max(dist, 0.000001) * vShape.w, 0.0);"
+            "    float falloff = 1.0 - max(length(onRing - vFalloffOrigin.xyz) - vParams.y, 0.0) / vParams.z;"
+            "    color = vec4(vColor.rgb, vColor.a * coverage * clamp(falloff, 0.0, 1.0));"
+            "    if (color.a <= 0.01) { discard; }"
+            "}";
+        SNZ_LOG("loading ring shader.");
+        _snzr_cmdGlobs.ringShaderId = snzr_shaderInit(vertSrc, fragSrc, scratchArena);
+
+        snzr_callGLFnOrError(glGenVertexArrays(1, &_snzr_cmdGlobs.ringVaId));
+        snzr_callGLFnOrError(glGenBuffers(1, &_snzr_cmdGlobs.ringInstanceBufferId));
+        snzr_resourceTrack(SNZR_RK_VERTEX_ARRAY, _snzr_cmdGlobs.ringVaId, 0);
+        snzr_resourceTrack(SNZR_RK_BUFFER, _snzr_cmdGlobs.ringInstanceBufferId, 0);
+        snzr_callGLFnOrError(glBindVertexArray(_snzr_cmdGlobs.ringVaId));
+        snzr_callGLFnOrError(glBindBuffer(GL_ARRAY_BUFFER, _snzr_cmdGlobs.ringInstanceBufferId));
+        for (int i = 0; i < 4; i++) {
+            snzr_callGLFnOrError(glEnableVertexAttribArray(i));
+            snzr_callGLFnOrError(glVertexAttribDivisor(i, 1));
+        }
+        snzr_callGLFnOrError(glBindVertexArray(0));
+    }
+
+    {
+        const char* vertSrc =
+            "#version 430\n"
+            "struct lineVert {"
+            "    vec4 pos;"
+            "};"
+            "struct lineHeader {"
+            "    vec4 color;"
+            "    vec4 falloffOrigin;"  // w is thickness
+            "    vec2 falloff;"  // offset, duration
+            "    uint firstPt;"
+            "    uint firstVert;"
+            "};"
+
+            "layout(std430, binding = 0) buffer vertBuffer {"
+            "    lineVert verts[];"
+            "};"
+            "layout(std430, binding = 1) buffer headerBuffer {"
+            "    lineHeader headers[];"
+            "};"
+
+            "uniform mat4 uVP;"
+            "uniform vec2 uResolution;"
+            "uniform int uFirstLine;"
+            "uniform int uLineCount;"
+
+            "out vec3 vFragPos;"
+            "flat out vec4 vColor;"
+            "flat out vec4 vFalloffOrigin;"
+            "flat out vec2 vFalloff;"
+
+            "/* STOLEN FROM HERE: https://stackoverflow.com/questions/60440682/drawing-a-line-in-modern-opengl */"
+            "void main() {"
+            // last line that starts at or before this vertex, firstVert is a prefix sum over the lines
+            "    int lo = uFirstLine;"
+            "    int hi = uFirstLine + uLineCount - 1;"
+            "    while (lo < hi) {"
+            "        int mid = (lo + hi + 1) / 2;"
+            "        if (int(headers[mid].firstVert) <= gl_VertexID) { lo = mid; } else { hi = mid - 1; }"
+            "    }"
+            "    lineHeader h = headers[lo];"
+            "    int local = gl_VertexID - int(h.firstVert);"
+            "    int line_i = int(h.firstPt) + local / 6;"
+            "    int tri_i  = local % 6;"
+            "    float thickness = h.falloffOrigin.w;"
+            "    vColor = h.color;"
+            "    vFalloffOrigin = h.falloffOrigin;"
+            "    vFalloff = h.falloff;"
+
+            "    vec4 va[4];"
+            "    for (int i=0; i<4; ++i)"
+            "    {"
+            "        va[i] = uVP * vec4(verts[line_i+i].pos.xyz, 1);"
+            "        va[i].xyz /= va[i].w;"
+            "        va[i].xy = (va[i].xy + 1.0) * 0.5 * uResolution;"
+            "    }"
+
+            "    vec2 v_line  = normalize(va[2].xy - va[1].xy);"
+            "    vec2 nv_line = vec2(-v_line.y, v_line.x);"
+
+            "    vec4 pos;"
+            "    if (tri_i == 0 || tri_i == 1 || tri_i == 3)"
+            "    {"
+            "        vec2 v_pred  = normalize(va[1].xy - va[0].xy);"
+            "        vec2 v_miter = normalize(nv_line + vec2(-v_pred.y, v_pred.x));"
+            "        pos = va[1];"
+            "        pos.xy += v_miter * thickness * (tri_i == 1 ? -0.5 : 0.5) / dot(v_miter, nv_line);"
+            "        vFragPos = verts[line_i + 1].pos.xyz;"  // FIXME: technically this isn't accounting for the width of the line in determning frag position, but I don't care rn
+            "    }"
+            "    else"
+            "    {"
+            "        vec2 v_succ  = normalize(va[3].xy - va[2].xy);"
+            "        vec2 v_miter = normalize(nv_line + vec2(-v_succ.y, v_succ.x));"
+            "        pos = va[2];"
+            "        pos.xy += v_miter * thickness * (tri_i == 5 ? 0.5 : -0.5) / dot(v_miter, nv_line);"
+            "        vFragPos = verts[line_i + 2].pos.xyz;"  // FIXME: technically this isn't accounting for the width of the line in determning frag position, but I don't care rn
+            "    }"
+            "    pos.xy = pos.xy / uResolution * 2.0 - 1.0;"
+            "    pos.xyz *= pos.w;"
+            "    gl_Position = pos;"
+            "};";
+        const char* fragSrc =
+            "#version 330 core\n"
+            "out vec4 color;"
+            "in vec3 vFragPos;"
+            "flat in vec4 vColor;"
+            "flat in vec4 vFalloffOrigin;"
+            "flat in vec2 vFalloff;"
+
+            "void main() {"
+            "    vec3 diffVec = vFragPos - vFalloffOrigin.xyz;"
+            "    float alpha = min(1, 1 + (1 / vFalloff.y) * (-length(diffVec) + vFalloff.x));"
+            "    color = vec4(vColor.xyz, alpha * vColor.w);"
+            "};";
+
+        // FIXME: issues when lines go off screen
+        SNZ_LOG("loading line shader.");
+        _snzr_globs.lineShaderId = snzr_shaderInit(vertSrc, fragSrc, scratchArena);
+    }
+
+    {
+        const char* vertSrc =
+            "#version 330 core\n"
+            "uniform vec2 uUvEnd;"
+            "out vec2 vUv;"
+            "void main() {"
+            "    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);"  // one triangle covering the viewport
+            "    vUv = corner * uUvEnd;"
+            "    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);"
+            "}";
+        // the cheap version of fxaa, 5 taps to find an edge and 4 along it
+        const char* fragSrc =
+            "#version 330 core\n"
+            "out vec4 color;"
+            "in vec2 vUv;"
+            "uniform sampler2D uSource;"
+            "uniform vec2 uTexelSize;"
+            "uniform vec2 uUvEnd;"
+
+            "vec4 at(vec2 uv) {"
+            "    return texture(uSource, min(uv, uUvEnd - uTexelSize * 0.5));"  // don't bleed in whatever is outside of the region
+            "}"
+            "float luma(vec4 c) {"
+            "    return dot(c.rgb, vec3(0.299, 0.587, 0.114));"
+            "}"
+
+            "void main() {"
+            "    vec4 m = at(vUv);"
+            "    float lM = luma(m);"
+            "    float lNW = luma(at(vUv + vec2(-1.0, -1.0) * uTexelSize));"
+            "    float lNE = luma(at(vUv + vec2(1.0, -1.0) * uTexelSize));"
+            "    float lSW = luma(at(vUv + vec2(-1.0, 1.0) * uTexelSize));"
+            "    float lSE = luma(at(vUv + vec2(1.0, 1.0) * uTexelSize));"
+            "    float lMin = min(lM, min(min(lNW, lNE), min(lSW, lSE)));"
+            "    float lMax = max(lM, max(max(lNW, lNE), max(lSW, lSE)));"
+            "    if (lMax - lMin < max(0.0312, lMax * 0.125)) {"
+            "        color = m;"
+            "        return;"
+            "    }"
+
+            "    vec2 dir = vec2(-((lNW + lNE) - (lSW + lSE)), (lNW + lSW) - (lNE + lSE));"
+            "    float reduce = max((lNW + lNE + lSW + lSE) * 0.25 * 0.125, 1.0 / 128.0);"
+            "    dir = clamp(dir / (min(abs(dir.x), abs(dir.y)) + reduce), -8.0, 8.0) * uTexelSize;"
+            "    vec4 a = 0.5 * (at(vUv + dir * (1.0 / 3.0 - 0.5)) + at(vUv + dir * (2.0 / 3.0 - 0.5)));"
+            "    vec4 b = a * 0.5 + 0.25 * (at(vUv - dir * 0.5) + at(vUv + dir * 0.5));"
+            "    float lB = luma(b);"
+            "    color = (lB < lMin || lB > lMax) ? a : b;"
+            "}";
+        SNZ_LOG("loading fxaa shader.");
+        _snzr_globs.fxaaShaderId = snzr_shaderInit(vertSrc, fragSrc, scratchArena);
+
+        // catmull-rom in 9 bilinear taps instead of 16 point ones, see snzr_drawUpscaled
+        const char* upscaleFragSrc =
+            "#version 330 core\n"
+            "out vec4 color;"
+            "in vec2 vUv;"
+            "uniform sampler2D uSource;"
+            "uniform vec2 uTexelSize;"
+            "uniform vec2 uUvEnd;"
+
+            "vec4 at(float x, float y) {"
+            "    vec2 uv = clamp(vec2(x, y), uTexelSize * 0.5, uUvEnd - uTexelSize * 0.5);"
+            "    return textureLod(uSource, uv, 0.0);"
+            "}"
+
+            "void main() {"
+            "    vec2 pos = vUv / uTexelSize;"
+            "    vec2 p1 = floor(pos - 0.5) + 0.5;"
+            "    vec2 f = pos - p1;"
+            "    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));"
+            "    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);"
+            "    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));"
+            "    vec2 w3 = f * f * (-0.5 + 0.5 * f);"
+            "    vec2 w12 = w1 + w2;"
+            "    vec2 p0 = (p1 - 1.0) * uTexelSize;"
+            "    vec2 p3 = (p1 + 2.0) * uTexelSize;"
+            "    vec2 p12 = (p1 + w2 / w12) * uTexelSize;"
+            "    vec4 c ="
+            "        (at(p0.x, p0.y) * w0.x + at(p12.x, p0.y) * w12.x + at(p3.x, p0.y) * w3.x) * w0.y +"
+            "        (at(p0.x, p12.y) * w0.x + at(p12.x, p12.y) * w12.x + at(p3.x, p12.y) * w3.x) * w12.y +"
+            "        (at(p0.x, p3.y) * w0.x + at(p12.x, p3.y) * w12.x + at(p3.x, p3.y) * w3.x) * w3.y;"
+            "    color = clamp(c, 0.0, 1.0);"  // the negative lobes ring a little past hard edges
+            "}";
+        SNZ_LOG("loading upscale shader.");
+        _snzr_globs.upscaleShaderId = snzr_shaderInit(vertSrc, upscaleFragSrc, scratchArena);
+        snzr_callGLFnOrError(glGenVertexArrays(1, &_snzr_globs.fullscreenVaId));
+        snzr_resourceTrack(SNZR_RK_VERTEX_ARRAY, _snzr_globs.fullscreenVaId, 0);
+    }
+
+    snzr_callGLFnOrError(glGenBuffers(1, &_snzr_globs.lineShaderSSBOId));
+    snzr_callGLFnOrError(glBindBuffer(GL_SHADER_STORAGE_BUFFER, _snzr_globs.lineShaderSSBOId));
+    snzr_callGLFnOrError(glBufferData(GL_SHADER_STORAGE_BUFFER, 0, NULL, GL_DYNAMIC_DRAW));
+    snzr_callGLFnOrError(glGenBuffers(1, &_snzr_globs.lineHeaderSSBOId));
+    snzr_resourceTrack(SNZR_RK_BUFFER, _snzr_globs.lineShaderSSBOId, 0);
+    snzr_resourceTrack(SNZR_RK_BUFFER, _snzr_globs.lineHeaderSSBOId, 0);
+
+    uint8_t solidTexData[] = { 255, 255, 255, 255 };
+    _snzr_globs.solidTex = snzr_textureInitRBGA(1, 1, solidTexData);
+
+    uint8_t placeholderTexData[] = { 128, 128, 128, 64 };
+    _snzr_globs.placeholderTex = snzr_textureInitRBGA(1, 1, placeholderTexData);
+
+    snzr_callGLFnOrError(glGenBuffers(_SNZR_TEXTURE_LOADER_PBO_COUNT, _snzr_textureLoaderGlobs.pboIds));
+    for (int64_t i = 0; i < _SNZR_TEXTURE_LOADER_PBO_COUNT; i++) {
+        snzr_resourceTrack(SNZR_RK_BUFFER, _snzr_textureLoaderGlobs.pboIds[i], 0);
+    }
+    _snzr_textureLoaderGlobs.uploadBudgetMs = 2;
+}
+
+// releases everything _snzr_init made, and whatever async texture loads made
+static void _snzr_deinit() {
+    _snzr_textureLoaderDeinit();
+
+    snzr_resourceRelease(SNZR_RK_PROGRAM, _snzr_globs.lineShaderId);
+    snzr_resourceRelease(SNZR_RK_BUFFER, _snzr_globs.lineShaderSSBOId);
+    snzr_resourceRelease(SNZR_RK_BUFFER, _snzr_globs.lineHeaderSSBOId);
+    snzr_resourceRelease(SNZR_RK_PROGRAM, _snzr_globs.fxaaShaderId);
+    snzr_resourceRelease(SNZR_RK_PROGRAM, _snzr_globs.upscaleShaderId);
+    snzr_resourceRelease(SNZR_RK_VERTEX_ARRAY, _snzr_globs.fullscreenVaId);
+    snzr_textureDeinit(&_snzr_globs.solidTex);
+    snzr_textureDeinit(&_snzr_globs.placeholderTex);
+
+    snzr_shaderPermutationsDeinit(&_snzr_cmdGlobs.rectShaders);
+    snzr_resourceRelease(SNZR_RK_VERTEX_ARRAY, _snzr_cmdGlobs.rectVaId);
+    snzr_resourceRelease(SNZR_RK_BUFFER, _snzr_cmdGlobs.rectInstanceBufferId);
+    snzr_resourceRelease(SNZR_RK_PROGRAM, _snzr_cmdGlobs.ringShaderId);
+    snzr_resourceRelease(SNZR_RK_VERTEX_ARRAY, _snzr_cmdGlobs.ringVaId);
+    snzr_resourceRelease(SNZR_RK_BUFFER, _snzr_cmdGlobs.ringInstanceBufferId);
+
+    _snzr_shaderCacheDeinit();
+}
+
+void snzr_cmdListBegin(snzr_CmdList* list, snz_Arena* arena) {
+    SNZ_ASSERT(_snzr_cmdGlobs.activeList == NULL, "can't begin a command list while another is recording.");
+    memset(list, 0, sizeof(*list));
+    list->arena = arena;
+    _snzr_cmdGlobs.activeList = list;
+}
+
+// stops recording, draws go back to being immediate. The list stays valid until its arena is cleared.
+void snzr_cmdListEnd() {
+    SNZ_ASSERT(_snzr_cmdGlobs.activeList != NULL, "no command list is recording.");
+    _snzr_cmdGlobs.activeList = NULL;
+}
+
+// following draws into the active list sort behind any on a higher layer and in front of any on a lower one
+void snzr_cmdListSetLayer(uint8_t layer) {
+    SNZ_ASSERT(_snzr_cmdGlobs.activeList != NULL, "no command list is recording.");
+    _snzr_cmdGlobs.activeList->layer = layer;
+}
+
+static snzr_CmdList* _snzr_cmdTargetList() {
+    if (_snzr_cmdGlobs.activeList) {
+        return _snzr_cmdGlobs.activeList;
+    }
+    snzr_CmdList* list = &_snzr_cmdGlobs.immediateList;
+    if (list->arena == NULL) {
+        list->arena = &_snzr_cmdGlobs.immediateArena;
+    }
+    return list;
+}
+
+static _snzr_Cmd* _snzr_cmdPush(snzr_CmdList* list, snzr_CmdKind kind, HMM_Mat4 vp) {
+    _snzr_Cmd* cmd = SNZ_ARENA_PUSH(list->arena, _snzr_Cmd);
+    cmd->kind = kind;
+    cmd->vp = vp;
+    cmd->sortKey = ((uint64_t)list->layer << _SNZR_CMD_LAYER_SHIFT) | list->count;
+    SNZ_ASSERT(list->count < (1ull << _SNZR_CMD_LAYER_SHIFT), "command list overflowed its sort key.");
+    if (list->last) {
+        list->last->next = cmd;
+    } else {
+        list->first = cmd;
+    }
+    list->last = cmd;
+    list->count++;
+    return cmd;
+}
+
+void snzr_cmdListSubmit(snzr_CmdList* list);
+
+// call after every record, flushes when there isn't a list being built
+static void _snzr_cmdRecorded(snzr_CmdList* list) {
+    if (list != &_snzr_cmdGlobs.immediateList || _snzr_cmdGlobs.lineBatchOpen) {
+        return;
+    }
+    snzr_cmdListSubmit(list);
+    snz_Arena* arena = list->arena;
+    snz_arenaClear(arena);
+    memset(list, 0, sizeof(*list));
+    list->arena = arena;
+}
+
+// same as snzr_drawRect, but only samples the part of texture between uvStart and uvEnd (gl uvs, 00 is the bottom left)
+void snzr_drawRectTextureRegion(
+    HMM_Vec2 start,
+    HMM_Vec2 end,
+    HMM_Vec2 clipStart,
+    HMM_Vec2 clipEnd,
+    HMM_Vec4 color,
+    float cornerRadius,
+    float borderThickness,
+    HMM_Vec4 borderColor,
+    HMM_Mat4 vp,
+    snzr_Texture texture,
+    HMM_Vec2 uvStart,
+    HMM_Vec2 uvEnd,
+    float textureLodBias) {
+    snzr_CmdList* list = _snzr_cmdTargetList();
+    _snzr_Cmd* cmd = _snzr_cmdPush(list, SNZR_CMD_RECT, vp);
+    cmd->rect.textureId = texture.glId;
+    cmd->rect.inst = (_snzr_RectInstance){
+        .dst = HMM_V4(start.X, start.Y, end.X, end.Y),
+        // flip vertically because we assume this is being used in pixel space, where 00 is in the UL corner
+        .src = HMM_V4(uvStart.X, uvEnd.Y, uvEnd.X, uvStart.Y),
+        .clip = HMM_V4(clipStart.X, clipStart.Y, clipEnd.X, clipEnd.Y),
+        .color = color,
+        .borderColor = borderColor,
+        .params = HMM_V4(cornerRadius, borderThickness, textureLodBias, 0),
+    };
+    _snzr_cmdRecorded(list);
+}
+
+void snzr_drawRect(
+    HMM_Vec2 start,
+    HMM_Vec2 end,
+    HMM_Vec2 clipStart,
+    HMM_Vec2 clipEnd,
+    HMM_Vec4 color,
+    float cornerRadius,
+    float borderThickness,
+    HMM_Vec4 borderColor,
+    HMM_Mat4 vp,
+    snzr_Texture texture,
+    float textureLodBias) {
+    snzr_drawRectTextureRegion(
+        start, end,
+        clipStart, clipEnd,
+        color,
+        cornerRadius,
+        borderThickness, borderColor,
+        vp,
+        texture, HMM_V2(0, 0), HMM_V2(1, 1),
+        textureLodBias);
+}
+
+static const stbtt_packedchar* _snzr_getGylphFromChar(const snzr_Font* font, char c) {
+    int glyph = c - _SNZR_FONT_FIRST_ASCII;
+    if (glyph < 0) {
+        return &font->packRange.chardata_for_range[0];  // first is unknown char
+    } else if (glyph >= _SNZR_FONT_ASCII_CHAR_COUNT) {
+        return &font->packRange.chardata_for_range[0];
+    }
+    return &font->packRange.chardata_for_range[glyph + 1];
+}
+
+// how far to move before drawing c after prev (0 for the start of a line), in pixels at renderedSize
+static float _snzr_fontKern(const snzr_Font* font, char prev, char c) {
+    int a = prev - _SNZR_FONT_FIRST_ASCII;
+    int b = c - _SNZR_FONT_FIRST_ASCII;
+    if (!font->kerning || a < 0 || a >= _SNZR_FONT_KERN_CHARS || b < 0 || b >= _SNZR_FONT_KERN_CHARS) {
+        return 0;
+    }
+    return font->kerning[a * _SNZR_FONT_KERN_CHARS + b];
+}
+
+// how far c moves the pen, in pixels at renderedSize. Tabs go to the next stop after lineX (from the line start)
+static float _snzr_fontAdvance(const snzr_Font* font, char c, float lineX) {
+    if (c == '\t') {
+        float stop = _snzr_getGylphFromChar(font, ' ')->xadvance * _SNZR_FONT_TAB_SPACES;
+        return (floorf(lineX / stop) + 1) * stop - lineX;
+    }
+    return _snzr_getGylphFromChar(font, c)->xadvance;
+}
+
+// Laying a string out (its size, and where each glyph goes) is cached between frames, keyed by
+// font, string and height, so labels that don't change only get measured and positioned once.
+// The UI measures and draws the same strings a few times a frame, and they all hit the same entry.
+// Entries that haven't been used in a while get freed by _snzr_textCacheFrameEnd.
+#define _SNZR_TEXT_CACHE_SETS 256
+#define _SNZR_TEXT_CACHE_WAYS 4
+#define _SNZR_TEXT_CACHE_MAX_CHARS 256  // longer strings (text being typed, mostly) are laid out every time
+#define _SNZR_TEXT_CACHE_EVICT_FRAMES 120
+
+typedef struct {
+    uint64_t key;
+    uint64_t lastFrameUsed;
+    float height;
+    uint64_t fontGeneration;
+    char* chars;  // a copy, to check against on a hit. Shares an allocation with glyphs
+    uint64_t charCount;
+    HMM_Vec2 size;
+    _snzr_GlyphQuad* glyphs;
+    uint64_t glyphCount;
+    uint64_t allocSize;
+} _snzr_TextLayout;
+
+typedef struct {
+    uint64_t hits;  // last frame
+    uint64_t misses;
+    uint64_t entries;
+} snzr_TextCacheStats;
+
+static struct {
+    _snzr_TextLayout sets[_SNZR_TEXT_CACHE_SETS][_SNZR_TEXT_CACHE_WAYS];
+    uint64_t frameIdx;
+    uint64_t hits;  // this frame
+    uint64_t misses;
+    snzr_TextCacheStats lastFrameStats;
+} _snzr_textCacheGlobs;
+
+// writes glyph quads to outGlyphs if it isn't null (sized for at least charCount), returns the same size snzr_strSize does
+static HMM_Vec2 _snzr_textLayout(const snzr_Font* font, const char* str, uint64_t charCount, float targetHeight, _snzr_GlyphQuad* outGlyphs, uint64_t* outGlyphCount) {
+    float scaleFactor = targetHeight / font->renderedSize;
+    HMM_Vec2 uvScale = HMM_V2(1.0f / font->atlas.width, 1.0f / font->atlas.height);
+
+    float x = 0;
+    float lineX = 0;
+    char prev = 0;
+    uint64_t lineCount = 1;
+    uint64_t glyphCount = 0;
+    HMM_Vec2 drawPos = HMM_V2(0, 0);
+    for (uint64_t i = 0; i < charCount; i++) {
+        char c = str[i];
+        if (c == '\n') {
+            lineCount++;
+            drawPos.Y += (font->lineGap + font->ascent - font->descent) * scaleFactor;
+            drawPos.X = 0;
+            lineX = 0;
+            prev = 0;
+            continue;
+        } else if (c == '\r') {
+            continue;
+        }
+
+        float kern = _snzr_fontKern(font, prev, c);
+        float advance = _snzr_fontAdvance(font, c, lineX + kern);
+        x += kern + advance;
+        lineX += kern + advance;
+        drawPos.X += kern * scaleFactor;
+        prev = c;
+
+        const stbtt_packedchar* b = _snzr_getGylphFromChar(font, c);
+        if (outGlyphs && c != '\t') {
+            HMM_Vec2 s = HMM_MulV2F(HMM_V2(b->xoff, b->yoff), scaleFactor);
+            HMM_Vec2 e = HMM_MulV2F(HMM_V2(b->xoff2, b->yoff2), scaleFactor);
+            HMM_Vec2 dstStart = HMM_AddV2(drawPos, s);
+            HMM_Vec2 dstEnd = HMM_AddV2(dstStart, HMM_Sub(e, s));
+            // spaces would just get clamped to nothing by the vertex shader
+            if (dstStart.X < dstEnd.X && dstStart.Y < dstEnd.Y) {
+                outGlyphs[glyphCount++] = (_snzr_GlyphQuad){
+                    .dst = HMM_V4(dstStart.X, dstStart.Y, dstEnd.X, dstEnd.Y),
+                    .src = HMM_V4(b->x0 * uvScale.X, b->y0 * uvScale.Y, b->x1 * uvScale.X, b->y1 * uvScale.Y),
+                };
+            }
+        }
+        drawPos.X += advance * scaleFactor;
+    }
+    if (outGlyphCount) {
+        *outGlyphCount = glyphCount;
+    }
+    return HMM_Mul(HMM_V2(x, lineCount * font->renderedSize), scaleFactor);
+}
+
+// null when the string is too long to be worth caching. Valid until the next _snzr_textCacheFrameEnd,
+// or until more than _SNZR_TEXT_CACHE_WAYS other strings that land in the same set get looked up.
+static const _snzr_TextLayout* _snzr_textCacheGet(const snzr_Font* font, const char* str, uint64_t charCount, float targetHeight) {
+    if (charCount > _SNZR_TEXT_CACHE_MAX_CHARS) {
+        return NULL;
+    }
+    uint64_t key = snz_hashBytes(SNZ_HASH_SEED, str, charCount);
+    key = snz_hashBytes(key, &font->generation, sizeof(font->generation));
+    key = snz_hashBytes(key, &targetHeight, sizeof(targetHeight));
+
+    _snzr_TextLayout* set = _snzr_textCacheGlobs.sets[key % _SNZR_TEXT_CACHE_SETS];
+    _snzr_TextLayout* oldest = &set[0];
+    for (int i = 0; i < _SNZR_TEXT_CACHE_WAYS; i++) {
+        _snzr_TextLayout* l = &set[i];
+        if (l->key == key && l->allocSize && l->fontGeneration == font->generation && l->height == targetHeight &&
+            l->charCount == charCount && memcmp(l->chars, str, charCount) == 0) {
+            l->lastFrameUsed = _snzr_textCacheGlobs.frameIdx;
+            _snzr_textCacheGlobs.hits++;
+            return l;
+        }
+        if (!l->allocSize || (oldest->allocSize && l->lastFrameUsed < oldest->lastFrameUsed)) {
+            oldest = l;
+        }
+    }
+
+    _snzr_textCacheGlobs.misses++;
+    _snzr_TextLayout* l = oldest;
+    uint64_t allocSize = charCount * sizeof(_snzr_GlyphQuad) + charCount + 1;
+    if (l->allocSize < allocSize) {
+        free(l->glyphs);
+        l->glyphs = calloc(1, allocSize);
+        SNZ_ASSERT(l->glyphs, "allocating text layout failed.");
+        l->allocSize = allocSize;
+    }
+    l->chars = (char*)&l->glyphs[charCount];
+    memcpy(l->chars, str, charCount);
+    l->key = key;
+    l->lastFrameUsed = _snzr_textCacheGlobs.frameIdx;
+    l->height = targetHeight;
+    l->fontGeneration = font->generation;
+    l->charCount = charCount;
+    l->size = _snzr_textLayout(font, str, charCount, targetHeight, l->glyphs, &l->glyphCount);
+    return l;
+}
+
+static void _snzr_textCacheFrameEnd() {
+    uint64_t entries = 0;
+    for (int i = 0; i < _SNZR_TEXT_CACHE_SETS; i++) {
+        for (int j = 0; j < _SNZR_TEXT_CACHE_WAYS; j++) {
+            _snzr_TextLayout* l = &_snzr_textCacheGlobs.sets[i][j];
+            if (l->allocSize && _snzr_textCacheGlobs.frameIdx - l->lastFrameUsed > _SNZR_TEXT_CACHE_EVICT_FRAMES) {
+                free(l->glyphs);
+                memset(l, 0, sizeof(*l));
+            }
+            entries += l->allocSize != 0;
+        }
+    }
+    _snzr_textCacheGlobs.lastFrameStats = (snzr_TextCacheStats){
+        .hits = _snzr_textCacheGlobs.hits,
+        .misses = _snzr_textCacheGlobs.misses,
+        .entries = entries,
+    };
+    _snzr_textCacheGlobs.hits = 0;
+    _snzr_textCacheGlobs.misses = 0;
+    _snzr_textCacheGlobs.frameIdx++;
+}
+
+// static text should be all hits after the first frame it shows up on
+snzr_TextCacheStats snzr_textCacheStatsGet() {
+    return _snzr_textCacheGlobs.lastFrameStats;
+}
+
+// stops at the first null, if there is one before charCount
+static uint64_t _snzr_strLen(const char* str, uint64_t charCount) {
+    uint64_t len = 0;
+    while (len < charCount && str[len] != 0) {
+        len++;
+    }
+    return len;
+}
+
+HMM_Vec2 snzr_strSize(const snzr_Font* font, const char* str, uint64_t charCount, float targetHeight) {
+    charCount = _snzr_strLen(str, charCount);
+    const _snzr_TextLayout* l = _snzr_textCacheGet(font, str, charCount, targetHeight);
+    if (l) {
+        return l->size;
+    }
+    return _snzr_textLayout(font, str, charCount, targetHeight, NULL, NULL);
+}
+
+// always renders with upwards on text being -, so do a matmul if that isn't ideal
+// when snap is on, rects per char get snapped to integer lines
+// FIXME: font should be a const*
+void snzr_drawTextScaled(HMM_Vec2 start,
+                         HMM_Vec2 clipStart,
+                         HMM_Vec2 clipEnd,
+                         HMM_Vec4 color,
+                         const char* str,
+                         uint64_t charCount,
+                         snzr_Font font,
+                         HMM_Mat4 vp,
+                         float targetSize,
+                         bool snap) {
+    assert(charCount < INT64_MAX);
+    uint64_t len = _snzr_strLen(str, charCount);
+
+    snzr_CmdList* list = _snzr_cmdTargetList();
+    _snzr_Cmd* cmd = _snzr_cmdPush(list, SNZR_CMD_GLYPH_RUN, vp);
+    // copied out of the cache because lists can outlive entries
+    _snzr_GlyphQuad* glyphs = NULL;
+    uint64_t glyphCount = 0;
+    const _snzr_TextLayout* l = _snzr_textCacheGet(&font, str, len, targetSize);
+    if (l) {
+        glyphCount = l->glyphCount;
+        glyphs = SNZ_ARENA_PUSH_ARR(list->arena, glyphCount, _snzr_GlyphQuad);
+        memcpy(glyphs, l->glyphs, glyphCount * sizeof(_snzr_GlyphQuad));
+    } else {
+        glyphs = SNZ_ARENA_PUSH_ARR(list->arena, len, _snzr_GlyphQuad);
+        _snzr_textLayout(&font, str, len, targetSize, glyphs, &glyphCount);
+    }
+    snzr_Font* fontCopy = SNZ_ARENA_PUSH(list->arena, snzr_Font);
+    *fontCopy = font;
+
+    cmd->glyphRun.start = start;
+    cmd->glyphRun.clip = HMM_V4(clipStart.X, clipStart.Y, clipEnd.X, clipEnd.Y);
+    cmd->glyphRun.color = color;
+    cmd->glyphRun.glyphs = glyphs;
+    cmd->glyphRun.glyphCount = glyphCount;
+    cmd->glyphRun.font = fontCopy;
+    cmd->glyphRun.snap = snap;
+    _snzr_cmdRecorded(list);
+}
+
+// default to use for UI in 2d pixel space
+void snzr_drawText(HMM_Vec2 start,
+                   HMM_Vec2 clipStart,
+                   HMM_Vec2 clipEnd,
+                   HMM_Vec4 color,
+                   const char* str,
+                   uint64_t charCount,
+                   snzr_Font font,
+                   HMM_Mat4 vp) {
+    snzr_drawTextScaled(start, clipStart, clipEnd, color, str, charCount, font, vp, font.renderedSize, true);
+}
+
+// Paragraphs: text wrapped to a width, broken into a table of lines that's kept between frames.
+// Lines break at the last space or tab that fits (or mid-word when a word doesn't fit by itself),
+// and at newlines. The table is heap allocated and owned by the paragraph.
+// After an edit, snzr_paragraphEdit only relays out from the line before the edit until
+// lines start lining up with the old ones again, and then just shifts the rest,
+// so typing into something huge stays cheap. The string itself is always the callers.
+
+typedef struct {
+    uint64_t start;  // index of the first char on the line
+    uint64_t end;  // one past the last char on the line, not counting the spaces or newline it broke at
+    float width;  // in pixels, at the paragraphs height
+} snzr_ParagraphLine;
+
+typedef struct {
+    const snzr_Font* font;
+    float height;
+    float wrapWidth;  // INFINITY to only break on newlines
+    uint64_t maxLines;  // 0 for no limit. When there are more, the last line shown is cut to end in an ellipsis
+
+    snzr_ParagraphLine* lines;
+    uint64_t lineCount;
+    uint64_t lineCapacity;
+    uint64_t charCount;  // of the string the table was made for
+} snzr_Paragraph;
+
+#define _SNZR_PARAGRAPH_ELLIPSIS "..."
+
+snzr_Paragraph snzr_paragraphInit(const snzr_Font* font, float height, float wrapWidth, uint64_t maxLines) {
+    return (snzr_Paragraph){
+        .font = font,
+        .height = height,
+        .wrapWidth = wrapWidth,
+        .maxLines = maxLines,
+    };
+}
+
+void snzr_paragraphDeinit(snzr_Paragraph* p) {
+    free(p->lines);
+    memset(p, 0, sizeof(*p));
+}
+
+static void _snzr_paragraphPushLine(snzr_ParagraphLine** lines, uint64_t* count, uint64_t* capacity, snzr_ParagraphLine line) {
+    if (*count == *capacity) {
+        *capacity = SNZ_MAX(*capacity * 2, 64);
+        *lines = realloc(*lines, *capacity * sizeof(snzr_ParagraphLine));
+        SNZ_ASSERT(*lines, "growing paragraph line table failed.");
+    }
+    (*lines)[(*count)++] = line;
+}
+
+// lays out the line starting at start. Returns false if it was the last one, otherwise outNext is where the next starts.
+// only depends on the chars from start on, which is what lets edits resync with the old table.
+static bool _snzr_paragraphLineLayout(const snzr_Paragraph* p, const char* str, uint64_t charCount, uint64_t start, snzr_ParagraphLine* out, uint64_t* outNext) {
+    const snzr_Font* font = p->font;
+    float scale = p->height / font->renderedSize;
+    float x = 0;
+    char prev = 0;
+    bool hasBreak = false;
+    uint64_t breakEnd = 0;
+    float breakWidth = 0;
+    uint64_t breakResume = 0;
+
+    for (uint64_t i = start; i < charCount; i++) {
+        char c = str[i];
+        if (c == '\n') {
+            *out = (snzr_ParagraphLine){ .start = start, .end = i, .width = x * scale };
+            *outNext = i + 1;
+            return true;
+        } else if (c == '\r') {
+            continue;
+        }
+
+        bool space = c == ' ' || c == '\t';
+        if (space) {
+            if (!hasBreak || breakResume != i) {  // only the first of a run of spaces ends a line
+                breakEnd = i;
+                breakWidth = x;
+            }
+            hasBreak = true;
+            breakResume = i + 1;
+        }
+
+        float kern = _snzr_fontKern(font, prev, c);
+        float next = x + kern + _snzr_fontAdvance(font, c, x + kern);
+        // spaces hang off the end instead of wrapping
+        if (!space && i > start && next * scale > p->wrapWidth) {
+            if (hasBreak) {
+                *out = (snzr_ParagraphLine){ .start = start, .end = breakEnd, .width = breakWidth * scale };
+                *outNext = breakResume;
+            } else {
+                *out = (snzr_ParagraphLine){ .start = start, .end = i, .width = x * scale };
+                *outNext = i;
+            }
+            return true;
+        }
+        x = next;
+        prev = c;
+    }
+    *out = (snzr_ParagraphLine){ .start = start, .end = charCount, .width = x * scale };
+    *outNext = charCount;
+    return false;
+}
+
+// lays out the whole thing again, for new strings or after changing the font, height or wrap width
+void snzr_paragraphLayout(snzr_Paragraph* p, const char* str, uint64_t charCount) {
+    p->lineCount = 0;
+    p->charCount = charCount;
+    uint64_t at = 0;
+    bool more = true;
+    while (more) {
+        snzr_ParagraphLine line = { 0 };
+        more = _snzr_paragraphLineLayout(p, str, charCount, at, &line, &at);
+        _snzr_paragraphPushLine(&p->lines, &p->lineCount, &p->lineCapacity, line);
+    }
+}
+
+// str is the string after the edit, where removedCount chars at editStart were replaced by insertedCount new ones
+void snzr_paragraphEdit(snzr_Paragraph* p, const char* str, uint64_t charCount, uint64_t editStart, uint64_t removedCount, uint64_t insertedCount) {
+    SNZ_ASSERTF(p->charCount - removedCount + insertedCount == charCount,
+                "paragraph edit doesn't add up, %llu chars before, %llu now.", p->charCount, charCount);
+    if (p->lineCount == 0) {
+        snzr_paragraphLayout(p, str, charCount);
+        return;
+    }
+
+    // last line starting at or before the edit, then back one more because a shorter first word can pull back up
+    uint64_t first = 0;
+    {
+        uint64_t lo = 0;
+        uint64_t hi = p->lineCount - 1;
+        while (lo < hi) {
+            uint64_t mid = (lo + hi + 1) / 2;
+            if (p->lines[mid].start <= editStart) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        first = lo > 0 ? lo - 1 : 0;
+    }
+
+    int64_t delta = (int64_t)insertedCount - (int64_t)removedCount;
+    uint64_t oldEditEnd = editStart + removedCount;
+    uint64_t newEditEnd = editStart + insertedCount;
+
+    snzr_ParagraphLine* fresh = NULL;
+    uint64_t freshCount = 0;
+    uint64_t freshCapacity = 0;
+    uint64_t old = first;  // old lines that haven't been passed yet
+    uint64_t resync = p->lineCount;  // first old line that gets kept, shifted
+    uint64_t at = p->lines[first].start;
+    bool more = true;
+    while (more) {
+        // a line starting past the edit where an old one did lays out the same from here on
+        if (at >= newEditEnd) {
+            // signed, lines before a removal would shift to below zero and wrap otherwise
+            while (old < p->lineCount && (int64_t)p->lines[old].start + delta < (int64_t)at) {
+                old++;
+            }
+            if (old < p->lineCount && p->lines[old].start >= oldEditEnd && (int64_t)p->lines[old].start + delta == (int64_t)at) {
+                resync = old;
+                break;
+            }
+        }
+        snzr_ParagraphLine line = { 0 };
+        more = _snzr_paragraphLineLayout(p, str, charCount, at, &line, &at);
+        _snzr_paragraphPushLine(&fresh, &freshCount, &freshCapacity, line);
+    }
+
+    uint64_t keptCount = p->lineCount - resync;
+    uint64_t newCount = first + freshCount + keptCount;
+    while (p->lineCapacity < newCount) {
+        p->lineCapacity = SNZ_MAX(p->lineCapacity * 2, 64);
+        p->lines = realloc(p->lines, p->lineCapacity * sizeof(snzr_ParagraphLine));
+        SNZ_ASSERT(p->lines, "growing paragraph line table failed.");
+    }
+    memmove(&p->lines[first + freshCount], &p->lines[resync], keptCount * sizeof(snzr_ParagraphLine));
+    if (freshCount) {  // none when the edit resyncs right away, like removing whole lines from the front
+        memcpy(&p->lines[first], fresh, freshCount * sizeof(snzr_ParagraphLine));
+    }
+    for (uint64_t i = first + freshCount; i < newCount; i++) {
+        p->lines[i].start += delta;
+        p->lines[i].end += delta;
+    }
+    p->lineCount = newCount;
+    p->charCount = charCount;
+    free(fresh);
+}
+
+static float _snzr_paragraphLineHeight(const snzr_Paragraph* p) {
+    const snzr_Font* f = p->font;
+    return (f->lineGap + f->ascent - f->descent) * (p->height / f->renderedSize);
+}
+
+static uint64_t _snzr_paragraphVisibleLines(const snzr_Paragraph* p) {
+    return (p->maxLines && p->lineCount > p->maxLines) ? p->maxLines : p->lineCount;
+}
+
+// how many chars of the last shown line fit before the ellipsis, when maxLines cut the paragraph off
+static uint64_t _snzr_paragraphEllipsisCut(const snzr_Paragraph* p, const char* str, float* outWidth) {
+    const snzr_ParagraphLine* line = &p->lines[_snzr_paragraphVisibleLines(p) - 1];
+    float ellipsisWidth = snzr_strSize(p->font, _SNZR_PARAGRAPH_ELLIPSIS, strlen(_SNZR_PARAGRAPH_ELLIPSIS), p->height).X;
+    float scale = p->height / p->font->renderedSize;
+    float x = 0;
+    char prev = 0;
+    uint64_t end = line->start;
+    for (; end < line->end; end++) {
+        char c = str[end];
+        float kern = _snzr_fontKern(p->font, prev, c);
+        float next = x + kern + _snzr_fontAdvance(p->font, c, x + kern);
+        if (next * scale + ellipsisWidth > p->wrapWidth) {
+            break;
+        }
+        x = next;
+        prev = c;
+    }
+    *outWidth = x * scale + ellipsisWidth;
+    return end;
+}
+
+// widest shown line by shown line count, including the ellipsis if there is one
+HMM_Vec2 snzr_paragraphSize(const snzr_Paragraph* p, const char* str) {
+    uint64_t visible = _snzr_paragraphVisibleLines(p);
+    float width = 0;
+    for (uint64_t i = 0; i < visible; i++) {
+        width = SNZ_MAX(width, p->lines[i].width);
+    }
+    if (visible < p->lineCount) {
+        float cutWidth = 0;
+        _snzr_paragraphEllipsisCut(p, str, &cutWidth);
+        width = SNZ_MAX(width, cutWidth);
+    }
+    return HMM_V2(width, visible * _snzr_paragraphLineHeight(p));
+}
+
+// start is the same as for snzr_drawText. Only lines inside of the clip get drawn, so long text costs what's on screen.
+// each line goes through the text layout cache on its own, so lines that don't change stay laid out.
+void snzr_drawParagraph(const snzr_Paragraph* p,
+                        const char* str,
+                        HMM_Vec2 start,
+                        HMM_Vec2 clipStart,
+                        HMM_Vec2 clipEnd,
+                        HMM_Vec4 color,
+                        HMM_Mat4 vp) {
+    uint64_t visible = _snzr_paragraphVisibleLines(p);
+    float lineHeight = _snzr_paragraphLineHeight(p);
+    // rough, a line either side so that ascenders and descenders still make it in
+    // clamped as floats first, clips can be infinite
+    float firstLine = SNZ_MAX(floorf((clipStart.Y - start.Y) / lineHeight) - 1, 0.0f);
+    float lastLine = SNZ_MIN(ceilf((clipEnd.Y - start.Y) / lineHeight) + 1, (float)visible - 1);
+    int64_t firstShown = (int64_t)firstLine;
+    int64_t lastShown = (int64_t)lastLine;
+
+    for (int64_t i = firstShown; i <= lastShown; i++) {
+        const snzr_ParagraphLine* line = &p->lines[i];
+        HMM_Vec2 lineStart = HMM_V2(start.X, start.Y + i * lineHeight);
+        uint64_t end = line->end;
+        bool ellipsis = (uint64_t)i == visible - 1 && visible < p->lineCount;
+        if (ellipsis) {
+            float width = 0;
+            end = _snzr_paragraphEllipsisCut(p, str, &width);
+        }
+        snzr_drawTextScaled(lineStart, clipStart, clipEnd, color, &str[line->start], end - line->start, *p->font, vp, p->height, true);
+        if (ellipsis) {
+            float x = snzr_strSize(p->font, &str[line->start], end - line->start, p->height).X;
+            snzr_drawTextScaled(HMM_V2(lineStart.X + x, lineStart.Y), clipStart, clipEnd, color,
+                                _SNZR_PARAGRAPH_ELLIPSIS, strlen(_SNZR_PARAGRAPH_ELLIPSIS), *p->font, vp, p->height, true);
+        }
+    }
+}
+
+// FIXME: disgusting hack on the shader for this
+// see the section on memory layout here: https://www.khronos.org/opengl/wiki/Interface_Block_(GLSL)
+// where they just happen to say that vendors let a buffer of V3s fail. WHAT.
+// So that's why the pts are v4s. W component just gets forced to one in the shader because I didn't
+// want to (a) make user code deal with it or (b) have to reformat the pts into correct v4s before upload.
+// so sorry.
+void snzr_drawLineFaded(
+    HMM_Vec4* pts,
+    uint64_t ptCount,
+    HMM_Vec4 color,
+    float thickness,
+    HMM_Mat4 vp,
+    HMM_Vec3 falloffOrigin,
+    float falloffOffset,
+    float falloffDuration) {
+    if (ptCount < 2) {
+        return;
+    }
+    snzr_CmdList* list = _snzr_cmdTargetList();
+    _snzr_Cmd* cmd = _snzr_cmdPush(list, SNZR_CMD_LINE, vp);
+
+    HMM_Vec4* copied = SNZ_ARENA_PUSH_ARR(list->arena, ptCount + 2, HMM_Vec4);
+    memcpy(copied + 1, pts, ptCount * sizeof(HMM_Vec4));
+    HMM_Vec4 startMiter = HMM_Sub(pts[1], pts[0]);
+    startMiter = HMM_Mul(HMM_Norm(startMiter), 0.001f);
+    copied[0] = HMM_Sub(pts[0], startMiter);
+    HMM_Vec4 endMiter = HMM_Sub(pts[ptCount - 1], pts[ptCount - 2]);
+    endMiter = HMM_Mul(HMM_Norm(endMiter), 0.001f);
+    copied[ptCount + 1] = HMM_Add(pts[ptCount - 1], endMiter);
+
+    cmd->line.pts = copied;
+    cmd->line.ptCount = ptCount + 2;
+    cmd->line.color = color;
+    cmd->line.thickness = thickness;
+    cmd->line.falloffOrigin = falloffOrigin;
+    cmd->line.falloffOffset = falloffOffset;
+    cmd->line.falloffDuration = falloffDuration;
+    _snzr_cmdRecorded(list);
+}
+
+// end miters automatically added, pointing straight away
+void snzr_drawLine(HMM_Vec4* pts, uint64_t ptCount, HMM_Vec4 color, float thickness, HMM_Mat4 vp) {
+    snzr_drawLineFaded(pts, ptCount, color, thickness, vp, HMM_V3(0, 0, 0), INFINITY, INFINITY);
+}
+
+// lines added between begin and end go out in a single draw, each with its own color, thickness and falloff.
+// inside of a command list this is the same as calling snzr_drawLineFaded for each,
+// they get merged on submit either way, this just keeps immediate mode from flushing after every line.
+void snzr_lineBatchBegin(HMM_Mat4 vp) {
+    SNZ_ASSERT(!_snzr_cmdGlobs.lineBatchOpen, "line batch begun while another was open.");
+    _snzr_cmdGlobs.lineBatchOpen = true;
+    _snzr_cmdGlobs.lineBatchVP = vp;
+}
+
+void snzr_lineBatchAdd(
+    HMM_Vec4* pts,
+    uint64_t ptCount,
+    HMM_Vec4 color,
+    float thickness,
+    HMM_Vec3 falloffOrigin,
+    float falloffOffset,
+    float falloffDuration) {
+    SNZ_ASSERT(_snzr_cmdGlobs.lineBatchOpen, "adding to a line batch that wasn't begun.");
+    snzr_drawLineFaded(pts, ptCount, color, thickness, _snzr_cmdGlobs.lineBatchVP, falloffOrigin, falloffOffset, falloffDuration);
+}
+
+void snzr_lineBatchEnd() {
+    SNZ_ASSERT(_snzr_cmdGlobs.lineBatchOpen, "ending a line batch that wasn't begun.");
+    _snzr_cmdGlobs.lineBatchOpen = false;
+    _snzr_cmdRecorded(_snzr_cmdTargetList());
+}
+
+// a flat ring in the xy plane at center.z, thickness is in pixels. Fades like snzr_drawLineFaded,
+// from falloffOrigin to the closest point on the ring. One instance no matter the radius,
+// and neighbouring rings with the same vp go out in one draw when they're recorded into a list.
+void snzr_drawRingFaded(
+    HMM_Vec3 center,
+    float radius,
+    HMM_Vec4 color,
+    float thickness,
+    HMM_Mat4 vp,
+    HMM_Vec3 falloffOrigin,
+    float falloffOffset,
+    float falloffDuration) {
+    snzr_CmdList* list = _snzr_cmdTargetList();
+    _snzr_Cmd* cmd = _snzr_cmdPush(list, SNZR_CMD_RING, vp);
+    cmd->ring.inst = (_snzr_RingInstance){
+        .shape = HMM_V4(center.X, center.Y, center.Z, radius),
+        .color = color,
+        .falloffOrigin = HMM_V4(falloffOrigin.X, falloffOrigin.Y, falloffOrigin.Z, 0),
+        .params = HMM_V4(thickness, falloffOffset, falloffDuration, 0),
     };
-    snzr_callGLFnOrError(glGenFramebuffers(1, &out.glId));
-    snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, out.glId));
+    _snzr_cmdRecorded(list);
+}
 
-    snzr_callGLFnOrError(glActiveTexture(GL_TEXTURE0));
-    snzr_callGLFnOrError(glBindTexture(GL_TEXTURE_2D, tex.glId));
-    snzr_callGLFnOrError(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex.glId, 0));
+void snzr_drawRing(HMM_Vec3 center, float radius, HMM_Vec4 color, float thickness, HMM_Mat4 vp) {
+    snzr_drawRingFaded(center, radius, color, thickness, vp, center, INFINITY, INFINITY);
+}
 
-    snzr_callGLFnOrError(glGenRenderbuffers(1, &out.depthBufferId));
-    snzr_callGLFnOrError(glBindRenderbuffer(GL_RENDERBUFFER, out.depthBufferId));
-    snzr_callGLFnOrError(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32, tex.width, tex.height));
-    snzr_callGLFnOrError(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, out.depthBufferId));
+// draws a VAO with bound indices as triangles, shader is expected to take mat4 uniforms named uVP and uModel
+void snzr_drawMesh(uint32_t shaderId, uint32_t vaId, uint32_t indexCount, HMM_Mat4 vp, HMM_Mat4 model) {
+    snzr_CmdList* list = _snzr_cmdTargetList();
+    _snzr_Cmd* cmd = _snzr_cmdPush(list, SNZR_CMD_MESH, vp);
+    cmd->mesh.shaderId = shaderId;
+    cmd->mesh.vaId = vaId;
+    cmd->mesh.indexCount = indexCount;
+    cmd->mesh.model = model;
+    _snzr_cmdRecorded(list);
+}
 
-    SNZ_ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer gen failed.");
-    snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, 0));
-    return out;
+static int _snzr_cmdCompare(const void* a, const void* b) {
+    uint64_t keyA = (*(const _snzr_Cmd**)a)->sortKey;
+    uint64_t keyB = (*(const _snzr_Cmd**)b)->sortKey;
+    return (keyA > keyB) - (keyA < keyB);
 }
 
-void snzr_frameBufferDeinit(snzr_FrameBuffer* fb) {
-    glDeleteFramebuffers(1, &fb->glId);
-    glDeleteRenderbuffers(1, &fb->depthBufferId);
-    glDeleteTextures(1, &fb->texture.glId);
-    memset(fb, 0, sizeof(*fb));
+// returns cmds in the list in the order they should draw, allocated in the lists arena.
+// outInstanceCap gets an upper bound on the rect & glyph instances they expand to.
+static _snzr_Cmd** _snzr_cmdListSort(snzr_CmdList* list, uint64_t* outInstanceCap) {
+    _snzr_Cmd** sorted = SNZ_ARENA_PUSH_ARR(list->arena, list->count, _snzr_Cmd*);
+    uint64_t i = 0;
+    *outInstanceCap = 0;
+    for (_snzr_Cmd* cmd = list->first; cmd; cmd = cmd->next) {
+        sorted[i++] = cmd;
+        if (cmd->kind == SNZR_CMD_RECT) {
+            (*outInstanceCap)++;
+        } else if (cmd->kind == SNZR_CMD_GLYPH_RUN) {
+            *outInstanceCap += cmd->glyphRun.glyphCount;
+        }
+    }
+    qsort(sorted, list->count, sizeof(*sorted), _snzr_cmdCompare);
+    return sorted;
 }
 
-#define _SNZR_FONT_FIRST_ASCII 32
-#define _SNZR_FONT_ASCII_CHAR_COUNT (255 - _SNZR_FONT_FIRST_ASCII)
-#define _SNZR_FONT_UNKNOWN_CHAR 9633  // white box, see: https://www.fileformat.info/info/unicode/char/25a1/index.htm
+// writes one instance per visible char, returns how many were written
+static uint64_t _snzr_glyphRunExpand(const _snzr_Cmd* cmd, _snzr_RectInstance* out) {
+    uint64_t count = 0;
+    HMM_Vec2 start = cmd->glyphRun.start;
+    for (uint64_t i = 0; i < cmd->glyphRun.glyphCount; i++) {
+        const _snzr_GlyphQuad* g = &cmd->glyphRun.glyphs[i];
+        HMM_Vec2 dstStart = HMM_AddV2(start, g->dst.XY);
+        HMM_Vec2 dstEnd = HMM_AddV2(start, g->dst.ZW);
+        if (cmd->glyphRun.snap) {
+            dstStart.X = (int)dstStart.X;
+            dstStart.Y = (int)dstStart.Y;
+            dstEnd.X = (int)dstEnd.X;
+            dstEnd.Y = (int)dstEnd.Y;
+        }
 
-snzr_Font snzr_fontInit(snz_Arena* dataArena, snz_Arena* scratch, const char* path, float size) {
-    snzr_Font out = { .renderedSize = size };
+        // anything outside of the clip would just get clamped to nothing by the vertex shader
+        HMM_Vec4 clip = cmd->glyphRun.clip;
+        if (dstStart.X >= dstEnd.X || dstStart.Y >= dstEnd.Y ||
+            dstEnd.X <= clip.X || dstStart.X >= clip.Z || dstEnd.Y <= clip.Y || dstStart.Y >= clip.W) {
+            continue;
+        }
 
-    uint8_t* fileData;
-    {
-        FILE* file = fopen(path, "rb");
-        SNZ_ASSERT(file != NULL, "opening font file '%s' failed.");
+        out[count++] = (_snzr_RectInstance){
+            .dst = HMM_V4(dstStart.X, dstStart.Y, dstEnd.X, dstEnd.Y),
+            .src = g->src,
+            .clip = clip,
+            .color = cmd->glyphRun.color,
+            .params = HMM_V4(0, 0, 0, 1),
+        };
+    }
+    return count;
+}
 
-        fseek(file, 0L, SEEK_END);
-        uint64_t size = ftell(file);
-        fseek(file, 0L, SEEK_SET);
+static void _snzr_meshSubmit(const _snzr_Cmd* cmd) {
+    uint32_t id = cmd->mesh.shaderId;
+    snzr_callGLFnOrError(glUseProgram(id));
+    int loc = glGetUniformLocation(id, "uVP");
+    snzr_callGLFnOrError(glUniformMatrix4fv(loc, 1, false, (float*)&cmd->vp));
+    loc = glGetUniformLocation(id, "uModel");
+    snzr_callGLFnOrError(glUniformMatrix4fv(loc, 1, false, (float*)&cmd->mesh.model));
+
+    snzr_callGLFnOrError(glBindVertexArray(cmd->mesh.vaId));
+    snzr_callGLFnOrError(glDrawElements(GL_TRIANGLES, cmd->mesh.indexCount, GL_UNSIGNED_INT, NULL));
+    snzr_callGLFnOrError(glBindVertexArray(0));
+}
 
-        fileData = SNZ_ARENA_PUSH_ARR(scratch, size, uint8_t);
-        SNZ_ASSERT(fread(fileData, sizeof(uint8_t), size, file) == size, "reading font file failed.");
-        fclose(file);
+// a run of rects and glyphs, rings or lines that can go out in one draw, or a single mesh cmd
+typedef struct {
+    snzr_CmdKind kind;  // SNZR_CMD_RECT for rect & glyph batches
+    const _snzr_Cmd* cmd;  // only set for meshes
+    HMM_Mat4 vp;
+    uint32_t fontTextureId;  // zero means nothing in the batch has cared yet
+    uint32_t colorTextureId;
+    bool hasUntexturedRects;  // they'd sample colorTextureId too, so a batch can't have both
+    uint32_t features;  // _snzr_RectFeature bits, picks the shader permutation
+    uint64_t firstInstance;  // rect/ring instance, or line header
+    uint64_t instanceCount;
+    uint64_t firstVert;  // lines only
+    uint64_t vertCount;
+} _snzr_CmdBatch;
+
+// expects every point & header in the list to be uploaded already
+static void _snzr_lineBatchSubmit(const _snzr_CmdBatch* batch) {
+    uint32_t id = _snzr_globs.lineShaderId;
+    snzr_callGLFnOrError(glUseProgram(id));
+    glUniformMatrix4fv(glGetUniformLocation(id, "uVP"), 1, false, (float*)&batch->vp);
+    glUniform2f(glGetUniformLocation(id, "uResolution"), _snzr_globs.screenSize.X, _snzr_globs.screenSize.Y);
+    glUniform1i(glGetUniformLocation(id, "uFirstLine"), batch->firstInstance);
+    glUniform1i(glGetUniformLocation(id, "uLineCount"), batch->instanceCount);
+
+    snzr_callGLFnOrError(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _snzr_globs.lineShaderSSBOId));
+    snzr_callGLFnOrError(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _snzr_globs.lineHeaderSSBOId));
+    snzr_callGLFnOrError(glDrawArrays(GL_TRIANGLES, batch->firstVert, batch->vertCount));
+}
+
+static void _snzr_rectBatchSubmit(const _snzr_CmdBatch* batch, snz_Arena* scratch) {
+    uint32_t id = snzr_shaderPermutationGet(&_snzr_cmdGlobs.rectShaders, batch->features, scratch);
+    if (_snzr_rectShaderLocations[batch->features].programId != id) {
+        _snzr_rectShaderLocationsInit(batch->features, id);
     }
+    snzr_callGLFnOrError(glUseProgram(id));
+    glUniformMatrix4fv(_snzr_rectShaderLocations[batch->features].vp, 1, false, (float*)&batch->vp);
+    glUniform1f(_snzr_rectShaderLocations[batch->features].z, 0);
 
-    stbtt_fontinfo font;
-    stbtt_InitFont(&font, fileData, stbtt_GetFontOffsetForIndex(fileData, 0));
-    stbtt_GetScaledFontVMetrics(fileData, 0, out.renderedSize,
-                                &out.ascent,
-                                &out.descent,
-                                &out.lineGap);
+    glUniform1i(_snzr_rectShaderLocations[batch->features].fontTexture, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, batch->fontTextureId ? batch->fontTextureId : _snzr_globs.solidTex.glId);
+    glUniform1i(_snzr_rectShaderLocations[batch->features].colorTexture, 1);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, batch->colorTextureId ? batch->colorTextureId : _snzr_globs.solidTex.glId);
 
-    stbtt_pack_context ctx;
-    uint8_t* atlasData = SNZ_ARENA_PUSH_ARR(scratch, _SNZR_FONT_ATLAS_W * _SNZR_FONT_ATLAS_H, uint8_t);
-    assert(stbtt_PackBegin(&ctx, atlasData,
-        _SNZR_FONT_ATLAS_W,
-        _SNZR_FONT_ATLAS_H,
-        _SNZR_FONT_ATLAS_W,
-        1,
-        NULL));
-    stbtt_PackSetOversampling(&ctx, 1, 1);
+    snzr_callGLFnOrError(glBindVertexArray(_snzr_cmdGlobs.rectVaId));
+    snzr_callGLFnOrError(glBindBuffer(GL_ARRAY_BUFFER, _snzr_cmdGlobs.rectInstanceBufferId));
+    uint64_t offset = batch->firstInstance * sizeof(_snzr_RectInstance);
+    for (int i = 0; i < 6; i++) {
+        snzr_callGLFnOrError(glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, sizeof(_snzr_RectInstance), (void*)(offset + i * sizeof(HMM_Vec4))));
+    }
+    snzr_callGLFnOrError(glDrawArraysInstanced(GL_TRIANGLES, 0, 6, batch->instanceCount));
+    snzr_callGLFnOrError(glBindVertexArray(0));
+}
 
-    const int glyphCount = _SNZR_FONT_ASCII_CHAR_COUNT + 1;
-    int codepoints[glyphCount];
-    codepoints[0] = _SNZR_FONT_UNKNOWN_CHAR;
-    for (int i = 0; i < _SNZR_FONT_ASCII_CHAR_COUNT; i++) {
-        // skip 0, thats the missing glyph
-        codepoints[i + 1] = _SNZR_FONT_FIRST_ASCII + i;
+static void _snzr_ringBatchSubmit(const _snzr_CmdBatch* batch) {
+    uint32_t id = _snzr_cmdGlobs.ringShaderId;
+    snzr_callGLFnOrError(glUseProgram(id));
+    glUniformMatrix4fv(glGetUniformLocation(id, "uVP"), 1, false, (float*)&batch->vp);
+    int32_t viewport[4] = { 0 };
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glUniform2f(glGetUniformLocation(id, "uResolution"), viewport[2], viewport[3]);
+
+    snzr_callGLFnOrError(glBindVertexArray(_snzr_cmdGlobs.ringVaId));
+    snzr_callGLFnOrError(glBindBuffer(GL_ARRAY_BUFFER, _snzr_cmdGlobs.ringInstanceBufferId));
+    uint64_t offset = batch->firstInstance * sizeof(_snzr_RingInstance);
+    for (int i = 0; i < 4; i++) {
+        snzr_callGLFnOrError(glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, sizeof(_snzr_RingInstance), (void*)(offset + i * sizeof(HMM_Vec4))));
     }
+    snzr_callGLFnOrError(glDrawArraysInstanced(GL_TRIANGLES, 0, 6, batch->instanceCount));
+    snzr_callGLFnOrError(glBindVertexArray(0));
+}
 
-    out.packRange = (stbtt_pack_range){
-        .font_size = out.renderedSize,
-        .array_of_unicode_codepoints = codepoints,
-        .num_chars = glyphCount,
-        .chardata_for_range = SNZ_ARENA_PUSH_ARR(dataArena, glyphCount, stbtt_packedchar),
+// sorts, merges neighbouring rects and glyphs that share a vp and textures (and runs of rings or lines that share one),
+// and issues the GL calls.
+// uses whatever framebuffer and viewport are bound at the time. Scratch goes in the lists arena.
+void snzr_cmdListSubmit(snzr_CmdList* list) {
+    SNZ_ASSERT(list != _snzr_cmdGlobs.activeList, "submitting a command list that is still recording.");
+    if (list->count == 0) {
+        return;
+    }
+
+    uint64_t instanceCap = 0;
+    _snzr_Cmd** sorted = _snzr_cmdListSort(list, &instanceCap);
+
+    uint64_t linePtCap = 0;
+    for (uint64_t i = 0; i < list->count; i++) {
+        if (sorted[i]->kind == SNZR_CMD_LINE) {
+            linePtCap += sorted[i]->line.ptCount;
+        }
+    }
+
+    _snzr_RectInstance* instances = SNZ_ARENA_PUSH_ARR(list->arena, instanceCap, _snzr_RectInstance);
+    _snzr_RingInstance* rings = SNZ_ARENA_PUSH_ARR(list->arena, list->count, _snzr_RingInstance);
+    _snzr_LineHeader* lineHeaders = SNZ_ARENA_PUSH_ARR(list->arena, list->count, _snzr_LineHeader);
+    HMM_Vec4* linePts = SNZ_ARENA_PUSH_ARR(list->arena, linePtCap, HMM_Vec4);
+    _snzr_CmdBatch* batches = SNZ_ARENA_PUSH_ARR(list->arena, list->count, _snzr_CmdBatch);
+    uint64_t instanceCount = 0;
+    uint64_t ringCount = 0;
+    uint64_t lineCount = 0;
+    uint64_t linePtCount = 0;
+    uint64_t lineVertCount = 0;
+    uint64_t batchCount = 0;
+    for (uint64_t i = 0; i < list->count; i++) {
+        const _snzr_Cmd* cmd = sorted[i];
+        _snzr_CmdBatch* batch = batchCount ? &batches[batchCount - 1] : NULL;
+        snzr_CmdKind batchKind = (cmd->kind == SNZR_CMD_GLYPH_RUN) ? SNZR_CMD_RECT : cmd->kind;
+        bool sameVp = batch != NULL && memcmp(&batch->vp, &cmd->vp, sizeof(HMM_Mat4)) == 0;
+
+        if (cmd->kind == SNZR_CMD_MESH) {
+            batches[batchCount++] = (_snzr_CmdBatch){ .kind = SNZR_CMD_MESH, .cmd = cmd };
+            continue;
+        } else if (cmd->kind == SNZR_CMD_RING) {
+            if (!sameVp || batch->kind != SNZR_CMD_RING) {
+                batch = &batches[batchCount++];
+                *batch = (_snzr_CmdBatch){ .kind = SNZR_CMD_RING, .vp = cmd->vp, .firstInstance = ringCount };
+            }
+            rings[ringCount++] = cmd->ring.inst;
+            batch->instanceCount++;
+            continue;
+        } else if (cmd->kind == SNZR_CMD_LINE) {
+            if (!sameVp || batch->kind != SNZR_CMD_LINE) {
+                batch = &batches[batchCount++];
+                *batch = (_snzr_CmdBatch){ .kind = SNZR_CMD_LINE, .vp = cmd->vp, .firstInstance = lineCount, .firstVert = lineVertCount };
+            }
+            HMM_Vec3 o = cmd->line.falloffOrigin;
+            lineHeaders[lineCount++] = (_snzr_LineHeader){
+                .color = cmd->line.color,
+                .falloffOrigin = HMM_V4(o.X, o.Y, o.Z, cmd->line.thickness),
+                .falloffOffset = cmd->line.falloffOffset,
+                .falloffDuration = cmd->line.falloffDuration,
+                .firstPt = linePtCount,
+                .firstVert = lineVertCount,
+            };
+            memcpy(&linePts[linePtCount], cmd->line.pts, cmd->line.ptCount * sizeof(HMM_Vec4));
+            linePtCount += cmd->line.ptCount;
+            uint64_t verts = (cmd->line.ptCount - 3) * 6;  // two tris per segment, the miter points don't get one
+            lineVertCount += verts;
+            batch->instanceCount++;
+            batch->vertCount += verts;
+            continue;
+        }
+
+        uint32_t fontTex = (cmd->kind == SNZR_CMD_GLYPH_RUN) ? cmd->glyphRun.font->atlas.glId : 0;
+        uint32_t colorTex = (cmd->kind == SNZR_CMD_RECT) ? cmd->rect.textureId : 0;
+        if (colorTex == _snzr_globs.solidTex.glId) {
+            colorTex = 0;  // what plain boxes get, sampling it is a multiply by one, so they stay on the flat permutation
+        }
+        bool untexturedRect = cmd->kind == SNZR_CMD_RECT && !colorTex;
+        bool fits = sameVp && batch->kind == batchKind &&
+                    (!fontTex || !batch->fontTextureId || batch->fontTextureId == fontTex) &&
+                    (!colorTex || ((!batch->colorTextureId || batch->colorTextureId == colorTex) && !batch->hasUntexturedRects)) &&
+                    (!untexturedRect || !batch->colorTextureId);
+        if (!fits) {
+            batch = &batches[batchCount++];
+            *batch = (_snzr_CmdBatch){ .kind = SNZR_CMD_RECT, .vp = cmd->vp, .firstInstance = instanceCount };
+        }
+        if (fontTex) {
+            batch->fontTextureId = fontTex;
+        }
+        if (colorTex) {
+            batch->colorTextureId = colorTex;
+        }
+        if (untexturedRect) {
+            batch->hasUntexturedRects = true;
+        }
+        if (cmd->kind == SNZR_CMD_GLYPH_RUN) {
+            batch->features |= _SNZR_RF_GLYPH;
+        } else {
+            HMM_Vec4 params = cmd->rect.inst.params;
+            batch->features |= (colorTex ? _SNZR_RF_TEXTURED : 0) |
+                               (params.X > 0 ? _SNZR_RF_ROUNDED : 0) |
+                               (params.Y > 0 ? _SNZR_RF_BORDERED : 0);
+        }
+
+        uint64_t added = 0;
+        if (cmd->kind == SNZR_CMD_RECT) {
+            instances[instanceCount] = cmd->rect.inst;
+            added = 1;
+        } else {
+            added = _snzr_glyphRunExpand(cmd, &instances[instanceCount]);
+        }
+        instanceCount += added;
+        batch->instanceCount += added;
+    }
+
+    if (instanceCount) {
+        snzr_callGLFnOrError(glBindBuffer(GL_ARRAY_BUFFER, _snzr_cmdGlobs.rectInstanceBufferId));
+        snzr_callGLFnOrError(glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(_snzr_RectInstance), instances, GL_STREAM_DRAW));
+        snzr_resourceSetBytes(SNZR_RK_BUFFER, _snzr_cmdGlobs.rectInstanceBufferId, instanceCount * sizeof(_snzr_RectInstance));
+    }
+    if (ringCount) {
+        snzr_callGLFnOrError(glBindBuffer(GL_ARRAY_BUFFER, _snzr_cmdGlobs.ringInstanceBufferId));
+        snzr_callGLFnOrError(glBufferData(GL_ARRAY_BUFFER, ringCount * sizeof(_snzr_RingInstance), rings, GL_STREAM_DRAW));
+        snzr_resourceSetBytes(SNZR_RK_BUFFER, _snzr_cmdGlobs.ringInstanceBufferId, ringCount * sizeof(_snzr_RingInstance));
+    }
+    if (lineCount) {
+        snzr_callGLFnOrError(glBindBuffer(GL_SHADER_STORAGE_BUFFER, _snzr_globs.lineShaderSSBOId));
+        snzr_callGLFnOrError(glBufferData(GL_SHADER_STORAGE_BUFFER, linePtCount * sizeof(HMM_Vec4), linePts, GL_STREAM_DRAW));
+        snzr_callGLFnOrError(glBindBuffer(GL_SHADER_STORAGE_BUFFER, _snzr_globs.lineHeaderSSBOId));
+        snzr_callGLFnOrError(glBufferData(GL_SHADER_STORAGE_BUFFER, lineCount * sizeof(_snzr_LineHeader), lineHeaders, GL_STREAM_DRAW));
+        snzr_resourceSetBytes(SNZR_RK_BUFFER, _snzr_globs.lineShaderSSBOId, linePtCount * sizeof(HMM_Vec4));
+        snzr_resourceSetBytes(SNZR_RK_BUFFER, _snzr_globs.lineHeaderSSBOId, lineCount * sizeof(_snzr_LineHeader));
+    }
+
+    for (uint64_t i = 0; i < batchCount; i++) {
+        const _snzr_CmdBatch* batch = &batches[i];
+        if (batch->kind == SNZR_CMD_RECT) {
+            if (batch->instanceCount) {
+                _snzr_rectBatchSubmit(batch, list->arena);
+            }
+        } else if (batch->kind == SNZR_CMD_RING) {
+            _snzr_ringBatchSubmit(batch);
+        } else if (batch->kind == SNZR_CMD_LINE) {
+            _snzr_lineBatchSubmit(batch);
+        } else if (batch->kind == SNZR_CMD_MESH) {
+            _snzr_meshSubmit(batch->cmd);
+        }
+    }
+}
+
+// CPU rasterizer: draws a recorded command list into an RGBA8 buffer with no GL at all.
+// Follows the rect and line shaders (same SDF, clipping, miters and blend func) so the result can
+// be diffed against GL output. Color textures only exist on the GPU, so textured rects come out
+// as if they were untextured, and meshes and rings are skipped. Rect spans go 4 pixels at a time with SSE2
+// when it's available, and the target is cut into bands of rows that run on the job pool.
+
+typedef struct {
+    uint8_t* pixels;  // RGBA8, rows top to bottom
+    int32_t width;
+    int32_t height;
+} snzr_CpuTarget;
+
+#define _SNZR_CPU_BAND_ROWS 32
+#define _SNZR_CPU_FAR 1e30f  // infinite clips get clamped to this so that 0 * inf doesn't NaN the transform
+
+typedef enum {
+    _SNZR_CPU_PRIM_RECT,
+    _SNZR_CPU_PRIM_SEGMENT,
+} _snzr_CpuPrimKind;
+
+typedef struct {
+    _snzr_CpuPrimKind kind;
+    HMM_Vec4 bounds;  // min xy, max xy in target pixels, already clipped
+    union {
+        struct {
+            _snzr_RectInstance inst;  // positions and sizes converted to target pixels
+            const uint8_t* atlas;  // glyphs only
+            int32_t atlasWidth;
+            int32_t atlasHeight;
+        } rect;
+        struct {
+            HMM_Vec2 corners[4];  // start+, start-, end-, end+ in target pixels
+            HMM_Vec3 worldStart;
+            HMM_Vec3 worldEnd;
+            HMM_Vec4 color;
+            HMM_Vec3 falloffOrigin;
+            float falloffOffset;
+            float falloffDuration;
+        } segment;
     };
-    stbtt_PackFontRanges(&ctx, fileData, 0, &out.packRange, 1);
-    stbtt_PackEnd(&ctx);
+} _snzr_CpuPrim;
 
-    out.atlas = snzr_textureInitGrayscale(_SNZR_FONT_ATLAS_W, _SNZR_FONT_ATLAS_H, atlasData);
-    return out;
+typedef struct {
+    const _snzr_CpuPrim* prims;
+    uint64_t primCount;
+    snzr_CpuTarget* target;
+    int32_t rowStart;
+    int32_t rowEnd;
+} _snzr_CpuBand;
+
+void snzr_cpuTargetClear(snzr_CpuTarget* target, HMM_Vec4 color) {
+    uint8_t c[4] = {
+        (uint8_t)(HMM_Clamp(0, color.R, 1) * 255 + 0.5f),
+        (uint8_t)(HMM_Clamp(0, color.G, 1) * 255 + 0.5f),
+        (uint8_t)(HMM_Clamp(0, color.B, 1) * 255 + 0.5f),
+        (uint8_t)(HMM_Clamp(0, color.A, 1) * 255 + 0.5f),
+    };
+    uint64_t count = (uint64_t)target->width * target->height;
+    for (uint64_t i = 0; i < count; i++) {
+        memcpy(&target->pixels[i * 4], c, 4);
+    }
 }
 
-struct {
-    int vp;
-    int z;
-    int cornerRadius;
-    int borderThickness;
-    int borderColor;
-    int dstStart;
-    int dstEnd;
-    int srcStart;
-    int srcEnd;
-    int clipStart;
-    int clipEnd;
-    int color;
-    int fontTexture;
-    int colorTexture;
-} _snzr_rectShaderLocations;
-
-static void _snzr_rectShaderLocationsInit(uint32_t id) {
-    _snzr_rectShaderLocations.vp = glGetUniformLocation(id, "uVP");
-    _snzr_rectShaderLocations.z = glGetUniformLocation(id, "uZ");
-    _snzr_rectShaderLocations.cornerRadius = glGetUniformLocation(id, "uCornerRadius");
-    _snzr_rectShaderLocations.borderThickness = glGetUniformLocation(id, "uBorderThickness");
-    _snzr_rectShaderLocations.borderColor = glGetUniformLocation(id, "uBorderColor");
-    _snzr_rectShaderLocations.dstStart = glGetUniformLocation(id, "uDstStart");
-    _snzr_rectShaderLocations.dstEnd = glGetUniformLocation(id, "uDstEnd");
-    _snzr_rectShaderLocations.srcStart = glGetUniformLocation(id, "uSrcStart");
-    _snzr_rectShaderLocations.srcEnd = glGetUniformLocation(id, "uSrcEnd");
-    _snzr_rectShaderLocations.clipStart = glGetUniformLocation(id, "uClipStart");
-    _snzr_rectShaderLocations.clipEnd = glGetUniformLocation(id, "uClipEnd");
-    _snzr_rectShaderLocations.color = glGetUniformLocation(id, "uColor");
-    _snzr_rectShaderLocations.fontTexture = glGetUniformLocation(id, "uFontTexture");
-    _snzr_rectShaderLocations.colorTexture = glGetUniformLocation(id, "uColorTexture");
-}
-
-static void _snzr_init(snz_Arena* scratchArena) {
-    {  // initialize gl settings
-        gladLoadGL();
-        glLoadIdentity();
-        snzr_callGLFnOrError(glEnable(GL_DEPTH_TEST));
-        snzr_callGLFnOrError(glDepthFunc(GL_LESS | GL_EQUAL));
-        snzr_callGLFnOrError(glEnable(GL_BLEND));
-        snzr_callGLFnOrError(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-        snzr_callGLFnOrError(glEnable(GL_DEBUG_OUTPUT));
+static HMM_Vec2 _snzr_cpuToTarget(HMM_Mat4 vp, HMM_Vec4 p, const snzr_CpuTarget* target) {
+    HMM_Vec4 clip = HMM_MulM4V4(vp, p);
+    return HMM_V2((clip.X / clip.W + 1) * 0.5f * target->width, (1 - clip.Y / clip.W) * 0.5f * target->height);
+}
 
-        // snzr_callGLFnOrError(glEnable(GL_CULL_FACE));
-        // snzr_callGLFnOrError(glCullFace(GL_BACK));
-        // snzr_callGLFnOrError(glFrontFace(GL_CCW));
-        snzr_callGLFnOrError(glEnable(GL_MULTISAMPLE));
-        snzr_callGLFnOrError(glDebugMessageCallback(_snzr_glDebugCallback, 0));
+static void _snzr_cpuSwap(float* a, float* b) {
+    float t = *a;
+    *a = *b;
+    *b = t;
+}
 
-        snzr_callGLFnOrError(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-        snzr_callGLFnOrError(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+// returns false when nothing of the rect lands on the target
+static bool _snzr_cpuRectPrimInit(const _snzr_RectInstance* in, HMM_Mat4 vp, const snzr_CpuTarget* target, _snzr_CpuPrim* out) {
+    _snzr_RectInstance inst = *in;
+    HMM_Vec2 s = _snzr_cpuToTarget(vp, HMM_V4(in->dst.X, in->dst.Y, 0, 1), target);
+    HMM_Vec2 e = _snzr_cpuToTarget(vp, HMM_V4(in->dst.Z, in->dst.W, 0, 1), target);
+    if (s.X > e.X) {
+        _snzr_cpuSwap(&s.X, &e.X);
+        _snzr_cpuSwap(&inst.src.X, &inst.src.Z);
     }
+    if (s.Y > e.Y) {
+        _snzr_cpuSwap(&s.Y, &e.Y);
+        _snzr_cpuSwap(&inst.src.Y, &inst.src.W);
+    }
+    inst.dst = HMM_V4(s.X, s.Y, e.X, e.Y);
+
+    HMM_Vec4 c = in->clip;
+    c.X = HMM_Clamp(-_SNZR_CPU_FAR, c.X, _SNZR_CPU_FAR);
+    c.Y = HMM_Clamp(-_SNZR_CPU_FAR, c.Y, _SNZR_CPU_FAR);
+    c.Z = HMM_Clamp(-_SNZR_CPU_FAR, c.Z, _SNZR_CPU_FAR);
+    c.W = HMM_Clamp(-_SNZR_CPU_FAR, c.W, _SNZR_CPU_FAR);
+    HMM_Vec2 cs = _snzr_cpuToTarget(vp, HMM_V4(c.X, c.Y, 0, 1), target);
+    HMM_Vec2 ce = _snzr_cpuToTarget(vp, HMM_V4(c.Z, c.W, 0, 1), target);
+    inst.clip = HMM_V4(SNZ_MIN(cs.X, ce.X), SNZ_MIN(cs.Y, ce.Y), SNZ_MAX(cs.X, ce.X), SNZ_MAX(cs.Y, ce.Y));
+
+    // assumes a 2d vp without rotation, like the UI uses
+    float scale = fabsf(vp.Elements[0][0]) * 0.5f * target->width;
+    inst.params.X *= scale;
+    inst.params.Y *= scale;
+
+    out->kind = _SNZR_CPU_PRIM_RECT;
+    out->rect.inst = inst;
+    out->bounds = HMM_V4(
+        SNZ_MAX(SNZ_MAX(s.X, inst.clip.X), 0),
+        SNZ_MAX(SNZ_MAX(s.Y, inst.clip.Y), 0),
+        SNZ_MIN(SNZ_MIN(e.X, inst.clip.Z), target->width),
+        SNZ_MIN(SNZ_MIN(e.Y, inst.clip.W), target->height));
+    return out->bounds.X < out->bounds.Z && out->bounds.Y < out->bounds.W;
+}
 
-    {
-        const char* vertSrc =
-            "#version 330 core\n"
-            "out vec2 vUv;"
-            "out vec2 vCenterFromFragPos;"
-            "out vec2 vRectHalfSize;"
-            ""
-            "uniform mat4 uVP;"
-            "uniform float uZ;"
-            "uniform vec2 uDstStart;"
-            "uniform vec2 uDstEnd;"
-            "uniform vec2 uSrcStart;"
-            "uniform vec2 uSrcEnd;"
-            ""
-            "uniform vec2 uClipStart;"
-            "uniform vec2 uClipEnd;"
-            ""
-            "vec2 cornerTable[6] = vec2[]("
-            "    vec2(0, 0),"
-            "    vec2(0, 1),"
-            "    vec2(1, 1),"
-            "    vec2(1, 1),"
-            "    vec2(1, 0),"
-            "    vec2(0, 0)"
-            "    );"
-            ""
-            "void main() {"
-            "    vec2 uvPos = cornerTable[gl_VertexID % 6];"
-            "    uvPos *= uSrcEnd - uSrcStart;"
-            "    uvPos += uSrcStart;"
-            "    vUv = uvPos;"
-            ""
-            "    vec2 pos = cornerTable[gl_VertexID % 6];"
-            "    pos *= uDstEnd - uDstStart;"
-            "    pos += uDstStart;"
-            ""
-            "    vec2 startDiff = uClipStart - pos;"
-            "    startDiff = max(startDiff, vec2(0, 0));"
-            "    vec2 endDiff = uClipEnd - pos;"
-            "    endDiff = min(endDiff, vec2(0, 0));"
-            ""
-            "    vec2 totalDiff = startDiff + endDiff;"
-            "    vUv += totalDiff / (uDstEnd - uDstStart) * (uSrcEnd - uSrcStart);"
-            "    pos += totalDiff;"
-            ""
-            "    vRectHalfSize = (uDstEnd - uDstStart) / 2.0;"
-            "    vCenterFromFragPos = (uDstStart + vRectHalfSize) - pos;"
-            "    gl_Position = uVP * vec4(pos, uZ, 1);"
-            "};";
+// pts are the line cmds, end miters included. Returns false if the segment is degenerate or offscreen.
+static bool _snzr_cpuSegmentPrimInit(const _snzr_Cmd* cmd, uint64_t segment, const snzr_CpuTarget* target, _snzr_CpuPrim* out) {
+    HMM_Vec2 va[4];
+    for (int i = 0; i < 4; i++) {
+        HMM_Vec4 p = cmd->line.pts[segment + i];
+        va[i] = _snzr_cpuToTarget(cmd->vp, HMM_V4(p.X, p.Y, p.Z, 1), target);
+    }
 
-        const char* fragSrc =
-            "#version 330 core\n"
-            "out vec4 color;"
+    HMM_Vec2 vLine = HMM_NormV2(HMM_SubV2(va[2], va[1]));
+    HMM_Vec2 nvLine = HMM_V2(-vLine.Y, vLine.X);
+    float halfThickness = cmd->line.thickness * 0.5f;
+
+    HMM_Vec2 vPred = HMM_NormV2(HMM_SubV2(va[1], va[0]));
+    HMM_Vec2 miterStart = HMM_NormV2(HMM_AddV2(nvLine, HMM_V2(-vPred.Y, vPred.X)));
+    HMM_Vec2 offStart = HMM_MulV2F(miterStart, halfThickness / HMM_DotV2(miterStart, nvLine));
+
+    HMM_Vec2 vSucc = HMM_NormV2(HMM_SubV2(va[3], va[2]));
+    HMM_Vec2 miterEnd = HMM_NormV2(HMM_AddV2(nvLine, HMM_V2(-vSucc.Y, vSucc.X)));
+    HMM_Vec2 offEnd = HMM_MulV2F(miterEnd, halfThickness / HMM_DotV2(miterEnd, nvLine));
+
+    out->kind = _SNZR_CPU_PRIM_SEGMENT;
+    out->segment.corners[0] = HMM_AddV2(va[1], offStart);
+    out->segment.corners[1] = HMM_SubV2(va[1], offStart);
+    out->segment.corners[2] = HMM_SubV2(va[2], offEnd);
+    out->segment.corners[3] = HMM_AddV2(va[2], offEnd);
+    out->segment.worldStart = cmd->line.pts[segment + 1].XYZ;
+    out->segment.worldEnd = cmd->line.pts[segment + 2].XYZ;
+    out->segment.color = cmd->line.color;
+    out->segment.falloffOrigin = cmd->line.falloffOrigin;
+    out->segment.falloffOffset = cmd->line.falloffOffset;
+    out->segment.falloffDuration = cmd->line.falloffDuration;
+
+    HMM_Vec4 b = HMM_V4(INFINITY, INFINITY, -INFINITY, -INFINITY);
+    for (int i = 0; i < 4; i++) {
+        HMM_Vec2 c = out->segment.corners[i];
+        if (isnan(c.X) || isnan(c.Y)) {
+            return false;
+        }
+        b = HMM_V4(SNZ_MIN(b.X, c.X), SNZ_MIN(b.Y, c.Y), SNZ_MAX(b.Z, c.X), SNZ_MAX(b.W, c.Y));
+    }
+    out->bounds = HMM_V4(SNZ_MAX(b.X, 0), SNZ_MAX(b.Y, 0), SNZ_MIN(b.Z, target->width), SNZ_MIN(b.W, target->height));
+    return out->bounds.X < out->bounds.Z && out->bounds.Y < out->bounds.W;
+}
 
-            "in vec2 vUv;"
-            "in vec2 vCenterFromFragPos;"
-            "in vec2 vRectHalfSize;"
+static void _snzr_cpuBlend(uint8_t* px, HMM_Vec4 c) {
+    float a = HMM_Clamp(0, c.A, 1);
+    float inv = 1 - a;
+    px[0] = (uint8_t)(HMM_Clamp(0, c.R, 1) * 255 * a + px[0] * inv + 0.5f);
+    px[1] = (uint8_t)(HMM_Clamp(0, c.G, 1) * 255 * a + px[1] * inv + 0.5f);
+    px[2] = (uint8_t)(HMM_Clamp(0, c.B, 1) * 255 * a + px[2] * inv + 0.5f);
+    px[3] = (uint8_t)(a * a * 255 + px[3] * inv + 0.5f);
+}
+
+// bilinear, clamped to the edge
+static float _snzr_cpuSampleAtlas(const _snzr_CpuPrim* prim, float u, float v) {
+    int32_t w = prim->rect.atlasWidth;
+    int32_t h = prim->rect.atlasHeight;
+    float x = u * w - 0.5f;
+    float y = v * h - 0.5f;
+    int32_t x0 = (int32_t)floorf(x);
+    int32_t y0 = (int32_t)floorf(y);
+    float fx = x - x0;
+    float fy = y - y0;
+    int32_t xa = HMM_Clamp(0, x0, w - 1);
+    int32_t xb = HMM_Clamp(0, x0 + 1, w - 1);
+    int32_t ya = HMM_Clamp(0, y0, h - 1);
+    int32_t yb = HMM_Clamp(0, y0 + 1, h - 1);
+    const uint8_t* a = prim->rect.atlas;
+    float top = HMM_Lerp((float)a[ya * w + xa], fx, (float)a[ya * w + xb]);
+    float bottom = HMM_Lerp((float)a[yb * w + xa], fx, (float)a[yb * w + xb]);
+    return HMM_Lerp(top, fy, bottom) / 255.0f;
+}
+
+// same as the rect frag shader, false means discard
+static bool _snzr_cpuRectShade(const _snzr_CpuPrim* prim, float px, float py, HMM_Vec4* outColor) {
+    const _snzr_RectInstance* inst = &prim->rect.inst;
+    HMM_Vec2 start = inst->dst.XY;
+    HMM_Vec2 end = HMM_V2(inst->dst.Z, inst->dst.W);
+    HMM_Vec2 half = HMM_MulV2F(HMM_SubV2(end, start), 0.5f);
+    HMM_Vec2 c = HMM_SubV2(HMM_AddV2(start, half), HMM_V2(px, py));
+
+    float r = inst->params.X;
+    HMM_Vec2 d2 = HMM_V2(fabsf(c.X) - fabsf(half.X) + r, fabsf(c.Y) - fabsf(half.Y) + r);
+    float dist = SNZ_MIN(SNZ_MAX(d2.X, d2.Y), 0.0f) + HMM_LenV2(HMM_V2(SNZ_MAX(d2.X, 0.0f), SNZ_MAX(d2.Y, 0.0f))) - r;
+
+    HMM_Vec4 color = inst->color;
+    if (inst->params.W != 0) {
+        float u = inst->src.X + (px - start.X) / (end.X - start.X) * (inst->src.Z - inst->src.X);
+        float v = inst->src.Y + (py - start.Y) / (end.Y - start.Y) * (inst->src.W - inst->src.Y);
+        color.A *= _snzr_cpuSampleAtlas(prim, u, v);
+    }
+    // edge coverage, the target is in pixels so the fade is always one unit wide
+    if (inst->params.Y > 0) {
+        float t = HMM_Clamp(0, 0.5f + dist + inst->params.Y, 1);
+        HMM_Vec4 b = inst->borderColor;
+        float a = HMM_Lerp(color.A, t, b.A);
+        color.XYZ = HMM_DivV3F(HMM_LerpV3(HMM_MulV3F(color.XYZ, color.A), t, HMM_MulV3F(b.XYZ, b.A)), SNZ_MAX(a, 0.0001f));
+        color.A = a;
+    }
+    if (inst->params.X > 0 || inst->params.Y > 0) {
+        color.A *= HMM_Clamp(0, 0.5f - dist, 1);
+    }
+    if (color.A <= 0.01f) {
+        return false;
+    }
+    *outColor = color;
+    return true;
+}
+
+#ifdef _SNZR_CPU_SSE2
+// untextured rects only, 4 pixels per step, returns the first x it didn't get to
+static int32_t _snzr_cpuRectSpanSSE2(const _snzr_CpuPrim* prim, uint8_t* row, int32_t x, int32_t xEnd, float py) {
+    const _snzr_RectInstance* inst = &prim->rect.inst;
+    float halfX = (inst->dst.Z - inst->dst.X) * 0.5f;
+    float halfY = (inst->dst.W - inst->dst.Y) * 0.5f;
+    float centerX = inst->dst.X + halfX;
+    float r = inst->params.X;
+    float d2y = fabsf(inst->dst.Y + halfY - py) - fabsf(halfY) + r;
+
+    HMM_Vec4 fill = inst->color;
+    HMM_Vec4 border = inst->borderColor;
+    float fillA = HMM_Clamp(0, fill.A, 1);
+    float borderA = HMM_Clamp(0, border.A, 1);
+
+    __m128 vHalfX = _mm_set1_ps(fabsf(halfX));
+    __m128 vCenterX = _mm_set1_ps(centerX);
+    __m128 vR = _mm_set1_ps(r);
+    __m128 vD2y = _mm_set1_ps(d2y);
+    __m128 vD2yOut = _mm_set1_ps(SNZ_MAX(d2y, 0.0f));
+    __m128 vBorder = _mm_set1_ps(inst->params.Y);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1);
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128i byteMask = _mm_set1_epi32(0xff);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 alphaCutoff = _mm_set1_ps(0.01f);
+    __m128 c255 = _mm_set1_ps(255);
+    // plain rects skip edge coverage entirely, same as the shader permutation without the sdf
+    bool smoothEdges = inst->params.X > 0 || inst->params.Y > 0;
+    bool bordered = inst->params.Y > 0;
+
+    // premultiplied source terms for fill and border, mixed per lane by how far into the border it is
+    __m128 fR = _mm_set1_ps(HMM_Clamp(0, fill.R, 1) * 255 * fillA);
+    __m128 fG = _mm_set1_ps(HMM_Clamp(0, fill.G, 1) * 255 * fillA);
+    __m128 fB = _mm_set1_ps(HMM_Clamp(0, fill.B, 1) * 255 * fillA);
+    __m128 fA = _mm_set1_ps(fillA);
+    __m128 bR = _mm_sub_ps(_mm_set1_ps(HMM_Clamp(0, border.R, 1) * 255 * borderA), fR);
+    __m128 bG = _mm_sub_ps(_mm_set1_ps(HMM_Clamp(0, border.G, 1) * 255 * borderA), fG);
+    __m128 bB = _mm_sub_ps(_mm_set1_ps(HMM_Clamp(0, border.B, 1) * 255 * borderA), fB);
+    __m128 bA = _mm_sub_ps(_mm_set1_ps(borderA), fA);
+
+    for (; x + 4 <= xEnd; x += 4) {
+        __m128 px = _mm_add_ps(_mm_set_ps(x + 3, x + 2, x + 1, x), half);
+        __m128 d2x = _mm_add_ps(_mm_sub_ps(_mm_and_ps(_mm_sub_ps(vCenterX, px), absMask), vHalfX), vR);
+        __m128 inner = _mm_min_ps(_mm_max_ps(d2x, vD2y), zero);
+        __m128 ox = _mm_max_ps(d2x, zero);
+        __m128 outer = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(vD2yOut, vD2yOut)));
+        __m128 dist = _mm_sub_ps(_mm_add_ps(inner, outer), vR);
+
+        __m128 t = zero;
+        if (bordered) {
+            t = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_add_ps(half, dist), vBorder), zero), one);
+        }
+        __m128 cov = one;
+        if (smoothEdges) {
+            cov = _mm_min_ps(_mm_max_ps(_mm_sub_ps(half, dist), zero), one);
+        }
+        __m128 srcA = _mm_mul_ps(_mm_add_ps(fA, _mm_mul_ps(bA, t)), cov);
+        __m128 keep = _mm_cmpgt_ps(srcA, alphaCutoff);
+        if (_mm_movemask_ps(keep) == 0) {
+            continue;
+        }
+
+        __m128i dst = _mm_loadu_si128((__m128i*)(row + x * 4));
+        __m128 dr = _mm_cvtepi32_ps(_mm_and_si128(dst, byteMask));
+        __m128 dg = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(dst, 8), byteMask));
+        __m128 db = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(dst, 16), byteMask));
+        __m128 da = _mm_cvtepi32_ps(_mm_srli_epi32(dst, 24));
+
+        __m128 inv = _mm_sub_ps(one, srcA);
+        __m128 sr = _mm_mul_ps(_mm_add_ps(fR, _mm_mul_ps(bR, t)), cov);
+        __m128 sg = _mm_mul_ps(_mm_add_ps(fG, _mm_mul_ps(bG, t)), cov);
+        __m128 sb = _mm_mul_ps(_mm_add_ps(fB, _mm_mul_ps(bB, t)), cov);
+        __m128 sa = _mm_mul_ps(_mm_mul_ps(srcA, srcA), c255);
+        __m128i outR = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(sr, _mm_mul_ps(dr, inv)), half));
+        __m128i outG = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(sg, _mm_mul_ps(dg, inv)), half));
+        __m128i outB = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(sb, _mm_mul_ps(db, inv)), half));
+        __m128i outA = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(sa, _mm_mul_ps(da, inv)), half));
+        __m128i out = _mm_or_si128(_mm_or_si128(outR, _mm_slli_epi32(outG, 8)), _mm_or_si128(_mm_slli_epi32(outB, 16), _mm_slli_epi32(outA, 24)));
+
+        __m128i keepI = _mm_castps_si128(keep);
+        out = _mm_or_si128(_mm_and_si128(keepI, out), _mm_andnot_si128(keepI, dst));
+        _mm_storeu_si128((__m128i*)(row + x * 4), out);
+    }
+    return x;
+}
+#endif
+
+static void _snzr_cpuRectRows(const _snzr_CpuPrim* prim, snzr_CpuTarget* target, int32_t rowStart, int32_t rowEnd) {
+    HMM_Vec4 b = prim->bounds;
+    // pixel centers inside [min, max), same as GL picks them
+    int32_t x0 = (int32_t)ceilf(b.X - 0.5f);
+    int32_t x1 = (int32_t)ceilf(b.Z - 0.5f);
+    int32_t y0 = SNZ_MAX((int32_t)ceilf(b.Y - 0.5f), rowStart);
+    int32_t y1 = SNZ_MIN((int32_t)ceilf(b.W - 0.5f), rowEnd);
+    bool glyph = prim->rect.inst.params.W != 0;
+
+    for (int32_t y = y0; y < y1; y++) {
+        uint8_t* row = &target->pixels[(uint64_t)y * target->width * 4];
+        float py = y + 0.5f;
+        int32_t x = x0;
+#ifdef _SNZR_CPU_SSE2
+        if (!glyph) {
+            x = _snzr_cpuRectSpanSSE2(prim, row, x, x1, py);
+        }
+#endif
+        for (; x < x1; x++) {
+            HMM_Vec4 color;
+            if (_snzr_cpuRectShade(prim, x + 0.5f, py, &color)) {
+                _snzr_cpuBlend(&row[x * 4], color);
+            }
+        }
+    }
+}
+
+static float _snzr_cpuEdge(HMM_Vec2 a, HMM_Vec2 b, float px, float py) {
+    return (b.X - a.X) * (py - a.Y) - (b.Y - a.Y) * (px - a.X);
+}
 
-            "uniform vec4 uColor;"
-            "uniform sampler2D uFontTexture;"
-            "uniform sampler2D uColorTexture;"
-            "uniform float uCornerRadius;"
+// t holds how far along the segment each corner is (0 at the start, 1 at the end).
+// strictFirstEdge keeps the edge shared by a segments two triangles from getting drawn twice.
+static void _snzr_cpuSegmentTriRows(const _snzr_CpuPrim* prim, HMM_Vec2 a, HMM_Vec2 b, HMM_Vec2 c, HMM_Vec3 t, bool strictFirstEdge, snzr_CpuTarget* target, int32_t rowStart, int32_t rowEnd) {
+    float area = _snzr_cpuEdge(a, b, c.X, c.Y);
+    if (area == 0) {
+        return;
+    }
+    float sign = area > 0 ? 1 : -1;
+    area *= sign;
+
+    int32_t x0 = SNZ_MAX((int32_t)ceilf(SNZ_MIN(SNZ_MIN(a.X, b.X), c.X) - 0.5f), 0);
+    int32_t x1 = SNZ_MIN((int32_t)ceilf(SNZ_MAX(SNZ_MAX(a.X, b.X), c.X) - 0.5f), target->width);
+    int32_t y0 = SNZ_MAX((int32_t)ceilf(SNZ_MIN(SNZ_MIN(a.Y, b.Y), c.Y) - 0.5f), rowStart);
+    int32_t y1 = SNZ_MIN((int32_t)ceilf(SNZ_MAX(SNZ_MAX(a.Y, b.Y), c.Y) - 0.5f), rowEnd);
+
+    HMM_Vec4 color = prim->segment.color;
+    float duration = prim->segment.falloffDuration;
+    for (int32_t y = y0; y < y1; y++) {
+        uint8_t* row = &target->pixels[(uint64_t)y * target->width * 4];
+        float py = y + 0.5f;
+        for (int32_t x = x0; x < x1; x++) {
+            float px = x + 0.5f;
+            float wc = _snzr_cpuEdge(a, b, px, py) * sign;  // weight for c, the edge opposite it
+            float wa = _snzr_cpuEdge(b, c, px, py) * sign;
+            float wb = _snzr_cpuEdge(c, a, px, py) * sign;
+            bool inFirst = strictFirstEdge ? (wc > 0) : (wc >= 0);
+            if (!inFirst || wa < 0 || wb < 0) {
+                continue;
+            }
 
-            "uniform float uBorderThickness;"
-            "uniform vec4 uBorderColor;"
+            float alpha = 1;
+            if (!isinf(duration)) {
+                float along = (wa * t.X + wb * t.Y + wc * t.Z) / area;
+                HMM_Vec3 frag = HMM_LerpV3(prim->segment.worldStart, along, prim->segment.worldEnd);
+                float fromOrigin = HMM_LenV3(HMM_SubV3(frag, prim->segment.falloffOrigin));
+                alpha = SNZ_MIN(1, 1 + (1 / duration) * (-fromOrigin + prim->segment.falloffOffset));
+            }
+            _snzr_cpuBlend(&row[x * 4], HMM_V4(color.R, color.G, color.B, alpha * color.A));
+        }
+    }
+}
 
-            "float roundedRectSDF(float r) {"
-            "    vec2 d2 = abs(vCenterFromFragPos) - abs(vRectHalfSize) + vec2(r, r);"
-            "    return min(max(d2.x, d2.y), 0.0) + length(max(d2, 0.0)) - r;"
-            "}"
+static void _snzr_cpuBandJob(void* userData) {
+    _snzr_CpuBand* band = (_snzr_CpuBand*)userData;
+    for (uint64_t i = 0; i < band->primCount; i++) {
+        const _snzr_CpuPrim* prim = &band->prims[i];
+        if (prim->bounds.W <= band->rowStart || prim->bounds.Y >= band->rowEnd) {
+            continue;
+        }
+        if (prim->kind == _SNZR_CPU_PRIM_RECT) {
+            _snzr_cpuRectRows(prim, band->target, band->rowStart, band->rowEnd);
+        } else {
+            const HMM_Vec2* c = prim->segment.corners;
+            // same two triangles the line shader makes out of each segment
+            _snzr_cpuSegmentTriRows(prim, c[0], c[1], c[2], HMM_V3(0, 0, 1), false, band->target, band->rowStart, band->rowEnd);
+            _snzr_cpuSegmentTriRows(prim, c[0], c[2], c[3], HMM_V3(0, 1, 1), true, band->target, band->rowStart, band->rowEnd);
+        }
+    }
+}
 
-            "void main() {"
-            "    vec4 textureColor = texture(uColorTexture, vUv);"
-            "    vec4 fontColor = vec4(1.0, 1.0, 1.0, texture(uFontTexture, vUv).r);"
-            "    color = uColor * textureColor * fontColor;"
-
-            "    float dist = roundedRectSDF(uCornerRadius);"
-            "    if(dist > 0) {"
-            "        discard;"
-            "    } else if(dist > -uBorderThickness) {"
-            "        color = uBorderColor;"
-            "    }"
+// rasterizes a recorded (ended) list into target, blending over what's there already.
+// scratch goes in the lists arena. Uses the job pool when it's running, otherwise runs on the calling thread.
+void snzr_cpuRasterize(snzr_CmdList* list, snzr_CpuTarget* target) {
+    SNZ_ASSERT(list != _snzr_cmdGlobs.activeList, "rasterizing a command list that is still recording.");
+    if (list->count == 0) {
+        return;
+    }
 
-            "    if (color.a <= 0.01) { discard; }"
-            "};";
-        SNZ_LOG("loading rect shader.");
-        _snzr_globs.rectShaderId = snzr_shaderInit(vertSrc, fragSrc, scratchArena);
-        _snzr_rectShaderLocationsInit(_snzr_globs.rectShaderId);
+    uint64_t instanceCap = 0;
+    _snzr_Cmd** sorted = _snzr_cmdListSort(list, &instanceCap);
+    uint64_t primCap = instanceCap;
+    for (uint64_t i = 0; i < list->count; i++) {
+        if (sorted[i]->kind == SNZR_CMD_LINE) {
+            primCap += sorted[i]->line.ptCount - 3;
+        }
     }
 
-    {
-        const char* vertSrc =
-            "#version 460\n"
-            "struct lineVert {"
-            "    vec4 pos;"
-            "};"
+    _snzr_CpuPrim* prims = SNZ_ARENA_PUSH_ARR(list->arena, primCap, _snzr_CpuPrim);
+    _snzr_RectInstance* glyphs = SNZ_ARENA_PUSH_ARR(list->arena, instanceCap, _snzr_RectInstance);
+    uint64_t primCount = 0;
+    for (uint64_t i = 0; i < list->count; i++) {
+        const _snzr_Cmd* cmd = sorted[i];
+        if (cmd->kind == SNZR_CMD_RECT) {
+            primCount += _snzr_cpuRectPrimInit(&cmd->rect.inst, cmd->vp, target, &prims[primCount]);
+        } else if (cmd->kind == SNZR_CMD_GLYPH_RUN) {
+            const snzr_Font* font = cmd->glyphRun.font;
+            SNZ_ASSERT(font->atlasPixels != NULL, "cpu rasterizing text from a font without CPU side atlas pixels.");
+            uint64_t glyphCount = _snzr_glyphRunExpand(cmd, glyphs);
+            for (uint64_t j = 0; j < glyphCount; j++) {
+                _snzr_CpuPrim* prim = &prims[primCount];
+                if (_snzr_cpuRectPrimInit(&glyphs[j], cmd->vp, target, prim)) {
+                    prim->rect.atlas = font->atlasPixels;
+                    prim->rect.atlasWidth = font->atlas.width;
+                    prim->rect.atlasHeight = font->atlas.height;
+                    primCount++;
+                }
+            }
+        } else if (cmd->kind == SNZR_CMD_LINE) {
+            for (uint64_t seg = 0; seg < cmd->line.ptCount - 3; seg++) {
+                primCount += _snzr_cpuSegmentPrimInit(cmd, seg, target, &prims[primCount]);
+            }
+        }
+    }
 
-            "layout(std430, binding = 0) buffer vertBuffer {"
-            "    lineVert verts[];"
-            "};"
+    int32_t bandCount = (target->height + _SNZR_CPU_BAND_ROWS - 1) / _SNZR_CPU_BAND_ROWS;
+    _snzr_CpuBand* bands = SNZ_ARENA_PUSH_ARR(list->arena, bandCount, _snzr_CpuBand);
+    snz_JobGroup group = { 0 };
+    bool pooled = _snz_jobGlobs.mutex != NULL;
+    for (int32_t i = 0; i < bandCount; i++) {
+        bands[i] = (_snzr_CpuBand){
+            .prims = prims,
+            .primCount = primCount,
+            .target = target,
+            .rowStart = i * _SNZR_CPU_BAND_ROWS,
+            .rowEnd = SNZ_MIN((i + 1) * _SNZR_CPU_BAND_ROWS, target->height),
+        };
+        if (pooled) {
+            snz_jobGroupPush(&group, _snzr_cpuBandJob, &bands[i]);
+        } else {
+            _snzr_cpuBandJob(&bands[i]);
+        }
+    }
+    if (pooled) {
+        snz_jobGroupWait(&group);
+    }
+}
 
-            "uniform mat4 uVP;"
-            "uniform vec2 uResolution;"
-            "uniform float uThickness;"
+// GPU timing is done with timestamp queries so zones can nest. Each zone keeps a ring of query
+// pairs, and results are read back _SNZR_GPU_ZONE_FRAME_LAG - 1 frames late so that reading
+// them never waits on the GPU. If a result still isn't ready by then it's just dropped.
+#define _SNZR_GPU_ZONE_MAX 32
+#define _SNZR_GPU_ZONE_FRAME_LAG 4
+#define _SNZR_GPU_ZONE_HISTORY 120  // samples that averages and maxima are taken over
 
-            "out vec3 vFragPos;"
+typedef struct {
+    const char* name;
+    uint32_t beginQueries[_SNZR_GPU_ZONE_FRAME_LAG];
+    uint32_t endQueries[_SNZR_GPU_ZONE_FRAME_LAG];
+    bool issued[_SNZR_GPU_ZONE_FRAME_LAG];
 
-            "/* STOLEN FROM HERE: https://stackoverflow.com/questions/60440682/drawing-a-line-in-modern-opengl */"
-            "void main() {"
-            "    int line_i = gl_VertexID / 6;"
-            "    int tri_i  = gl_VertexID % 6;"
+    float history[_SNZR_GPU_ZONE_HISTORY];  // ms, ring buffer
+    int64_t historyCount;                   // total samples ever taken, index into history with % _SNZR_GPU_ZONE_HISTORY
+    int64_t droppedCount;
+} _snzr_GpuZone;
 
-            "    vec4 va[4];"
-            "    for (int i=0; i<4; ++i)"
-            "    {"
-            "        va[i] = uVP * vec4(verts[line_i+i].pos.xyz, 1);"
-            "        va[i].xyz /= va[i].w;"
-            "        va[i].xy = (va[i].xy + 1.0) * 0.5 * uResolution;"
-            "    }"
+typedef struct {
+    const char* name;
+    float lastMs;
+    float avgMs;  // over the last _SNZR_GPU_ZONE_HISTORY samples
+    float maxMs;  // over the last _SNZR_GPU_ZONE_HISTORY samples
+    int64_t sampleCount;
+    int64_t droppedCount;
+} snzr_GpuZoneStats;
 
-            "    vec2 v_line  = normalize(va[2].xy - va[1].xy);"
-            "    vec2 nv_line = vec2(-v_line.y, v_line.x);"
+struct {
+    _snzr_GpuZone zones[_SNZR_GPU_ZONE_MAX];
+    int64_t zoneCount;
 
-            "    vec4 pos;"
-            "    if (tri_i == 0 || tri_i == 1 || tri_i == 3)"
-            "    {"
-            "        vec2 v_pred  = normalize(va[1].xy - va[0].xy);"
-            "        vec2 v_miter = normalize(nv_line + vec2(-v_pred.y, v_pred.x));"
-            "        pos = va[1];"
-            "        pos.xy += v_miter * uThickness * (tri_i == 1 ? -0.5 : 0.5) / dot(v_miter, nv_line);"
-            "        vFragPos = verts[line_i + 1].pos.xyz;"  // FIXME: technically this isn't accounting for the width of the line in determning frag position, but I don't care rn
-            "    }"
-            "    else"
-            "    {"
-            "        vec2 v_succ  = normalize(va[3].xy - va[2].xy);"
-            "        vec2 v_miter = normalize(nv_line + vec2(-v_succ.y, v_succ.x));"
-            "        pos = va[2];"
-            "        pos.xy += v_miter * uThickness * (tri_i == 5 ? 0.5 : -0.5) / dot(v_miter, nv_line);"
-            "        vFragPos = verts[line_i + 2].pos.xyz;"  // FIXME: technically this isn't accounting for the width of the line in determning frag position, but I don't care rn
-            "    }"
-            "    pos.xy = pos.xy / uResolution * 2.0 - 1.0;"
-            "    pos.xyz *= pos.w;"
-            "    gl_Position = pos;"
-            "};";
-        const char* fragSrc =
-            "#version 330 core\n"
-            "out vec4 color;"
-            "uniform vec4 uColor;"
-            "uniform vec2 uResolution;"
-            "in vec3 vFragPos;"
-            "uniform vec3 uFalloffOrigin;"
-            "uniform float uFalloffOffset;"
-            "uniform float uFalloffDuration;"
+    _snzr_GpuZone* stack[_SNZR_GPU_ZONE_MAX];
+    int64_t stackDepth;
 
-            "void main() {"
-            "    vec3 diffVec = vFragPos - uFalloffOrigin;"
-            "    float alpha = min(1, 1 + (1 / uFalloffDuration) * (-length(diffVec) + uFalloffOffset));"
-            "    color = vec4(uColor.xyz, alpha * uColor.w);"
-            "};";
+    uint64_t frameIdx;
+} _snzr_gpuProfilerGlobs;
 
-        // FIXME: issues when lines go off screen
-        SNZ_LOG("loading line shader.");
-        _snzr_globs.lineShaderId = snzr_shaderInit(vertSrc, fragSrc, scratchArena);
+static _snzr_GpuZone* _snzr_gpuZoneGet(const char* name) {
+    for (int64_t i = 0; i < _snzr_gpuProfilerGlobs.zoneCount; i++) {
+        _snzr_GpuZone* z = &_snzr_gpuProfilerGlobs.zones[i];
+        if (z->name == name || strcmp(z->name, name) == 0) {
+            return z;
+        }
     }
 
-    snzr_callGLFnOrError(glGenBuffers(1, &_snzr_globs.lineShaderSSBOId));
-    snzr_callGLFnOrError(glBindBuffer(GL_SHADER_STORAGE_BUFFER, _snzr_globs.lineShaderSSBOId));
-    snzr_callGLFnOrError(glBufferData(GL_SHADER_STORAGE_BUFFER, 0, NULL, GL_DYNAMIC_DRAW));
+    SNZ_ASSERTF(_snzr_gpuProfilerGlobs.zoneCount < _SNZR_GPU_ZONE_MAX, "gpu zone '%s' failed, out of zones.", name);
+    _snzr_GpuZone* z = &_snzr_gpuProfilerGlobs.zones[_snzr_gpuProfilerGlobs.zoneCount];
+    _snzr_gpuProfilerGlobs.zoneCount++;
+    memset(z, 0, sizeof(*z));
+    z->name = name;
+    snzr_callGLFnOrError(glGenQueries(_SNZR_GPU_ZONE_FRAME_LAG, z->beginQueries));
+    snzr_callGLFnOrError(glGenQueries(_SNZR_GPU_ZONE_FRAME_LAG, z->endQueries));
+    return z;
+}
 
-    uint8_t solidTexData[] = { 255, 255, 255, 255 };
-    _snzr_globs.solidTex = snzr_textureInitRBGA(1, 1, solidTexData);
+// name should last forever (a literal is best), each zone can be timed once per frame
+// zones may nest, must be closed with snzr_gpuZoneEnd
+void snzr_gpuZoneBegin(const char* name) {
+    _snzr_GpuZone* z = _snzr_gpuZoneGet(name);
+    int64_t slot = _snzr_gpuProfilerGlobs.frameIdx % _SNZR_GPU_ZONE_FRAME_LAG;
+    SNZ_ASSERTF(!z->issued[slot], "gpu zone '%s' was timed twice in one frame.", name);
+    SNZ_ASSERT(_snzr_gpuProfilerGlobs.stackDepth < _SNZR_GPU_ZONE_MAX, "gpu zones nested too deep.");
+
+    snzr_callGLFnOrError(glQueryCounter(z->beginQueries[slot], GL_TIMESTAMP));
+    _snzr_gpuProfilerGlobs.stack[_snzr_gpuProfilerGlobs.stackDepth] = z;
+    _snzr_gpuProfilerGlobs.stackDepth++;
 }
 
-void snzr_drawRect(
-    HMM_Vec2 start,
-    HMM_Vec2 end,
-    HMM_Vec2 clipStart,
-    HMM_Vec2 clipEnd,
-    HMM_Vec4 color,
-    float cornerRadius,
-    float borderThickness,
-    HMM_Vec4 borderColor,
-    HMM_Mat4 vp,
-    snzr_Texture texture) {
-    // FIXME: layering system
-    // FIXME: error safe gl calls
-    snzr_callGLFnOrError(glUseProgram(_snzr_globs.rectShaderId));
+void snzr_gpuZoneEnd() {
+    SNZ_ASSERT(_snzr_gpuProfilerGlobs.stackDepth > 0, "gpu zone end without a begin.");
+    _snzr_gpuProfilerGlobs.stackDepth--;
+    _snzr_GpuZone* z = _snzr_gpuProfilerGlobs.stack[_snzr_gpuProfilerGlobs.stackDepth];
 
-    glUniformMatrix4fv(_snzr_rectShaderLocations.vp, 1, false, (float*)&vp);
-    glUniform1f(_snzr_rectShaderLocations.z, 0);
-    glUniform1f(_snzr_rectShaderLocations.cornerRadius, cornerRadius);
+    int64_t slot = _snzr_gpuProfilerGlobs.frameIdx % _SNZR_GPU_ZONE_FRAME_LAG;
+    snzr_callGLFnOrError(glQueryCounter(z->endQueries[slot], GL_TIMESTAMP));
+    z->issued[slot] = true;
+}
 
-    glUniform1f(_snzr_rectShaderLocations.borderThickness, borderThickness);
-    glUniform4f(_snzr_rectShaderLocations.borderColor, borderColor.X, borderColor.Y, borderColor.Z, borderColor.A);
+#define snzr_gpuZone(name) for (int _z_ = (snzr_gpuZoneBegin(name), 0); !_z_; _z_ += 1, snzr_gpuZoneEnd())
 
-    glUniform2f(_snzr_rectShaderLocations.dstStart, start.X, start.Y);
-    glUniform2f(_snzr_rectShaderLocations.dstEnd, end.X, end.Y);
+// called once per frame by snz_main, after all drawing
+// collects results from the oldest slot in the ring, which is about to get reused
+static void _snzr_gpuProfilerFrameEnd() {
+    if (_snzr_gpuProfilerGlobs.stackDepth != 0) {  // args get formatted even when asserts pass, so check first
+        SNZ_ASSERTF(false, "gpu zone '%s' wasn't ended before the end of the frame.", _snzr_gpuProfilerGlobs.stack[0]->name);
+    }
+    _snzr_gpuProfilerGlobs.frameIdx++;
+    int64_t slot = _snzr_gpuProfilerGlobs.frameIdx % _SNZR_GPU_ZONE_FRAME_LAG;
 
-    // flip vertically because we assume this is being used in pixel space, where 00 is in the UL corner
-    glUniform2f(_snzr_rectShaderLocations.srcStart, 0, 1);
-    glUniform2f(_snzr_rectShaderLocations.srcEnd, 1, 0);
+    for (int64_t i = 0; i < _snzr_gpuProfilerGlobs.zoneCount; i++) {
+        _snzr_GpuZone* z = &_snzr_gpuProfilerGlobs.zones[i];
+        if (!z->issued[slot]) {
+            continue;
+        }
+        z->issued[slot] = false;
 
-    glUniform2f(_snzr_rectShaderLocations.clipStart, clipStart.X, clipStart.Y);
-    glUniform2f(_snzr_rectShaderLocations.clipEnd, clipEnd.X, clipEnd.Y);
+        int32_t available = 0;
+        snzr_callGLFnOrError(glGetQueryObjectiv(z->endQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available));
+        if (!available) {
+            z->droppedCount++;
+            continue;
+        }
+        uint64_t begin = 0;
+        uint64_t end = 0;
+        snzr_callGLFnOrError(glGetQueryObjectui64v(z->beginQueries[slot], GL_QUERY_RESULT, &begin));
+        snzr_callGLFnOrError(glGetQueryObjectui64v(z->endQueries[slot], GL_QUERY_RESULT, &end));
+        z->history[z->historyCount % _SNZR_GPU_ZONE_HISTORY] = (end - begin) / 1000000.0;
+        z->historyCount++;
+    }
+}
 
-    glUniform4f(_snzr_rectShaderLocations.color, color.X, color.Y, color.Z, color.W);
+int64_t snzr_gpuZoneCount() {
+    return _snzr_gpuProfilerGlobs.zoneCount;
+}
 
-    glUniform1i(_snzr_rectShaderLocations.fontTexture, 0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, _snzr_globs.solidTex.glId);
+// idx of the zone for snzr_gpuZoneGetStats, -1 if it hasn't been timed yet
+int64_t snzr_gpuZoneFind(const char* name) {
+    for (int64_t i = 0; i < _snzr_gpuProfilerGlobs.zoneCount; i++) {
+        const char* zoneName = _snzr_gpuProfilerGlobs.zones[i].name;
+        if (zoneName == name || strcmp(zoneName, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
 
-    glUniform1i(_snzr_rectShaderLocations.colorTexture, 1);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture.glId);
+// idx should be less than snzr_gpuZoneCount(), zones are in the order they were first seen
+snzr_GpuZoneStats snzr_gpuZoneGetStats(int64_t idx) {
+    SNZ_ASSERTF(idx >= 0 && idx < _snzr_gpuProfilerGlobs.zoneCount, "gpu zone idx out of range: %lld", idx);
+    _snzr_GpuZone* z = &_snzr_gpuProfilerGlobs.zones[idx];
+    snzr_GpuZoneStats out = {
+        .name = z->name,
+        .sampleCount = z->historyCount,
+        .droppedCount = z->droppedCount,
+    };
 
-    snzr_callGLFnOrError(glDrawArrays(GL_TRIANGLES, 0, 6));
+    int64_t count = SNZ_MIN(z->historyCount, _SNZR_GPU_ZONE_HISTORY);
+    if (count == 0) {
+        return out;
+    }
+    float total = 0;
+    for (int64_t i = 0; i < count; i++) {
+        float ms = z->history[i];
+        total += ms;
+        out.maxMs = SNZ_MAX(out.maxMs, ms);
+    }
+    out.avgMs = total / count;
+    out.lastMs = z->history[(z->historyCount - 1) % _SNZR_GPU_ZONE_HISTORY];
+    return out;
 }
 
-static const stbtt_packedchar* _snzr_getGylphFromChar(const snzr_Font* font, char c) {
-    int glyph = c - _SNZR_FONT_FIRST_ASCII;
-    if (glyph < 0) {
-        return &font->packRange.chardata_for_range[0];  // first is unknown char
-    } else if (glyph >= _SNZR_FONT_ASCII_CHAR_COUNT) {
-        return &font->packRange.chardata_for_range[0];
+// writes one row per zone, asserts if the file can't be opened
+void snzr_gpuProfilerDumpCSV(const char* path) {
+    FILE* f = fopen(path, "w");
+    SNZ_ASSERTF(f != NULL, "opening gpu profile csv '%s' failed.", path);
+    fprintf(f, "zone,samples,dropped,last_ms,avg_ms,max_ms\n");
+    for (int64_t i = 0; i < snzr_gpuZoneCount(); i++) {
+        snzr_GpuZoneStats s = snzr_gpuZoneGetStats(i);
+        fprintf(f, "%s,%lld,%lld,%f,%f,%f\n", s.name, s.sampleCount, s.droppedCount, s.lastMs, s.avgMs, s.maxMs);
     }
-    return &font->packRange.chardata_for_range[glyph + 1];
+    fclose(f);
+    SNZ_LOGF("Wrote gpu profile to '%s'.", path);
 }
 
-HMM_Vec2 snzr_strSize(const snzr_Font* font, const char* str, uint64_t charCount, float targetHeight) {
-    float x = 0;
-    uint64_t lineCount = 1;
-    for (uint64_t i = 0; i < charCount; i++) {
-        char c = str[i];
-        if (c == '\n') {
-            lineCount++;
-            continue;
-        } else if (c == '\r') {
-            continue;
-        } else if (c == '\t') {
-            continue;  // TODO: what exactly should i be doing here?
-        }
-        const stbtt_packedchar* glyph = _snzr_getGylphFromChar(font, str[i]);
-        x += glyph->xadvance;
+// Picks a resolution scale for a target from how long a gpu zone that draws it takes, to hold that zone to a budget.
+// A PI controller on the budget error, in velocity form so that sitting clamped at min or max doesn't wind it up.
+// Zone timings trail by a few frames, so the gains are kept low enough not to oscillate over that lag.
+// Scales come out quantized so that the target doesn't change size (and shimmer) every frame.
+#define _SNZR_DYNRES_KP 0.2f
+#define _SNZR_DYNRES_KI 0.05f
+#define _SNZR_DYNRES_STEP 0.05f
+
+typedef struct {
+    const char* zoneName;
+    float budgetMs;
+    float minScale;
+    float maxScale;
+
+    float rawScale;  // unquantized controller output
+    float scale;     // what to render at, a multiple of _SNZR_DYNRES_STEP
+    float prevError;
+    int64_t lastSampleCount;
+    float lastMs;
+} snzr_DynamicResolution;
+
+// starts at maxScale. zoneName should last forever, like for snzr_gpuZone
+snzr_DynamicResolution snzr_dynamicResolutionInit(const char* zoneName, float budgetMs, float minScale, float maxScale) {
+    SNZ_ASSERT(budgetMs > 0, "dynamic resolution budget has to be positive.");
+    SNZ_ASSERT(minScale > 0 && minScale <= maxScale, "dynamic resolution scale range is invalid.");
+    return (snzr_DynamicResolution){
+        .zoneName = zoneName,
+        .budgetMs = budgetMs,
+        .minScale = minScale,
+        .maxScale = maxScale,
+        .rawScale = maxScale,
+        .scale = maxScale,
+    };
+}
+
+// call once a frame before sizing the target, returns the scale to use (also in d->scale).
+// only moves when the zone has a new timing, and the timing is for whatever scale was in use a few frames back.
+float snzr_dynamicResolutionUpdate(snzr_DynamicResolution* d) {
+    int64_t idx = snzr_gpuZoneFind(d->zoneName);
+    if (idx < 0) {
+        return d->scale;
     }
-    float scaleFactor = targetHeight / font->renderedSize;
-    return HMM_Mul(HMM_V2(x, lineCount * font->renderedSize), scaleFactor);
+    snzr_GpuZoneStats stats = snzr_gpuZoneGetStats(idx);
+    if (stats.sampleCount == d->lastSampleCount) {
+        return d->scale;
+    }
+    d->lastSampleCount = stats.sampleCount;
+    d->lastMs = stats.lastMs;
+
+    // relative, so the gains don't depend on the budget. Fill cost goes with scale squared, hence the sqrt.
+    float error = sqrtf(d->budgetMs / SNZ_MAX(stats.lastMs, 0.001f)) - 1;
+    error = SNZ_MIN(error, 1);
+    d->rawScale += _SNZR_DYNRES_KP * (error - d->prevError) + _SNZR_DYNRES_KI * error;
+    d->rawScale = SNZ_MAX(SNZ_MIN(d->rawScale, d->maxScale), d->minScale);
+    d->prevError = error;
+
+    float quantized = roundf(d->rawScale / _SNZR_DYNRES_STEP) * _SNZR_DYNRES_STEP;
+    d->scale = SNZ_MAX(SNZ_MIN(quantized, d->maxScale), d->minScale);
+    return d->scale;
 }
 
-// FIXME: disgusting function all the way down
-// always renders with upwards on text being -, so do a matmul if that isn't ideal
-// when snap is on, rects per char get snapped to integer lines
-// FIXME: font should be a const*
-void snzr_drawTextScaled(HMM_Vec2 start,
-                         HMM_Vec2 clipStart,
-                         HMM_Vec2 clipEnd,
-                         HMM_Vec4 color,
-                         const char* str,
-                         uint64_t charCount,
-                         snzr_Font font,
-                         HMM_Mat4 vp,
-                         float targetSize,
-                         bool snap) {
-    // FIXME: layering system
-    // FIXME: safe gl calls
-    snzr_callGLFnOrError(glUseProgram(_snzr_globs.rectShaderId));
-    glUniformMatrix4fv(_snzr_rectShaderLocations.vp, 1, false, (float*)&vp);
-    glUniform1f(_snzr_rectShaderLocations.z, 0);
-    glUniform4f(_snzr_rectShaderLocations.color, color.X, color.Y, color.Z, color.W);
-    glUniform1i(_snzr_rectShaderLocations.fontTexture, 0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, font.atlas.glId);
+// Frame capture without stalling: the screen is copied into one of a ring of pixel pack buffers,
+// and read out of it a frame or two later once a fence says the copy is done. Encoding and writing
+// the file happens on a worker, so the frame only pays for the copy out of the mapped buffer.
+// Files are QOI, which is lossless and quick to encode (there's no png writer vendored).
+// When every buffer in the ring is still waiting on the gpu the capture is dropped, not waited for.
+// Same for when the workers are behind by too many frames, each one holds a copy of the screen and more
+// while encoding, so a slow disk would otherwise grow memory without bound.
+#define _SNZR_CAPTURE_RING 3
+#define _SNZR_CAPTURE_MAX_JOBS 4
 
-    glUniform1f(_snzr_rectShaderLocations.cornerRadius, 0);
-    glUniform1f(_snzr_rectShaderLocations.borderThickness, 0);
-    glUniform4f(_snzr_rectShaderLocations.borderColor, 0, 0, 0, 0);
+typedef struct {
+    uint32_t pboId;
+    uint64_t pboBytes;
+    GLsync fence;  // null when the slot is free
+    uint32_t width;
+    uint32_t height;
+    char path[260];
+} _snzr_CaptureSlot;
 
-    glUniform2f(_snzr_rectShaderLocations.clipStart, clipStart.X, clipStart.Y);
-    glUniform2f(_snzr_rectShaderLocations.clipEnd, clipEnd.X, clipEnd.Y);
+typedef struct {
+    uint8_t* pixels;  // RGBA, top row first, freed by the job
+    uint32_t width;
+    uint32_t height;
+    char path[260];
+} _snzr_CaptureJob;
 
-    float scaleFactor = targetSize / font.renderedSize;
+typedef struct {
+    uint64_t requested;
+    uint64_t dropped;  // every slot was still in flight, or too many frames were still being written
+    uint64_t written;
+    uint64_t failed;   // the file couldn't be written
+} snzr_CaptureStats;
 
-    HMM_Vec2 drawPos = HMM_V2(start.X, start.Y);
-    assert(charCount < INT64_MAX);
-    for (const char* c = str; *c != 0; c++) {
-        if ((c - str) >= (int64_t)charCount) {
-            break;
-        }
-        if (*c == '\n') {
-            drawPos.Y += (font.lineGap + font.ascent - font.descent) * scaleFactor;
-            drawPos.X = start.X;
-            continue;
-        } else if (*c == '\r') {
+struct {
+    _snzr_CaptureSlot slots[_SNZR_CAPTURE_RING];
+    const char* requestedDir;  // for the frame being built, null when nothing was asked for
+    uint64_t frameIdx;
+    uint64_t requested;
+    uint64_t dropped;
+    const char* madeDir;  // last dir made, so it isn't made again every frame
+    SDL_atomic_t jobsInFlight;
+    SDL_atomic_t written;
+    SDL_atomic_t failed;
+} _snzr_captureGlobs;
+
+// captures this frame as it will be presented, once it's done being drawn.
+// Written to dir/frame_<n>.qoi, where n counts frames captured this run. dir is made if it doesn't exist, its parents aren't.
+// frames that end up not being presented (nothing changed, see snz_requestRedraw) aren't captured.
+void snzr_captureFrame(const char* dir) {
+    _snzr_captureGlobs.requestedDir = dir;
+}
+
+snzr_CaptureStats snzr_captureStatsGet() {
+    return (snzr_CaptureStats){
+        .requested = _snzr_captureGlobs.requested,
+        .dropped = _snzr_captureGlobs.dropped,
+        .written = (uint64_t)SDL_AtomicGet(&_snzr_captureGlobs.written),
+        .failed = (uint64_t)SDL_AtomicGet(&_snzr_captureGlobs.failed),
+    };
+}
+
+// https://qoiformat.org/qoi-specification.pdf
+static bool _snzr_qoiWrite(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height) {
+    uint64_t pixelCount = (uint64_t)width * height;
+    uint8_t* out = malloc(14 + pixelCount * 5 + 8);  // worst case is a full RGBA op per pixel
+    if (!out) {
+        return false;
+    }
+    uint64_t at = 0;
+    memcpy(out, "qoif", 4);
+    at += 4;
+    for (int i = 3; i >= 0; i--) {
+        out[at++] = (uint8_t)(width >> (i * 8));
+    }
+    for (int i = 3; i >= 0; i--) {
+        out[at++] = (uint8_t)(height >> (i * 8));
+    }
+    out[at++] = 4;  // channels
+    out[at++] = 0;  // srgb with linear alpha
+
+    uint8_t seen[64][4] = { 0 };
+    uint8_t prev[4] = { 0, 0, 0, 255 };
+    uint8_t run = 0;
+    for (uint64_t i = 0; i < pixelCount; i++) {
+        const uint8_t* px = &pixels[i * 4];
+        if (memcmp(px, prev, 4) == 0) {
+            run++;
+            if (run == 62 || i == pixelCount - 1) {
+                out[at++] = 0xc0 | (run - 1);
+                run = 0;
+            }
             continue;
         }
+        if (run > 0) {
+            out[at++] = 0xc0 | (run - 1);
+            run = 0;
+        }
 
-        HMM_Vec2 srcStart = HMM_V2(0, 0);
-        HMM_Vec2 srcEnd = HMM_V2(0, 0);
-        HMM_Vec2 dstStart = HMM_V2(0, 0);
-        HMM_Vec2 dstEnd = HMM_V2(0, 0);
-        {
-            const stbtt_packedchar* b = _snzr_getGylphFromChar(&font, *c);
+        uint8_t hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (memcmp(seen[hash], px, 4) == 0) {
+            out[at++] = hash;
+        } else if (px[3] == prev[3]) {
+            int8_t dr = (int8_t)(px[0] - prev[0]);
+            int8_t dg = (int8_t)(px[1] - prev[1]);
+            int8_t db = (int8_t)(px[2] - prev[2]);
+            int8_t drg = (int8_t)(dr - dg);
+            int8_t dbg = (int8_t)(db - dg);
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                out[at++] = 0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+            } else if (drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 && dbg >= -8 && dbg <= 7) {
+                out[at++] = 0x80 | (dg + 32);
+                out[at++] = (drg + 8) << 4 | (dbg + 8);
+            } else {
+                out[at++] = 0xfe;
+                memcpy(&out[at], px, 3);
+                at += 3;
+            }
+        } else {
+            out[at++] = 0xff;
+            memcpy(&out[at], px, 4);
+            at += 4;
+        }
+        memcpy(seen[hash], px, 4);
+        memcpy(prev, px, 4);
+    }
+    uint8_t end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    memcpy(&out[at], end, 8);
+    at += 8;
+
+    FILE* f = fopen(path, "wb");
+    bool ok = f && fwrite(out, 1, at, f) == at;
+    if (f) {
+        fclose(f);
+    }
+    free(out);
+    return ok;
+}
 
-            HMM_Vec2 s = HMM_MulV2F(HMM_V2(b->xoff, b->yoff), scaleFactor);
-            HMM_Vec2 e = HMM_MulV2F(HMM_V2(b->xoff2, b->yoff2), scaleFactor);
-            dstStart = HMM_AddV2(drawPos, s);
-            dstEnd = HMM_AddV2(dstStart, HMM_Sub(e, s));
+static void _snzr_captureJob(void* userData) {
+    _snzr_CaptureJob* job = (_snzr_CaptureJob*)userData;
+    bool ok = _snzr_qoiWrite(job->path, job->pixels, job->width, job->height);
+    SDL_AtomicAdd(ok ? &_snzr_captureGlobs.written : &_snzr_captureGlobs.failed, 1);
+    free(job->pixels);
+    free(job);
+    SDL_AtomicAdd(&_snzr_captureGlobs.jobsInFlight, -1);
+}
 
-            HMM_Vec2 uvScale = HMM_V2(1.0f / font.atlas.width, 1.0f / font.atlas.height);
-            srcStart = HMM_MulV2(HMM_V2(b->x0, b->y0), uvScale);
-            srcEnd = HMM_MulV2(HMM_V2(b->x1, b->y1), uvScale);
+// copies a finished readback out of its buffer and hands it to a worker to write
+static void _snzr_captureSlotCollect(_snzr_CaptureSlot* slot) {
+    glDeleteSync(slot->fence);
+    slot->fence = NULL;
+
+    _snzr_CaptureJob* job = malloc(sizeof(_snzr_CaptureJob));
+    SNZ_ASSERT(job, "allocating capture job failed.");
+    job->width = slot->width;
+    job->height = slot->height;
+    strcpy(job->path, slot->path);
+    uint64_t rowBytes = (uint64_t)slot->width * 4;
+    job->pixels = malloc(rowBytes * slot->height);
+    SNZ_ASSERT(job->pixels, "allocating capture pixels failed.");
+
+    snzr_callGLFnOrError(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pboId));
+    const uint8_t* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rowBytes * slot->height, GL_MAP_READ_BIT);
+    SNZ_ASSERT(src != NULL, "mapping capture buffer failed.");
+    for (uint32_t y = 0; y < slot->height; y++) {  // gl rows go bottom up
+        memcpy(&job->pixels[y * rowBytes], &src[(slot->height - 1 - y) * rowBytes], rowBytes);
+    }
+    snzr_callGLFnOrError(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+    snzr_callGLFnOrError(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    SDL_AtomicAdd(&_snzr_captureGlobs.jobsInFlight, 1);
+    snz_jobPush(_snzr_captureJob, job);
+}
 
-            drawPos.X += b->xadvance * scaleFactor;
+// called once per frame by snz_main, after drawing. Starts this frame's readback if one was asked for
+// and it's being presented, and collects the ones that have finished since.
+static void _snzr_captureUpdate(bool presented) {
+    for (int64_t i = 0; i < _SNZR_CAPTURE_RING; i++) {
+        _snzr_CaptureSlot* slot = &_snzr_captureGlobs.slots[i];
+        if (slot->fence && glClientWaitSync(slot->fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+            _snzr_captureSlotCollect(slot);
         }
-        if (snap) {
-            dstStart.X = (int)dstStart.X;
-            dstStart.Y = (int)dstStart.Y;
-            dstEnd.X = (int)dstEnd.X;
-            dstEnd.Y = (int)dstEnd.Y;
+    }
+
+    const char* dir = _snzr_captureGlobs.requestedDir;
+    _snzr_captureGlobs.requestedDir = NULL;
+    if (!dir || !presented) {
+        return;
+    }
+    _snzr_captureGlobs.requested++;
+
+    _snzr_CaptureSlot* slot = NULL;
+    for (int64_t i = 0; i < _SNZR_CAPTURE_RING; i++) {
+        if (!_snzr_captureGlobs.slots[i].fence) {
+            slot = &_snzr_captureGlobs.slots[i];
+            break;
         }
+    }
+    if (!slot || SDL_AtomicGet(&_snzr_captureGlobs.jobsInFlight) >= _SNZR_CAPTURE_MAX_JOBS) {
+        _snzr_captureGlobs.dropped++;
+        return;
+    }
+
+    if (dir != _snzr_captureGlobs.madeDir) {
+        _SNZ_MKDIR(dir);  // failing because it's there is fine, anything else shows up as failed writes
+        _snzr_captureGlobs.madeDir = dir;
+    }
+
+    slot->width = (uint32_t)_snzr_globs.screenSize.X;
+    slot->height = (uint32_t)_snzr_globs.screenSize.Y;
+    int pathLength = snprintf(slot->path, sizeof(slot->path), "%s/frame_%06llu.qoi", dir, _snzr_captureGlobs.frameIdx);
+    SNZ_ASSERTF(pathLength < (int)sizeof(slot->path), "capture path too long, dir was '%s'.", dir);
+    _snzr_captureGlobs.frameIdx++;
 
-        glUniform2f(_snzr_rectShaderLocations.srcStart, srcStart.X, srcStart.Y);
-        glUniform2f(_snzr_rectShaderLocations.srcEnd, srcEnd.X, srcEnd.Y);
-        glUniform2f(_snzr_rectShaderLocations.dstStart, dstStart.X, dstStart.Y);
-        glUniform2f(_snzr_rectShaderLocations.dstEnd, dstEnd.X, dstEnd.Y);
-        snzr_callGLFnOrError(glDrawArrays(GL_TRIANGLES, 0, 6));
+    uint64_t bytes = (uint64_t)slot->width * slot->height * 4;
+    if (!slot->pboId) {
+        snzr_callGLFnOrError(glGenBuffers(1, &slot->pboId));
+        snzr_resourceTrack(SNZR_RK_BUFFER, slot->pboId, 0);
     }
+    snzr_callGLFnOrError(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pboId));
+    if (slot->pboBytes != bytes) {
+        snzr_callGLFnOrError(glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ));
+        snzr_resourceSetBytes(SNZR_RK_BUFFER, slot->pboId, bytes);
+        slot->pboBytes = bytes;
+    }
+    snzr_callGLFnOrError(glBindFramebuffer(GL_READ_FRAMEBUFFER, _snzr_globs.screenFrameBufferId));
+    snzr_callGLFnOrError(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    snzr_callGLFnOrError(glReadPixels(0, 0, slot->width, slot->height, GL_RGBA, GL_UNSIGNED_BYTE, NULL));  // into the pbo
+    snzr_callGLFnOrError(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
 
-// default to use for UI in 2d pixel space
-void snzr_drawText(HMM_Vec2 start,
-                   HMM_Vec2 clipStart,
-                   HMM_Vec2 clipEnd,
-                   HMM_Vec4 color,
-                   const char* str,
-                   uint64_t charCount,
-                   snzr_Font font,
-                   HMM_Mat4 vp) {
-    snzr_drawTextScaled(start, clipStart, clipEnd, color, str, charCount, font, vp, font.renderedSize, true);
+// waits out and writes whatever captures are still in flight, call before the job system goes away
+static void _snzr_captureDeinit() {
+    for (int64_t i = 0; i < _SNZR_CAPTURE_RING; i++) {
+        _snzr_CaptureSlot* slot = &_snzr_captureGlobs.slots[i];
+        if (slot->fence) {
+            glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+            _snzr_captureSlotCollect(slot);
+        }
+        snzr_resourceRelease(SNZR_RK_BUFFER, slot->pboId);
+        slot->pboId = 0;
+        slot->pboBytes = 0;
+    }
 }
 
-// FIXME: disgusting hack on the shader for this
-// see the section on memory layout here: https://www.khronos.org/opengl/wiki/Interface_Block_(GLSL)
-// where they just happen to say that vendors let a buffer of V3s fail. WHAT.
-// So that's why the pts are v4s. W component just gets forced to one in the shader because I didn't
-// want to (a) make user code deal with it or (b) have to reformat the pts into correct v4s before upload.
-// so sorry.
-void snzr_drawLineFaded(
-    HMM_Vec4* pts,
-    uint64_t ptCount,
-    HMM_Vec4 color,
-    float thickness,
-    HMM_Mat4 vp,
-    HMM_Vec3 falloffOrigin,
-    float falloffOffset,
-    float falloffDuration) {
-    if (ptCount < 2) {
-        return;
+// A pass graph for a frame's offscreen rendering. Passes say which targets they read and which one they
+// draw into, and how it gets cleared. Executing the graph then:
+//     orders passes so that everything writing a target runs before anything reading it
+//         (writers of the same target run in the order they were added),
+//     skips passes nothing kept ends up reading,
+//     acquires targets from a framebuffer pool right before their first use and gives them back after
+//         their last, so targets that are never alive at the same time share a framebuffer,
+//     binds, sets the viewport, clears and sets the depth mask for each pass, resolves aa after it,
+//         and times it as a gpu zone under its name. The screen is bound again once it's done.
+// Graphs live for one frame, targets that are kept are valid until the pools snzr_frameBufferPoolFrameEnd.
+#define _SNZR_PASS_MAX 32
+#define _SNZR_PASS_MAX_TARGETS 32
+#define _SNZR_PASS_MAX_INPUTS 4
+
+typedef struct snzr_PassGraph snzr_PassGraph;
+typedef void (*snzr_PassFunc)(const snzr_PassGraph* graph, void* userData);
+
+typedef int64_t snzr_PassTarget;  // index into the graph's targets
+
+typedef struct {
+    const char* name;  // also the gpu zone it's timed under
+    snzr_PassFunc func;
+    void* userData;  // has to last until snzr_passGraphExecute
+
+    snzr_PassTarget output;
+    snzr_PassTarget inputs[_SNZR_PASS_MAX_INPUTS];
+    int64_t inputCount;
+
+    bool clear;  // color and depth
+    HMM_Vec4 clearColor;
+    bool noDepthWrite;
+} snzr_PassDesc;
+
+typedef struct {
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    bool keep;  // read after the graph, so it counts as used and is never given back early
+
+    // filled in by execute
+    bool needed;
+    int64_t firstUse;  // in execution order, -1 if unused
+    int64_t lastUse;
+    snzr_FrameBufferRegion region;
+} _snzr_PassTargetInfo;
+
+struct snzr_PassGraph {
+    snzr_FrameBufferPool* pool;
+    snzr_PassDesc passes[_SNZR_PASS_MAX];
+    int64_t passCount;
+    _snzr_PassTargetInfo targets[_SNZR_PASS_MAX_TARGETS];
+    int64_t targetCount;
+
+    int64_t order[_SNZR_PASS_MAX];  // pass indices in execution order, filled in by execute
+    int64_t orderCount;
+    int64_t skippedCount;
+};
+
+// targets come out of pool. Big, zeroing it on the stack is fine but don't copy it around
+void snzr_passGraphInit(snzr_PassGraph* graph, snzr_FrameBufferPool* pool) {
+    memset(graph, 0, sizeof(*graph));
+    graph->pool = pool;
+}
+
+// a width x height color + depth target that only exists while passes are using it
+snzr_PassTarget snzr_passGraphTarget(snzr_PassGraph* graph, const char* name, uint32_t width, uint32_t height) {
+    SNZ_ASSERTF(graph->targetCount < _SNZR_PASS_MAX_TARGETS, "pass graph out of targets, max is %d.", _SNZR_PASS_MAX_TARGETS);
+    graph->targets[graph->targetCount] = (_snzr_PassTargetInfo){ .name = name, .width = width, .height = height };
+    return graph->targetCount++;
+}
+
+// marks a target as read after the graph is done, i.e. shown in a box. Passes only run if they lead to one of these.
+void snzr_passGraphKeep(snzr_PassGraph* graph, snzr_PassTarget target) {
+    SNZ_ASSERTF(target >= 0 && target < graph->targetCount, "invalid pass target %lld.", target);
+    graph->targets[target].keep = true;
+}
+
+void snzr_passGraphAdd(snzr_PassGraph* graph, snzr_PassDesc desc) {
+    SNZ_ASSERTF(graph->passCount < _SNZR_PASS_MAX, "pass graph out of passes, max is %d.", _SNZR_PASS_MAX);
+    SNZ_ASSERTF(desc.output >= 0 && desc.output < graph->targetCount, "pass '%s' has an invalid output.", desc.name);
+    SNZ_ASSERTF(desc.inputCount <= _SNZR_PASS_MAX_INPUTS, "pass '%s' has too many inputs.", desc.name);
+    for (int64_t i = 0; i < desc.inputCount; i++) {
+        SNZ_ASSERTF(desc.inputs[i] >= 0 && desc.inputs[i] < graph->targetCount, "pass '%s' has an invalid input.", desc.name);
+        SNZ_ASSERTF(desc.inputs[i] != desc.output, "pass '%s' reads the target it draws into.", desc.name);
     }
-    snzr_callGLFnOrError(glUseProgram(_snzr_globs.lineShaderId));
+    graph->passes[graph->passCount++] = desc;
+}
 
-    int loc = glGetUniformLocation(_snzr_globs.lineShaderId, "uColor");
-    glUniform4f(loc, color.X, color.Y, color.Z, color.W);
-    loc = glGetUniformLocation(_snzr_globs.lineShaderId, "uThickness");
-    glUniform1f(loc, thickness);
-    loc = glGetUniformLocation(_snzr_globs.lineShaderId, "uVP");
-    glUniformMatrix4fv(loc, 1, false, (float*)&vp);
-    loc = glGetUniformLocation(_snzr_globs.lineShaderId, "uResolution");
-    glUniform2f(loc, _snzr_globs.screenSize.X, _snzr_globs.screenSize.Y);
+// only valid inside pass funcs for the pass's own inputs and output, and after execute for kept targets
+snzr_FrameBufferRegion snzr_passGraphTargetRegion(const snzr_PassGraph* graph, snzr_PassTarget target) {
+    SNZ_ASSERTF(target >= 0 && target < graph->targetCount, "invalid pass target %lld.", target);
+    const _snzr_PassTargetInfo* t = &graph->targets[target];
+    SNZ_ASSERTF(t->region.frameBuffer.glId != 0, "pass target '%s' isn't allocated right now.", t->name);
+    return t->region;
+}
 
-    loc = glGetUniformLocation(_snzr_globs.lineShaderId, "uFalloffOrigin");
-    glUniform3f(loc, falloffOrigin.X, falloffOrigin.Y, falloffOrigin.Z);
-    loc = glGetUniformLocation(_snzr_globs.lineShaderId, "uFalloffOffset");
-    glUniform1f(loc, falloffOffset);
-    loc = glGetUniformLocation(_snzr_globs.lineShaderId, "uFalloffDuration");
-    glUniform1f(loc, falloffDuration);
+static bool _snzr_passReads(const snzr_PassDesc* pass, snzr_PassTarget target) {
+    for (int64_t i = 0; i < pass->inputCount; i++) {
+        if (pass->inputs[i] == target) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    snzr_callGLFnOrError(glBindBuffer(GL_SHADER_STORAGE_BUFFER, _snzr_globs.lineShaderSSBOId));
-    snzr_callGLFnOrError(glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(HMM_Vec4) * (ptCount + 2), NULL, GL_DYNAMIC_DRAW));
+// does a have to run before b
+static bool _snzr_passBefore(const snzr_PassGraph* graph, int64_t a, int64_t b) {
+    const snzr_PassDesc* pa = &graph->passes[a];
+    const snzr_PassDesc* pb = &graph->passes[b];
+    if (_snzr_passReads(pb, pa->output)) {
+        return true;
+    }
+    return a < b && pa->output == pb->output;
+}
 
-    HMM_Vec4 startMiter = HMM_Sub(pts[1], pts[0]);
-    startMiter = HMM_Mul(HMM_Norm(startMiter), 0.001f);
-    startMiter = HMM_Sub(pts[0], startMiter);
-    snzr_callGLFnOrError(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(HMM_Vec4), &startMiter));
-    snzr_callGLFnOrError(glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(HMM_Vec4), ptCount * sizeof(HMM_Vec4), pts));
-    HMM_Vec4 endMiter = HMM_Sub(pts[ptCount - 1], pts[ptCount - 2]);
-    endMiter = HMM_Mul(HMM_Norm(endMiter), 0.001f);
-    endMiter = HMM_Add(pts[ptCount - 1], endMiter);
-    snzr_callGLFnOrError(glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(HMM_Vec4) * (ptCount + 1), sizeof(HMM_Vec4), &endMiter));
+// orders by dependency (stable w.r.t. the order passes were added), then drops passes nothing kept reads
+static void _snzr_passGraphSchedule(snzr_PassGraph* graph) {
+    int64_t count = graph->passCount;
+    bool placed[_SNZR_PASS_MAX] = { 0 };
+    graph->orderCount = 0;
+    for (int64_t round = 0; round < count; round++) {
+        int64_t next = -1;
+        for (int64_t i = 0; i < count && next < 0; i++) {
+            if (placed[i]) {
+                continue;
+            }
+            bool ready = true;
+            for (int64_t j = 0; j < count && ready; j++) {
+                if (!placed[j] && j != i && _snzr_passBefore(graph, j, i)) {
+                    ready = false;
+                }
+            }
+            if (ready) {
+                next = i;
+            }
+        }
+        SNZ_ASSERT(next >= 0, "pass graph has a cycle, passes read targets written by passes that read theirs.");
+        placed[next] = true;
+        graph->order[graph->orderCount++] = next;
+    }
 
-    snzr_callGLFnOrError(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _snzr_globs.lineShaderSSBOId));
-    snzr_callGLFnOrError(glDrawArrays(GL_TRIANGLES, 0, (ptCount - 1) * 6));
+    // walking backwards, a pass is needed if its output is, and then so are its inputs
+    for (int64_t i = 0; i < graph->targetCount; i++) {
+        graph->targets[i].needed = graph->targets[i].keep;
+    }
+    bool live[_SNZR_PASS_MAX] = { 0 };
+    for (int64_t i = graph->orderCount - 1; i >= 0; i--) {
+        const snzr_PassDesc* pass = &graph->passes[graph->order[i]];
+        if (!graph->targets[pass->output].needed) {
+            continue;
+        }
+        live[i] = true;
+        for (int64_t j = 0; j < pass->inputCount; j++) {
+            graph->targets[pass->inputs[j]].needed = true;
+        }
+    }
+    int64_t liveCount = 0;
+    for (int64_t i = 0; i < graph->orderCount; i++) {
+        if (live[i]) {
+            graph->order[liveCount++] = graph->order[i];
+        }
+    }
+    graph->skippedCount = graph->orderCount - liveCount;
+    graph->orderCount = liveCount;
+
+    for (int64_t i = 0; i < graph->targetCount; i++) {
+        graph->targets[i].firstUse = -1;
+        graph->targets[i].lastUse = -1;
+    }
+    for (int64_t i = 0; i < graph->orderCount; i++) {
+        const snzr_PassDesc* pass = &graph->passes[graph->order[i]];
+        for (int64_t j = -1; j < pass->inputCount; j++) {
+            _snzr_PassTargetInfo* t = &graph->targets[j < 0 ? pass->output : pass->inputs[j]];
+            if (t->firstUse < 0) {
+                t->firstUse = i;
+            }
+            t->lastUse = i;
+        }
+    }
 }
 
-// end miters automatically added, pointing straight away
-void snzr_drawLine(HMM_Vec4* pts, uint64_t ptCount, HMM_Vec4 color, float thickness, HMM_Mat4 vp) {
-    snzr_drawLineFaded(pts, ptCount, color, thickness, vp, HMM_V3(0, 0, 0), INFINITY, INFINITY);
+// runs every needed pass, see snzr_PassGraph
+void snzr_passGraphExecute(snzr_PassGraph* graph) {
+    _snzr_passGraphSchedule(graph);
+
+    for (int64_t i = 0; i < graph->orderCount; i++) {
+        for (int64_t t = 0; t < graph->targetCount; t++) {
+            _snzr_PassTargetInfo* target = &graph->targets[t];
+            if (target->firstUse == i) {
+                target->region = snzr_frameBufferPoolAcquire(graph->pool, target->width, target->height);
+            }
+        }
+
+        const snzr_PassDesc* pass = &graph->passes[graph->order[i]];
+        snzr_gpuZone(pass->name) {
+            snzr_frameBufferRegionBind(graph->targets[pass->output].region);
+            if (pass->clear) {
+                HMM_Vec4 c = pass->clearColor;
+                snzr_callGLFnOrError(glClearColor(c.X, c.Y, c.Z, c.W));
+                snzr_callGLFnOrError(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+            }
+            snzr_callGLFnOrError(glDepthMask(pass->noDepthWrite ? GL_FALSE : GL_TRUE));
+            pass->func(graph, pass->userData);
+            snzr_callGLFnOrError(glDepthMask(GL_TRUE));
+
+            // the last writer of a target resolves it, for the reads after
+            bool lastWrite = true;
+            for (int64_t j = i + 1; j < graph->orderCount; j++) {
+                if (graph->passes[graph->order[j]].output == pass->output) {
+                    lastWrite = false;
+                    break;
+                }
+            }
+            if (lastWrite) {
+                snzr_frameBufferRegionResolve(graph->targets[pass->output].region);
+            }
+        }
+
+        for (int64_t t = 0; t < graph->targetCount; t++) {
+            _snzr_PassTargetInfo* target = &graph->targets[t];
+            if (target->lastUse == i && !target->keep) {
+                snzr_frameBufferPoolRelease(graph->pool, target->region);
+                target->region = (snzr_FrameBufferRegion){ 0 };
+            }
+        }
+    }
+    snzr_frameBufferBindScreen();
 }
 
 // RENDER ======================================================================
@@ -1170,6 +5641,9 @@ struct _snzu_Box {
     float borderThickness;
     HMM_Vec4 borderColor;
     snzr_Texture texture;
+    HMM_Vec2 textureUvStart;
+    HMM_Vec2 textureUvEnd;
+    float textureLodBias;
 
     const char* displayStr;
     uint64_t displayStrLen;
@@ -1178,10 +5652,23 @@ struct _snzu_Box {
     bool displayStrRemoveSnap;
     float displayStrRenderedHeight;
 
+    const snzr_Paragraph* paragraph;  // see snzu_boxSetParagraph
+    const char* paragraphStr;
+    HMM_Vec4 paragraphColor;
+
     HMM_Vec2 clippedStart;
     HMM_Vec2 clippedEnd;
     bool clipChildren;
 
+    // filled in before drawing, for culling
+    HMM_Vec2 displayStrPos;  // where the first baseline starts
+    HMM_Vec2 displayStrBoundsStart;  // padded, glyphs can poke out past snzr_strSize a bit
+    HMM_Vec2 displayStrBoundsEnd;
+    HMM_Vec2 subtreeStart;  // everything this box and its children could draw, ignoring clips
+    HMM_Vec2 subtreeEnd;
+    bool occluded;  // the rect is entirely behind opaque boxes drawn after it, see _snzu_occlusionMark
+    bool displayStrOccluded;
+
     snzu_Interaction* interactionTarget;
     snzu_InteractionFlags interactionMask;
 
@@ -1212,6 +5699,16 @@ typedef struct {
     bool doubleClick;  // only lmb
 } snzu_Input;
 
+// what _snzu_drawBoxAndChildren skipped, see snzu_cullStatsGet
+typedef struct {
+    uint64_t boxesDrawn;
+    uint64_t boxesInvisible;  // transparent with no visible border
+    uint64_t boxesClipped;  // entirely outside of their clip
+    uint64_t subtreesPruned;  // a box and all of its children skipped at once, those boxes aren't counted above
+    uint64_t boxesOccluded;  // entirely covered by opaque boxes drawn after them
+    uint64_t textsCulled;  // invisible, clipped or covered display strings
+} snzu_CullStats;
+
 typedef struct {
     _snzu_Box treeParent;
     _snzu_Box* currentParentBox;
@@ -1232,9 +5729,43 @@ typedef struct {
     // persistant, set to null whenever a click happens
     // useful to make sure keyboard input only goes to one place
     uint64_t focusedPathHash;
+
+    snzu_CullStats cullStats;  // from the last frame that was actually drawn
+    uint64_t prevTreeHash;  // of everything drawn last frame, zero before the first frame
+    bool animating;  // set by the easing fns when something hasn't settled yet, reset every frame
 } snzu_Instance;
 static snzu_Instance* _snzu_instance;
 
+// per frame damage state, reset by the main loop before each frame
+// FIXME: assumes every instance drawn in a frame ends up on screen, and that there's only one visible at a time
+static struct {
+    bool frameClean;  // true until an instance finds its tree changed
+    bool anyInstanceDrawn;  // frames without ui always count as dirty
+    bool redrawRequested;  // not reset per frame, cleared once an instance draws because of it
+    bool clearPending;  // the screen hasn't been cleared yet this frame, see _snzu_screenClearIfPending
+} _snzu_damageGlobs;
+
+// frames the ui finds clean are never presented, so the screen only gets cleared once an instance is about to draw
+// anything on it. Frames without ui are cleared up front by the main loop instead.
+static void _snzu_screenClearIfPending() {
+    if (!_snzu_damageGlobs.clearPending) {
+        return;
+    }
+    _snzu_damageGlobs.clearPending = false;
+    int32_t prevFrameBuffer = 0;
+    snzr_callGLFnOrError(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFrameBuffer));
+    snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, _snzr_globs.screenFrameBufferId));
+    snzr_callGLFnOrError(glClearColor(1, 1, 1, 1));
+    snzr_callGLFnOrError(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+    snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, prevFrameBuffer));
+}
+
+// forces the next frame to be drawn and presented even if the box tree didn't change
+// call it every frame something is rendered that the tree doesn't know about (raw gl into a framebuffer, etc.)
+void snz_requestRedraw() {
+    _snzu_damageGlobs.redrawRequested = true;
+}
+
 static uint64_t _snzu_generatePathHash(uint64_t parentPathHash, const char* tag) {
     // stolen, https://stackoverflow.com/questions/7666509/hash-function-for-string
     uint32_t tagHash = 5381;
@@ -1366,6 +5897,7 @@ void snzu_frameStart(snz_Arena* frameArena, HMM_Vec2 parentSize, float dt) {
     _snzu_instance->currentFrameIdx++;
 
     _snzu_instance->timeSinceLastFrame = dt;
+    _snzu_instance->animating = false;
 
     memset(&_snzu_instance->treeParent, 0, sizeof(_snzu_instance->treeParent));
     _snzu_instance->treeParent.pathHash = 6969420;
@@ -1388,7 +5920,188 @@ static _snzu_Box* _snzu_findBoxByPathHash(uint64_t pathHash, _snzu_Box* parent)
     return NULL;
 }
 
-static void _snzu_drawBoxAndChildren(_snzu_Box* parent, HMM_Vec2 clipStart, HMM_Vec2 clipEnd, HMM_Mat4 vp) {
+// covers everything _snzu_drawBoxAndChildren reads, so equal hashes mean identical draws
+static uint64_t _snzu_hashBoxAndChildren(const _snzu_Box* box, uint64_t hash) {
+    hash = snz_hashBytes(hash, &box->start, sizeof(box->start));
+    hash = snz_hashBytes(hash, &box->end, sizeof(box->end));
+    hash = snz_hashBytes(hash, &box->color, sizeof(box->color));
+    hash = snz_hashBytes(hash, &box->cornerRadius, sizeof(box->cornerRadius));
+    hash = snz_hashBytes(hash, &box->borderThickness, sizeof(box->borderThickness));
+    hash = snz_hashBytes(hash, &box->borderColor, sizeof(box->borderColor));
+    hash = snz_hashBytes(hash, &box->texture.glId, sizeof(box->texture.glId));
+    hash = snz_hashBytes(hash, &box->textureUvStart, sizeof(box->textureUvStart));
+    hash = snz_hashBytes(hash, &box->textureUvEnd, sizeof(box->textureUvEnd));
+    hash = snz_hashBytes(hash, &box->textureLodBias, sizeof(box->textureLodBias));
+    hash = snz_hashBytes(hash, &box->clipChildren, sizeof(box->clipChildren));
+    if (box->displayStr != NULL) {
+        hash = snz_hashBytes(hash, box->displayStr, box->displayStrLen);
+        hash = snz_hashBytes(hash, &box->font, sizeof(box->font));
+        hash = snz_hashBytes(hash, &box->displayStrColor, sizeof(box->displayStrColor));
+        hash = snz_hashBytes(hash, &box->displayStrRenderedHeight, sizeof(box->displayStrRenderedHeight));
+        hash = snz_hashBytes(hash, &box->displayStrRemoveSnap, sizeof(box->displayStrRemoveSnap));
+    }
+    if (box->paragraph != NULL) {
+        const snzr_Paragraph* p = box->paragraph;
+        hash = snz_hashBytes(hash, box->paragraphStr, p->charCount);
+        hash = snz_hashBytes(hash, &box->paragraphColor, sizeof(box->paragraphColor));
+        hash = snz_hashBytes(hash, &p->font, sizeof(p->font));
+        hash = snz_hashBytes(hash, &p->height, sizeof(p->height));
+        hash = snz_hashBytes(hash, &p->wrapWidth, sizeof(p->wrapWidth));
+        hash = snz_hashBytes(hash, &p->maxLines, sizeof(p->maxLines));
+        hash = snz_hashBytes(hash, &p->lineCount, sizeof(p->lineCount));
+    }
+
+    for (_snzu_Box* child = box->firstChild; child; child = child->nextSibling) {
+        hash = _snzu_hashBoxAndChildren(child, hash);
+    }
+    uint8_t endMarker = 0xff;  // so differently nested trees with the same boxes don't collide
+    return snz_hashBytes(hash, &endMarker, sizeof(endMarker));
+}
+
+// clipped rects are always computed because interactions need them, emit says whether anything is recorded
+// order of start and end doesn't matter, backwards boxes still get drawn by the shader
+static bool _snzu_rectTouchesClip(HMM_Vec2 start, HMM_Vec2 end, HMM_Vec2 clipStart, HMM_Vec2 clipEnd) {
+    return fminf(start.X, end.X) < clipEnd.X && fmaxf(start.X, end.X) > clipStart.X &&
+           fminf(start.Y, end.Y) < clipEnd.Y && fmaxf(start.Y, end.Y) > clipStart.Y;
+}
+
+// lays out display strings and finds the bounds of every subtree, so drawing can skip whole branches
+static void _snzu_computeSubtreeBounds(_snzu_Box* box) {
+    HMM_Vec2 start = HMM_V2(fminf(box->start.X, box->end.X), fminf(box->start.Y, box->end.Y));
+    HMM_Vec2 end = HMM_V2(fmaxf(box->start.X, box->end.X), fmaxf(box->start.Y, box->end.Y));
+
+    if (box->displayStr != NULL) {
+        const snzr_Font* font = box->font;
+        float height = box->displayStrRenderedHeight;
+        float scaleFactor = height / font->renderedSize;
+        HMM_Vec2 textSize = snzr_strSize(font, box->displayStr, box->displayStrLen, height);
+        HMM_Vec2 textStart = HMM_SubV2(HMM_DivV2F(HMM_AddV2(box->start, box->end), 2), HMM_DivV2F(textSize, 2));  // centered in the box
+        box->displayStrPos = HMM_V2(textStart.X, textStart.Y + font->ascent * scaleFactor);
+
+        // lines are really spaced by the line height, which strSize doesn't account for
+        float lineCount = textSize.Y / height;
+        float lineHeight = SNZ_MAX(height, (font->lineGap + font->ascent - font->descent) * scaleFactor);
+        HMM_Vec2 pad = HMM_V2(height, height);
+        box->displayStrBoundsStart = HMM_SubV2(textStart, pad);
+        box->displayStrBoundsEnd = HMM_AddV2(HMM_AddV2(textStart, HMM_V2(textSize.X, lineCount * lineHeight)), pad);
+
+        start = HMM_V2(fminf(start.X, box->displayStrBoundsStart.X), fminf(start.Y, box->displayStrBoundsStart.Y));
+        end = HMM_V2(fmaxf(end.X, box->displayStrBoundsEnd.X), fmaxf(end.Y, box->displayStrBoundsEnd.Y));
+    }
+    if (box->paragraph != NULL) {
+        HMM_Vec2 pad = HMM_V2(box->paragraph->height, box->paragraph->height);
+        HMM_Vec2 boxStart = HMM_V2(fminf(box->start.X, box->end.X), fminf(box->start.Y, box->end.Y));
+        HMM_Vec2 paragraphEnd = HMM_AddV2(HMM_AddV2(boxStart, snzr_paragraphSize(box->paragraph, box->paragraphStr)), pad);
+        start = HMM_SubV2(start, pad);
+        end = HMM_V2(fmaxf(end.X, paragraphEnd.X), fmaxf(end.Y, paragraphEnd.Y));
+    }
+
+    for (_snzu_Box* child = box->firstChild; child; child = child->nextSibling) {
+        _snzu_computeSubtreeBounds(child);
+        start = HMM_V2(fminf(start.X, child->subtreeStart.X), fminf(start.Y, child->subtreeStart.Y));
+        end = HMM_V2(fmaxf(end.X, child->subtreeEnd.X), fmaxf(end.Y, child->subtreeEnd.Y));
+    }
+    box->subtreeStart = start;
+    box->subtreeEnd = end;
+}
+
+// Boxes draw back to front with blending on, so an opaque box drawn late can hide boxes drawn before it entirely.
+// Before drawing, the tree gets walked front to back (the reverse of draw order) against a coarse grid over the
+// screen. Rects and display strings that only touch cells already covered are marked occluded and don't get
+// drawn, then opaque rects cover every cell they contain completely. Partly covered cells never count, which
+// keeps this conservative without tracking exact shapes. Assumes the vp maps box units to about a pixel.
+#define _SNZU_OCCLUSION_CELL_SIZE 32
+
+typedef struct {
+    uint8_t* covered;  // a bool per cell, rows top down
+    int64_t width;  // in cells
+    int64_t height;
+    HMM_Vec2 screenSize;
+} _snzu_OcclusionGrid;
+
+// solid color, square corners, and a border that's either opaque or not there
+static bool _snzu_boxOpaque(const _snzu_Box* box) {
+    return box->color.W >= 1 && box->cornerRadius <= 0 && box->texture.glId == _snzr_globs.solidTex.glId &&
+           (box->borderThickness <= 0 || box->borderColor.W >= 1);
+}
+
+// true if every cell start-end touches is covered. Rects entirely off of the grid are left to clip culling.
+static bool _snzu_occlusionTest(const _snzu_OcclusionGrid* grid, HMM_Vec2 start, HMM_Vec2 end) {
+    int64_t x0 = SNZ_MAX((int64_t)floorf(start.X / _SNZU_OCCLUSION_CELL_SIZE), 0);
+    int64_t y0 = SNZ_MAX((int64_t)floorf(start.Y / _SNZU_OCCLUSION_CELL_SIZE), 0);
+    int64_t x1 = SNZ_MIN((int64_t)ceilf(end.X / _SNZU_OCCLUSION_CELL_SIZE), grid->width);
+    int64_t y1 = SNZ_MIN((int64_t)ceilf(end.Y / _SNZU_OCCLUSION_CELL_SIZE), grid->height);
+    if (x0 >= x1 || y0 >= y1) {
+        return false;
+    }
+    for (int64_t y = y0; y < y1; y++) {
+        for (int64_t x = x0; x < x1; x++) {
+            if (!grid->covered[y * grid->width + x]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// covers the cells entirely inside of start-end, less a pixel on every side for edges that aren't fully opaque
+// edges at or past the screen's count as reaching forever, so the cells hanging off of it can still be covered
+static void _snzu_occlusionAdd(_snzu_OcclusionGrid* grid, HMM_Vec2 start, HMM_Vec2 end) {
+    for (int ax = 0; ax < 2; ax++) {
+        if (start.Elements[ax] <= 0) {
+            start.Elements[ax] = -INFINITY;
+        }
+        if (end.Elements[ax] >= grid->screenSize.Elements[ax]) {
+            end.Elements[ax] = INFINITY;
+        }
+    }
+    int64_t x0 = (int64_t)SNZ_MAX(ceilf((start.X + 1) / _SNZU_OCCLUSION_CELL_SIZE), 0);
+    int64_t y0 = (int64_t)SNZ_MAX(ceilf((start.Y + 1) / _SNZU_OCCLUSION_CELL_SIZE), 0);
+    int64_t x1 = (int64_t)SNZ_MIN(floorf((end.X - 1) / _SNZU_OCCLUSION_CELL_SIZE), (float)grid->width);
+    int64_t y1 = (int64_t)SNZ_MIN(floorf((end.Y - 1) / _SNZU_OCCLUSION_CELL_SIZE), (float)grid->height);
+    if (x0 >= x1) {
+        return;
+    }
+    for (int64_t y = y0; y < y1; y++) {
+        memset(&grid->covered[y * grid->width + x0], 1, x1 - x0);
+    }
+}
+
+// clips are tracked the same way _snzu_drawBoxAndChildren does, needs _snzu_computeSubtreeBounds first
+static void _snzu_occlusionMark(_snzu_OcclusionGrid* grid, _snzu_Box* box, HMM_Vec2 clipStart, HMM_Vec2 clipEnd) {
+    HMM_Vec2 childClipStart = clipStart;
+    HMM_Vec2 childClipEnd = clipEnd;
+    if (box->clipChildren) {
+        childClipStart = HMM_V2(SNZ_MAX(clipStart.X, box->start.X), SNZ_MAX(clipStart.Y, box->start.Y));
+        childClipEnd = HMM_V2(SNZ_MIN(clipEnd.X, box->end.X), SNZ_MIN(clipEnd.Y, box->end.Y));
+    }
+    for (_snzu_Box* child = box->lastChild; child; child = child->prevSibling) {
+        _snzu_occlusionMark(grid, child, childClipStart, childClipEnd);
+    }
+
+    box->displayStrOccluded = false;
+    if (box->displayStr != NULL) {
+        HMM_Vec2 start = HMM_V2(SNZ_MAX(box->displayStrBoundsStart.X, clipStart.X), SNZ_MAX(box->displayStrBoundsStart.Y, clipStart.Y));
+        HMM_Vec2 end = HMM_V2(SNZ_MIN(box->displayStrBoundsEnd.X, clipEnd.X), SNZ_MIN(box->displayStrBoundsEnd.Y, clipEnd.Y));
+        box->displayStrOccluded = _snzu_occlusionTest(grid, start, end);
+    }
+
+    HMM_Vec2 start = HMM_V2(SNZ_MAX(fminf(box->start.X, box->end.X), clipStart.X), SNZ_MAX(fminf(box->start.Y, box->end.Y), clipStart.Y));
+    HMM_Vec2 end = HMM_V2(SNZ_MIN(fmaxf(box->start.X, box->end.X), clipEnd.X), SNZ_MIN(fmaxf(box->start.Y, box->end.Y), clipEnd.Y));
+    box->occluded = _snzu_occlusionTest(grid, start, end);
+    if (!box->occluded && _snzu_boxOpaque(box)) {
+        _snzu_occlusionAdd(grid, start, end);
+    }
+}
+
+// culls boxes & text that wouldn't show up anyways, needs _snzu_computeSubtreeBounds and _snzu_occlusionMark when emit is set
+static void _snzu_drawBoxAndChildren(_snzu_Box* parent, HMM_Vec2 clipStart, HMM_Vec2 clipEnd, HMM_Mat4 vp, bool emit) {
+    snzu_CullStats* stats = &_snzu_instance->cullStats;
+    if (emit && !_snzu_rectTouchesClip(parent->subtreeStart, parent->subtreeEnd, clipStart, clipEnd)) {
+        stats->subtreesPruned++;
+        emit = false;  // still walk it, interactions need the clipped rects
+    }
+
     HMM_Vec2 newClipStart = clipStart;
     HMM_Vec2 newClipEnd = clipEnd;
     if (newClipStart.X < parent->start.X) {
@@ -1414,34 +6127,61 @@ static void _snzu_drawBoxAndChildren(_snzu_Box* parent, HMM_Vec2 clipStart, HMM_
         clipEnd = newClipEnd;
     }
 
-    snzr_drawRect(
-        parent->start, parent->end,
-        clipStart, clipEnd,
-        parent->color,
-        parent->cornerRadius,
-        parent->borderThickness, parent->borderColor,
-        vp,
-        parent->texture);
+    if (!emit) {
+        for (_snzu_Box* child = parent->firstChild; child; child = child->nextSibling) {
+            _snzu_drawBoxAndChildren(child, clipStart, clipEnd, vp, emit);
+        }
+        return;
+    }
 
-    if (parent->displayStr != NULL) {
-        HMM_Vec2 textPos = HMM_DivV2F(HMM_AddV2(parent->start, parent->end), 2);  // set to the midpoint of the box
-        HMM_Vec2 textSize = snzr_strSize(parent->font, parent->displayStr, parent->displayStrLen, parent->displayStrRenderedHeight);
-        textPos = HMM_SubV2(textPos, HMM_DivV2F(textSize, 2));
-        float scaleFactor = (parent->displayStrRenderedHeight / parent->font->renderedSize);
-        textPos.Y += parent->font->ascent * scaleFactor;
-        snzr_drawTextScaled(
-            textPos,
+    // the rect shader discards anything this transparent, so these checks don't change what ends up on screen
+    bool visible = parent->color.W > 0.01 || (parent->borderThickness > 0 && parent->borderColor.W > 0.01);
+    if (!visible) {
+        stats->boxesInvisible++;
+    } else if (!_snzu_rectTouchesClip(parent->start, parent->end, clipStart, clipEnd)) {
+        stats->boxesClipped++;
+    } else if (parent->occluded) {
+        stats->boxesOccluded++;
+    } else {
+        stats->boxesDrawn++;
+        snzr_drawRectTextureRegion(
+            parent->start, parent->end,
             clipStart, clipEnd,
-            parent->displayStrColor,
-            parent->displayStr, parent->displayStrLen,
-            *parent->font,
+            parent->color,
+            parent->cornerRadius,
+            parent->borderThickness, parent->borderColor,
             vp,
-            parent->displayStrRenderedHeight,
-            !parent->displayStrRemoveSnap);
+            parent->texture, parent->textureUvStart, parent->textureUvEnd,
+            parent->textureLodBias);
+    }
+
+    if (parent->displayStr != NULL) {
+        if (parent->displayStrColor.W <= 0.01 || parent->displayStrOccluded ||
+            !_snzu_rectTouchesClip(parent->displayStrBoundsStart, parent->displayStrBoundsEnd, clipStart, clipEnd)) {
+            stats->textsCulled++;
+        } else {
+            snzr_drawTextScaled(
+                parent->displayStrPos,
+                clipStart, clipEnd,
+                parent->displayStrColor,
+                parent->displayStr, parent->displayStrLen,
+                *parent->font,
+                vp,
+                parent->displayStrRenderedHeight,
+                !parent->displayStrRemoveSnap);
+        }
+    }
+
+    if (parent->paragraph != NULL) {
+        // lines outside of the clip get skipped in there
+        const snzr_Paragraph* p = parent->paragraph;
+        HMM_Vec2 start = HMM_V2(fminf(parent->start.X, parent->end.X), fminf(parent->start.Y, parent->end.Y));
+        start.Y += p->font->ascent * (p->height / p->font->renderedSize);
+        snzr_drawParagraph(p, parent->paragraphStr, start, clipStart, clipEnd, parent->paragraphColor, vp);
     }
 
     for (_snzu_Box* child = parent->firstChild; child; child = child->nextSibling) {
-        _snzu_drawBoxAndChildren(child, clipStart, clipEnd, vp);
+        _snzu_drawBoxAndChildren(child, clipStart, clipEnd, vp, emit);
     }
 }
 
@@ -1551,7 +6291,48 @@ static void _snzu_genInteractionsForBoxAndChildren(_snzu_Box* box, uint64_t* rem
 void snzu_frameDrawAndGenInteractions(snzu_Input input, HMM_Mat4 vp) {
     _snzu_instance->currentInputs = input;
 
-    _snzu_drawBoxAndChildren(&_snzu_instance->treeParent, HMM_V2(-INFINITY, -INFINITY), HMM_V2(INFINITY, INFINITY), vp);
+    // skip recording and submitting entirely when nothing visible changed since last frame
+    uint64_t treeHash = _snzu_hashBoxAndChildren(&_snzu_instance->treeParent, SNZ_HASH_SEED);
+    treeHash = snz_hashBytes(treeHash, &vp, sizeof(vp));
+    bool clean = treeHash == _snzu_instance->prevTreeHash && !_snzu_instance->animating && !_snzu_damageGlobs.redrawRequested;
+    _snzu_instance->prevTreeHash = treeHash;
+    _snzu_damageGlobs.redrawRequested = false;  // consumed, requests after this point land on the next frame
+    _snzu_damageGlobs.anyInstanceDrawn = true;
+    if (!clean) {
+        _snzu_damageGlobs.frameClean = false;
+    }
+    bool emit = !_snzu_damageGlobs.frameClean;  // if anything before this was dirty the whole frame is getting presented
+    if (emit) {
+        _snzu_screenClearIfPending();
+        memset(&_snzu_instance->cullStats, 0, sizeof(_snzu_instance->cullStats));
+        _snzu_computeSubtreeBounds(&_snzu_instance->treeParent);
+
+        HMM_Vec2 screenSize = _snzu_instance->treeParent.end;
+        _snzu_OcclusionGrid grid = {
+            .width = SNZ_MAX((int64_t)ceilf(screenSize.X / _SNZU_OCCLUSION_CELL_SIZE), 0),
+            .height = SNZ_MAX((int64_t)ceilf(screenSize.Y / _SNZU_OCCLUSION_CELL_SIZE), 0),
+            .screenSize = screenSize,
+        };
+        grid.covered = SNZ_ARENA_PUSH_ARR(_snzu_instance->frameArena, grid.width * grid.height, uint8_t);
+        memset(grid.covered, 0, grid.width * grid.height);
+        _snzu_occlusionMark(&grid, &_snzu_instance->treeParent, HMM_V2(-INFINITY, -INFINITY), HMM_V2(INFINITY, INFINITY));
+    }
+
+    // when the caller is already recording a list the boxes just go into that, and it's on them to submit
+    snzr_CmdList list = { 0 };
+    bool ownsList = _snzr_cmdGlobs.activeList == NULL;
+    if (ownsList) {
+        snzr_cmdListBegin(&list, _snzu_instance->frameArena);
+    }
+    _snzu_drawBoxAndChildren(&_snzu_instance->treeParent, HMM_V2(-INFINITY, -INFINITY), HMM_V2(INFINITY, INFINITY), vp, emit);
+    if (ownsList) {
+        snzr_cmdListEnd();
+        if (emit) {
+            snzr_gpuZone("ui rects") {
+                snzr_cmdListSubmit(&list);
+            }
+        }
+    }
 
     // compute mouse actions for this frame
     bool wasMouseUp = false;
@@ -1647,6 +6428,11 @@ void snzu_clearFocus() {
     _snzu_instance->focusedPathHash = 0;
 }
 
+// counts from the last frame where boxes were actually drawn, so they stay put while the frame is idle
+snzu_CullStats snzu_cullStatsGet() {
+    return _snzu_instance->cullStats;
+}
+
 bool snzu_isNothingFocused() {
     return _snzu_instance->focusedPathHash == 0;
 }
@@ -1675,6 +6461,27 @@ void snzu_boxSetBorder(float px, HMM_Vec4 col) {
 void snzu_boxSetTexture(snzr_Texture texture) {
     _snzu_instance->selectedBox->color = HMM_V4(1, 1, 1, 1);
     _snzu_instance->selectedBox->texture = texture;
+    _snzu_instance->selectedBox->textureUvStart = HMM_V2(0, 0);
+    _snzu_instance->selectedBox->textureUvEnd = HMM_V2(1, 1);
+}
+
+// for images packed into an atlas, see snzr_AtlasAllocator
+void snzu_boxSetTextureRegion(snzr_TextureRegion region) {
+    snzu_boxSetTexture(region.texture);
+    _snzu_instance->selectedBox->textureUvStart = region.uvStart;
+    _snzu_instance->selectedBox->textureUvEnd = region.uvEnd;
+}
+
+// shows only the used part of a pooled framebuffer
+void snzu_boxSetTextureFrameBufferRegion(snzr_FrameBufferRegion region) {
+    snzu_boxSetTexture(region.frameBuffer.texture);
+    _snzu_instance->selectedBox->textureUvEnd = region.uvEnd;
+}
+
+// added to the mip level picked when sampling the box's texture, negative is sharper
+// only does anything for mipmapped (trilinear) textures
+void snzu_boxSetTextureLodBias(float bias) {
+    _snzu_instance->selectedBox->textureLodBias = bias;
 }
 
 // string should last until the end of the frome
@@ -1705,6 +6512,14 @@ void snzu_boxSetDisplayStrF(const snzr_Font* font, HMM_Vec4 color, const char* f
     va_end(args);
 }
 
+// the paragraph gets drawn from the box's top left, it isn't clipped to the box unless the parent clips children.
+// p and str have to last until the end of the frame, and p has to be laid out for str already
+void snzu_boxSetParagraph(const snzr_Paragraph* p, const char* str, HMM_Vec4 color) {
+    _snzu_instance->selectedBox->paragraph = p;
+    _snzu_instance->selectedBox->paragraphStr = str;
+    _snzu_instance->selectedBox->paragraphColor = color;
+}
+
 void snzu_boxSetDisplayStrMode(float height, bool removeSnap) {
     _snzu_instance->selectedBox->displayStrRenderedHeight = height;
     _snzu_instance->selectedBox->displayStrRemoveSnap = removeSnap;
@@ -1979,10 +6794,22 @@ void snzu_boxSetSizeFitChildren() {
     snzu_boxSetSizeFromStart(HMM_V2(x, y));
 }
 
+// anything closer than this snaps to the target, so animations actually finish and frames can go idle
+#define _SNZU_EASE_SNAP_DIST 0.0005f
+
+static void _snzu_easeSettle(float* in, float target) {
+    if (fabsf(target - *in) < _SNZU_EASE_SNAP_DIST) {
+        *in = target;
+    } else {
+        _snzu_instance->animating = true;
+    }
+}
+
 void snzu_easeExpUnbounded(float* in, float target, float pctPerSec) {
     float diff = target - *in;
     diff *= pctPerSec * _snzu_instance->timeSinceLastFrame;
     *in += diff;
+    _snzu_easeSettle(in, target);
 }
 
 // eases a float closer to target (which should be between 0 and 1) (in will be clamped to this range, should not be null)
@@ -1995,6 +6822,7 @@ void snzu_easeExp(float* in, float target, float pctPerSec) {
     } else if (*in < 0) {
         *in = 0;
     }
+    _snzu_easeSettle(in, target);
 }
 
 void snzu_boxHighlightByAnim(float* anim, HMM_Vec4 baseColor, float diff) {
@@ -2012,14 +6840,223 @@ void snzu_boxHighlightByAnim(float* anim, HMM_Vec4 baseColor, float diff) {
 
 typedef void (*snz_InitFunc)(snz_Arena* scratch, SDL_Window* window);
 typedef void (*snz_FrameFunc)(float dt, snz_Arena* frameArena, snzu_Input frameInputs, HMM_Vec2 screenSize);
+// called once the main loop ends, should free whatever gpu resources init and frames made
+typedef void (*snz_DeinitFunc)();
 
 static bool _snz_shouldQuit = false;
 void snz_quit() {
     _snz_shouldQuit = true;
 }
 
+// everything but input and presenting, shared between snz_main and snz_mainHeadless
+// returns false when the ui found nothing changed, so the back buffer is stale and shouldn't be presented
+static bool _snz_frame(float dt, HMM_Vec2 screenSize, snzu_Input inputs, snz_Arena* frameArena, snz_FrameFunc frameFunc) {
+    _snzr_globs.screenSize = screenSize;
+    _snzr_textureLoaderUpdate();
+
+    snzr_frameBufferBindScreen();
+    // with ui last frame, the clear waits until an instance finds something changed, so clean frames skip it
+    _snzu_damageGlobs.clearPending = true;
+    if (!_snzu_damageGlobs.anyInstanceDrawn) {
+        _snzu_screenClearIfPending();
+    }
+
+    _snzu_damageGlobs.frameClean = true;
+    _snzu_damageGlobs.anyInstanceDrawn = false;
+
+    frameFunc(dt, frameArena, inputs, screenSize);
+    bool present = !_snzu_damageGlobs.anyInstanceDrawn || !_snzu_damageGlobs.frameClean;
+    _snzr_captureUpdate(present);
+    _snzr_gpuProfilerFrameEnd();
+    _snzr_textCacheFrameEnd();
+    _snzr_resourceFrameEnd();
+    fflush(_snz_logFile);
+
+    snz_arenaClear(frameArena);
+
+    return present;
+}
+
+// shortest wait between idle frames, so timers & polling in user code still run occasionally
+#define _SNZ_IDLE_WAIT_MS 250
+
+static void _snz_handleEvent(const SDL_Event* e, snzu_Input* uiInputs) {
+    if (e->type == SDL_QUIT) {
+        _snz_shouldQuit = true;
+    } else if (e->type == SDL_MOUSEWHEEL) {
+        uiInputs->mouseScrollY = e->wheel.preciseY;
+    } else if (e->type == SDL_KEYDOWN) {
+        uiInputs->keyAction = SNZU_ACT_DOWN;
+        uiInputs->keyCode = e->key.keysym.sym;
+    } else if (e->type == SDL_KEYUP) {
+        uiInputs->keyAction = SNZU_ACT_UP;
+        uiInputs->keyCode = e->key.keysym.sym;
+    } else if (e->type == SDL_TEXTINPUT) {
+        _STATIC_ASSERT(_SNZU_TEXT_INPUT_CHAR_MAX < SDL_TEXTINPUTEVENT_TEXT_SIZE);
+        for (uint64_t i = 0; i < _SNZU_TEXT_INPUT_CHAR_MAX; i++) {
+            uiInputs->charsEntered[i] = e->text.text[i];
+        }
+    } else if (e->type == SDL_MOUSEBUTTONDOWN) {
+        if (e->button.clicks == 2 && e->button.button == SDL_BUTTON_LEFT) {
+            uiInputs->doubleClick = true;
+        }
+    } else if (e->type == SDL_WINDOWEVENT) {
+        snz_requestRedraw();  // exposes, resizes, etc. may have trashed what's on screen
+    }
+}
+
+typedef enum {
+    SNZ_PACING_VSYNC,  // swap interval 1, default
+    SNZ_PACING_ADAPTIVE_VSYNC,  // late frames tear instead of waiting a whole refresh, falls back to vsync if unsupported
+    SNZ_PACING_FIXED,  // no vsync, frames are spaced out to a set rate by the cpu (for VRR monitors, or capping)
+} snz_PacingMode;
+
+typedef struct {
+    snz_PacingMode mode;  // what's actually applied, may differ from what was asked for after a fallback
+    snz_PacingMode requestedMode;  // what snz_pacingSetMode was last given, cycle through modes from this
+    float targetFrameMs;
+    float lastFrameMs;  // between the last two presents
+    float buildMs;  // smoothed, from sampling input to handing the frame to the swap
+    float inputToPresentMs;  // smoothed, from sampling input to the swap returning
+    uint64_t framesPresented;
+    uint64_t missedDeadlines;  // presents that landed more than half a frame late
+} snz_PacingStats;
+
+// input is sampled this long before the predicted deadline, on top of the build estimate
+#define _SNZ_PACING_MARGIN_MS 1.5
+// SDL_Delay can oversleep by a couple ms, so the last part of a wait is a spin
+#define _SNZ_PACING_SPIN_MS 2.0
+
+static struct {
+    snz_PacingMode requestedMode;
+    float requestedFixedFps;
+    bool applied;
+
+    snz_PacingStats stats;
+    float fixedFps;
+    float refreshRate;
+    uint64_t nextDeadline;  // performance counter ticks, when the next present should land
+} _snz_pacingGlobs = {
+    .requestedMode = SNZ_PACING_VSYNC,
+    .requestedFixedFps = 60,
+};
+
+// fps is only used for SNZ_PACING_FIXED, applied before the next frame
+void snz_pacingSetMode(snz_PacingMode mode, float fixedFps) {
+    SNZ_ASSERT(mode != SNZ_PACING_FIXED || fixedFps > 0, "fixed pacing needs a positive fps.");
+    _snz_pacingGlobs.requestedMode = mode;
+    _snz_pacingGlobs.stats.requestedMode = mode;
+    _snz_pacingGlobs.requestedFixedFps = fixedFps;
+    _snz_pacingGlobs.applied = false;
+}
+
+snz_PacingStats snz_pacingStatsGet() {
+    return _snz_pacingGlobs.stats;
+}
+
+static void _snz_pacingApply(SDL_Window* window) {
+    snz_PacingMode mode = _snz_pacingGlobs.requestedMode;
+    if (mode == SNZ_PACING_ADAPTIVE_VSYNC && SDL_GL_SetSwapInterval(-1) != 0) {
+        SNZ_LOG("Adaptive vsync unsupported, using vsync.");
+        mode = SNZ_PACING_VSYNC;
+    }
+    if (mode == SNZ_PACING_VSYNC) {
+        SDL_GL_SetSwapInterval(1);
+    } else if (mode == SNZ_PACING_FIXED) {
+        SDL_GL_SetSwapInterval(0);
+    }
+
+    SDL_DisplayMode displayMode = { 0 };
+    float refresh = 60;
+    if (SDL_GetWindowDisplayMode(window, &displayMode) == 0 && displayMode.refresh_rate > 0) {
+        refresh = displayMode.refresh_rate;
+    }
+    _snz_pacingGlobs.refreshRate = refresh;
+    _snz_pacingGlobs.fixedFps = _snz_pacingGlobs.requestedFixedFps;
+    _snz_pacingGlobs.stats.mode = mode;
+    _snz_pacingGlobs.stats.targetFrameMs = 1000.0f / (mode == SNZ_PACING_FIXED ? _snz_pacingGlobs.fixedFps : refresh);
+    _snz_pacingGlobs.nextDeadline = 0;
+    _snz_pacingGlobs.applied = true;
+    SNZ_LOGF("Pacing mode %d, targeting %.3fms frames.", mode, _snz_pacingGlobs.stats.targetFrameMs);
+}
+
+static uint64_t _snz_msToTicks(double ms) {
+    return (uint64_t)(ms / 1000.0 * SDL_GetPerformanceFrequency());
+}
+
+static double _snz_ticksToMs(uint64_t ticks) {
+    return (double)ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// sleeps most of the way, then spins, so wakeups land within a fraction of a ms
+static void _snz_pacingWaitUntil(uint64_t deadline) {
+    while (true) {
+        uint64_t now = SDL_GetPerformanceCounter();
+        if (now >= deadline) {
+            return;
+        }
+        double remainingMs = _snz_ticksToMs(deadline - now);
+        if (remainingMs > _SNZ_PACING_SPIN_MS) {
+            SDL_Delay((uint32_t)(remainingMs - _SNZ_PACING_SPIN_MS));
+        }
+    }
+}
+
+// holds off on sampling input until just enough time is left to build the frame before its deadline,
+// so what's presented is as fresh as possible instead of the frame sitting in a blocked swap
+static void _snz_pacingWaitForInput() {
+    if (_snz_pacingGlobs.nextDeadline == 0) {
+        return;
+    }
+    double leadMs = _snz_pacingGlobs.stats.buildMs + _SNZ_PACING_MARGIN_MS;
+    uint64_t lead = _snz_msToTicks(leadMs);
+    if (_snz_pacingGlobs.nextDeadline > lead) {
+        _snz_pacingWaitUntil(_snz_pacingGlobs.nextDeadline - lead);
+    }
+}
+
+// inputTime is from right before input was sampled, swapStart/End are around SDL_GL_SwapWindow
+// afterPresent says whether the frame before this one was presented, deadlines across idle gaps aren't counted
+static void _snz_pacingFramePresented(uint64_t inputTime, uint64_t swapStart, uint64_t swapEnd, uint64_t prevSwapEnd, bool afterPresent) {
+    snz_PacingStats* stats = &_snz_pacingGlobs.stats;
+    stats->buildMs = HMM_Lerp(stats->buildMs, 0.1f, (float)_snz_ticksToMs(swapStart - inputTime));
+    stats->inputToPresentMs = HMM_Lerp(stats->inputToPresentMs, 0.1f, (float)_snz_ticksToMs(swapEnd - inputTime));
+    stats->framesPresented++;
+
+    uint64_t period = _snz_msToTicks(stats->targetFrameMs);
+    if (afterPresent) {
+        stats->lastFrameMs = _snz_ticksToMs(swapEnd - prevSwapEnd);
+        if (_snz_pacingGlobs.nextDeadline && swapEnd > _snz_pacingGlobs.nextDeadline + period / 2) {
+            stats->missedDeadlines++;
+        }
+    }
+
+    if (stats->mode == SNZ_PACING_FIXED && afterPresent && _snz_pacingGlobs.nextDeadline &&
+        swapEnd <= _snz_pacingGlobs.nextDeadline + period / 2) {
+        _snz_pacingGlobs.nextDeadline += period;  // stay on the grid, so frame lengths don't drift by the margin
+    } else {
+        // with vsync the swap returning is the best guess of where vblank is, otherwise resync after a miss
+        _snz_pacingGlobs.nextDeadline = swapEnd + period;
+    }
+}
+
+// frames that aren't presented still take up a slot, otherwise a loop that isn't idle (waiting on a redraw
+// request, loading textures) finds its deadline already passed and spins without ever waiting
+static void _snz_pacingFrameSkipped() {
+    uint64_t now = SDL_GetPerformanceCounter();
+    uint64_t period = _snz_msToTicks(_snz_pacingGlobs.stats.targetFrameMs);
+    if (_snz_pacingGlobs.nextDeadline == 0 || period == 0) {
+        _snz_pacingGlobs.nextDeadline = now + period;
+        return;
+    }
+    while (_snz_pacingGlobs.nextDeadline <= now) {
+        _snz_pacingGlobs.nextDeadline += period;
+    }
+}
+
 // icon path may be null
-void snz_main(const char* windowTitle, const char* iconPath, snz_InitFunc initFunc, snz_FrameFunc frameFunc) {
+// deinitFunc may be null, anything it doesn't free shows up in the leak report in the log
+void snz_main(const char* windowTitle, const char* iconPath, snz_InitFunc initFunc, snz_FrameFunc frameFunc, snz_DeinitFunc deinitFunc) {
     _snz_logFile = fopen("log", "w");
 
     SDL_Window* window = NULL;
@@ -2027,7 +7064,8 @@ void snz_main(const char* windowTitle, const char* iconPath, snz_InitFunc initFu
         // initialize SDL and open window
         SNZ_ASSERT(SDL_Init(SDL_INIT_VIDEO) == 0, "sdl initialization failed.");
         SNZ_ASSERT(SDL_GL_LoadLibrary(NULL) == 0, "sdl loading opengl failed.");
-        SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 8);
+        // no msaa on the window, the ui does its own edge aa in the rect shader,
+        // and anything else that wants it draws into a target made with snzr_frameBufferInitAA
         uint32_t windowFlags = SDL_WINDOW_SHOWN | SDL_WINDOW_FULLSCREEN_DESKTOP | SDL_WINDOW_OPENGL | SDL_WINDOW_ALLOW_HIGHDPI;
         // uint32_t windowFlags = SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED | SDL_WINDOW_OPENGL | SDL_WINDOW_ALLOW_HIGHDPI;
         window = SDL_CreateWindow(windowTitle, 100, 100, 700, 500, windowFlags);
@@ -2050,49 +7088,47 @@ void snz_main(const char* windowTitle, const char* iconPath, snz_InitFunc initFu
 
     snz_Arena frameArena = snz_arenaInit(1000000000, "snz frame arena");
 
-    _snzr_init(&frameArena);
+    snz_jobsInit(0);
+    _snzr_init(&frameArena, SDL_GL_GetProcAddress);
     snz_arenaClear(&frameArena);
     initFunc(&frameArena, window);
     SNZ_LOG("End of init, starting main loop.");
     snz_arenaClear(&frameArena);
 
-    float prevTime = 0.0;
+    uint64_t prevInputTime = SDL_GetPerformanceCounter();
+    uint64_t prevSwapEnd = prevInputTime;
+    bool idle = false;
+    bool prevPresented = false;
     while (!_snz_shouldQuit) {
-        float time = (float)SDL_GetTicks64() / 1000;
-        float dt = time - prevTime;
-        prevTime = time;
-        dt = SNZ_MIN(dt, 0.2);
-
-        int screenW, screenH;
-        SDL_GL_GetDrawableSize(window, &screenW, &screenH);
-        _snzr_globs.screenSize = HMM_V2(screenW, screenH);
+        if (!_snz_pacingGlobs.applied) {
+            _snz_pacingApply(window);
+        }
 
         snzu_Input uiInputs = (snzu_Input){ 0 };
 
+        // nothing changed last frame, so sleep until there's an event instead of spinning on swaps
+        // otherwise wait to sample input until right before the frame has to be built
         SDL_Event e;
+        if (idle && SDL_WaitEventTimeout(&e, _SNZ_IDLE_WAIT_MS)) {
+            _snz_handleEvent(&e, &uiInputs);
+        } else if (!idle) {
+            _snz_pacingWaitForInput();
+        }
+        uint64_t inputTime = SDL_GetPerformanceCounter();
         while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) {
-                _snz_shouldQuit = true;
-            } else if (e.type == SDL_MOUSEWHEEL) {
-                uiInputs.mouseScrollY = e.wheel.preciseY;
-            } else if (e.type == SDL_KEYDOWN) {
-                uiInputs.keyAction = SNZU_ACT_DOWN;
-                uiInputs.keyCode = e.key.keysym.sym;
-            } else if (e.type == SDL_KEYUP) {
-                uiInputs.keyAction = SNZU_ACT_UP;
-                uiInputs.keyCode = e.key.keysym.sym;
-            } else if (e.type == SDL_TEXTINPUT) {
-                _STATIC_ASSERT(_SNZU_TEXT_INPUT_CHAR_MAX < SDL_TEXTINPUTEVENT_TEXT_SIZE);
-                for (uint64_t i = 0; i < _SNZU_TEXT_INPUT_CHAR_MAX; i++) {
-                    uiInputs.charsEntered[i] = e.text.text[i];
-                }
-            } else if (e.type == SDL_MOUSEBUTTONDOWN) {
-                if (e.button.clicks == 2 && e.button.button == SDL_BUTTON_LEFT) {
-                    uiInputs.doubleClick = true;
-                }
-            }
+            _snz_handleEvent(&e, &uiInputs);
         }  // end event polling
 
+        float dt = (float)(_snz_ticksToMs(inputTime - prevInputTime) / 1000.0);
+        prevInputTime = inputTime;
+        dt = SNZ_MIN(dt, 0.2);
+        if (idle) {
+            dt = SNZ_MIN(dt, 1.0f / 60);  // time spent asleep shouldn't jump animations that start now
+        }
+
+        int screenW, screenH;
+        SDL_GL_GetDrawableSize(window, &screenW, &screenH);
+
         int mouseX, mouseY;
         uint32_t mouseButtons = SDL_GetMouseState(&mouseX, &mouseY);
         uiInputs.mousePos = HMM_V2(mouseX, mouseY);
@@ -2101,24 +7137,200 @@ void snz_main(const char* windowTitle, const char* iconPath, snz_InitFunc initFu
         uiInputs.mouseStates[SNZU_MB_MIDDLE] = (SDL_BUTTON(SDL_BUTTON_MIDDLE) & mouseButtons);
         uiInputs.keyMods = SDL_GetModState();
 
-        snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, 0));
-        snzr_callGLFnOrError(glViewport(0, 0, screenW, screenH));
-        snzr_callGLFnOrError(glClearColor(1, 1, 1, 1));
-        snzr_callGLFnOrError(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
-
-        frameFunc(dt, &frameArena, uiInputs, HMM_V2(screenW, screenH));
-        fflush(_snz_logFile);
-
-        snz_arenaClear(&frameArena);
-        SDL_GL_SwapWindow(window);
+        bool present = _snz_frame(dt, HMM_V2(screenW, screenH), uiInputs, &frameArena, frameFunc);
+        if (present) {
+            uint64_t swapStart = SDL_GetPerformanceCounter();
+            SDL_GL_SwapWindow(window);
+            uint64_t swapEnd = SDL_GetPerformanceCounter();
+            _snz_pacingFramePresented(inputTime, swapStart, swapEnd, prevSwapEnd, prevPresented);
+            prevSwapEnd = swapEnd;
+        } else {
+            _snz_pacingFrameSkipped();
+        }
+        prevPresented = present;
+        idle = !present && !_snzu_damageGlobs.redrawRequested && !_snzr_textureLoaderBusy();
     }  // end main loop
 
+    if (deinitFunc) {
+        deinitFunc();
+    }
+    _snzr_captureDeinit();
+    snz_jobsDeinit();
+    _snzr_deinit();
+    _snzr_resourceLeakReport();
     snz_arenaDeinit(&frameArena);
 
     SNZ_LOG("Ending normally.");
     fclose(_snz_logFile);
 
-    // FIXME: gc gpu resources, all allocated arenas, etc.
+    // FIXME: gc all allocated arenas, etc.
+}
+
+// just enough of EGL to get a surfaceless context, loaded at runtime so nothing extra needs linking
+typedef void* _snz_EGLDisplay;
+typedef void* _snz_EGLConfig;
+typedef void* _snz_EGLContext;
+typedef int32_t _snz_EGLint;
+
+#define _SNZ_EGL_NONE 0x3038
+#define _SNZ_EGL_SURFACE_TYPE 0x3033
+#define _SNZ_EGL_PBUFFER_BIT 0x0001
+#define _SNZ_EGL_RENDERABLE_TYPE 0x3040
+#define _SNZ_EGL_OPENGL_BIT 0x0008
+#define _SNZ_EGL_OPENGL_API 0x30A2
+#define _SNZ_EGL_CONTEXT_MAJOR_VERSION 0x3098
+#define _SNZ_EGL_CONTEXT_MINOR_VERSION 0x30FB
+#define _SNZ_EGL_CONTEXT_OPENGL_PROFILE_MASK 0x30FD
+#define _SNZ_EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT 0x0002
+#define _SNZ_EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+
+struct {
+    void* lib;
+    _snz_EGLDisplay display;
+    _snz_EGLContext context;
+
+    void* (*getProcAddress)(const char* name);
+    _snz_EGLDisplay (*getDisplay)(void* nativeDisplay);
+    _snz_EGLDisplay (*getPlatformDisplayEXT)(uint32_t platform, void* nativeDisplay, const _snz_EGLint* attribs);
+    uint32_t (*initialize)(_snz_EGLDisplay display, _snz_EGLint* major, _snz_EGLint* minor);
+    uint32_t (*bindAPI)(uint32_t api);
+    uint32_t (*chooseConfig)(_snz_EGLDisplay display, const _snz_EGLint* attribs, _snz_EGLConfig* configs, _snz_EGLint configSize, _snz_EGLint* configCount);
+    _snz_EGLContext (*createContext)(_snz_EGLDisplay display, _snz_EGLConfig config, _snz_EGLContext share, const _snz_EGLint* attribs);
+    uint32_t (*makeCurrent)(_snz_EGLDisplay display, void* draw, void* read, _snz_EGLContext context);
+    uint32_t (*destroyContext)(_snz_EGLDisplay display, _snz_EGLContext context);
+    uint32_t (*terminate)(_snz_EGLDisplay display);
+} _snz_eglGlobs;
+
+static void* _snz_eglLoadFn(const char* name) {
+    void* fn = SDL_LoadFunction(_snz_eglGlobs.lib, name);
+    SNZ_ASSERTF(fn != NULL, "loading '%s' from EGL failed.", name);
+    return fn;
+}
+
+// 4.3 compat because the line shader needs SSBOs and some draws go out without a VAO bound
+// function pointers get assigned through void** because ISO C won't convert void* to one
+static void _snz_eglInit() {
+    _snz_eglGlobs.lib = SDL_LoadObject("libEGL.so.1");
+    if (!_snz_eglGlobs.lib) {
+        _snz_eglGlobs.lib = SDL_LoadObject("libEGL.dll");
+    }
+    SNZ_ASSERT(_snz_eglGlobs.lib != NULL, "loading EGL failed.");
+
+    *(void**)&_snz_eglGlobs.getProcAddress = _snz_eglLoadFn("eglGetProcAddress");
+    *(void**)&_snz_eglGlobs.getDisplay = _snz_eglLoadFn("eglGetDisplay");
+    *(void**)&_snz_eglGlobs.initialize = _snz_eglLoadFn("eglInitialize");
+    *(void**)&_snz_eglGlobs.bindAPI = _snz_eglLoadFn("eglBindAPI");
+    *(void**)&_snz_eglGlobs.chooseConfig = _snz_eglLoadFn("eglChooseConfig");
+    *(void**)&_snz_eglGlobs.createContext = _snz_eglLoadFn("eglCreateContext");
+    *(void**)&_snz_eglGlobs.makeCurrent = _snz_eglLoadFn("eglMakeCurrent");
+    *(void**)&_snz_eglGlobs.destroyContext = _snz_eglLoadFn("eglDestroyContext");
+    *(void**)&_snz_eglGlobs.terminate = _snz_eglLoadFn("eglTerminate");
+    *(void**)&_snz_eglGlobs.getPlatformDisplayEXT = _snz_eglGlobs.getProcAddress("eglGetPlatformDisplayEXT");
+
+    // surfaceless platform when it's there, so that this works without any display server running
+    if (_snz_eglGlobs.getPlatformDisplayEXT) {
+        _snz_eglGlobs.display = _snz_eglGlobs.getPlatformDisplayEXT(_SNZ_EGL_PLATFORM_SURFACELESS_MESA, NULL, NULL);
+    }
+    if (!_snz_eglGlobs.display) {
+        _snz_eglGlobs.display = _snz_eglGlobs.getDisplay(NULL);
+    }
+    SNZ_ASSERT(_snz_eglGlobs.display != NULL, "getting an EGL display failed.");
+
+    _snz_EGLint major, minor;
+    SNZ_ASSERT(_snz_eglGlobs.initialize(_snz_eglGlobs.display, &major, &minor), "EGL initialization failed.");
+    SNZ_LOGF("EGL %d.%d initialized.", major, minor);
+    SNZ_ASSERT(_snz_eglGlobs.bindAPI(_SNZ_EGL_OPENGL_API), "binding the GL api in EGL failed.");
+
+    const _snz_EGLint configAttribs[] = {
+        _SNZ_EGL_SURFACE_TYPE, _SNZ_EGL_PBUFFER_BIT,
+        _SNZ_EGL_RENDERABLE_TYPE, _SNZ_EGL_OPENGL_BIT,
+        _SNZ_EGL_NONE,
+    };
+    _snz_EGLConfig config = NULL;
+    _snz_EGLint configCount = 0;
+    _snz_eglGlobs.chooseConfig(_snz_eglGlobs.display, configAttribs, &config, 1, &configCount);
+
+    const _snz_EGLint contextAttribs[] = {
+        _SNZ_EGL_CONTEXT_MAJOR_VERSION, 4,
+        _SNZ_EGL_CONTEXT_MINOR_VERSION, 3,
+        _SNZ_EGL_CONTEXT_OPENGL_PROFILE_MASK, _SNZ_EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        _SNZ_EGL_NONE,
+    };
+    // no config is fine as long as EGL_KHR_no_config_context is around, which it is with mesa
+    _snz_eglGlobs.context = _snz_eglGlobs.createContext(_snz_eglGlobs.display, configCount ? config : NULL, NULL, contextAttribs);
+    SNZ_ASSERT(_snz_eglGlobs.context != NULL, "EGL context creation failed.");
+    SNZ_ASSERT(_snz_eglGlobs.makeCurrent(_snz_eglGlobs.display, NULL, NULL, _snz_eglGlobs.context), "making the EGL context current failed.");
+}
+
+static void _snz_eglDeinit() {
+    _snz_eglGlobs.makeCurrent(_snz_eglGlobs.display, NULL, NULL, NULL);
+    _snz_eglGlobs.destroyContext(_snz_eglGlobs.display, _snz_eglGlobs.context);
+    _snz_eglGlobs.terminate(_snz_eglGlobs.display);
+    SDL_UnloadObject(_snz_eglGlobs.lib);
+    memset(&_snz_eglGlobs, 0, sizeof(_snz_eglGlobs));
+}
+
+// runs the app with no window, for benchmarks and CI. Renders frameCount frames into a width x height
+// offscreen framebuffer using a surfaceless EGL context (mesa's llvmpipe works, no display needed).
+// dt is a fixed 1/60th and inputs are empty, so runs are repeatable. initFunc gets a null window.
+// if outPath isn't null the last frame is written there as a binary PPM.
+void snz_mainHeadless(int32_t width, int32_t height, int64_t frameCount, const char* outPath, snz_InitFunc initFunc, snz_FrameFunc frameFunc, snz_DeinitFunc deinitFunc) {
+    _snz_logFile = fopen("log", "w");
+    _snz_eglInit();
+
+    snz_Arena frameArena = snz_arenaInit(1000000000, "snz frame arena");
+
+    snz_jobsInit(0);
+    _snzr_init(&frameArena, _snz_eglGlobs.getProcAddress);
+    snz_arenaClear(&frameArena);
+    SNZ_LOGF("Headless on %s, %s.", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+    snzr_FrameBuffer screen = snzr_frameBufferInit(snzr_textureInitRBGA(width, height, NULL));
+    _snzr_globs.screenFrameBufferId = screen.glId;
+
+    initFunc(&frameArena, NULL);
+    SNZ_LOG("End of init, starting headless loop.");
+    snz_arenaClear(&frameArena);
+
+    uint64_t startCount = SDL_GetPerformanceCounter();
+    int64_t framesRun = 0;
+    for (; framesRun < frameCount && !_snz_shouldQuit; framesRun++) {
+        snz_requestRedraw();  // every frame is drawn in full, otherwise the timings are meaningless
+        _snz_frame(1.0f / 60, HMM_V2(width, height), (snzu_Input){ 0 }, &frameArena, frameFunc);
+    }
+    snzr_callGLFnOrError(glFinish());
+    double seconds = (double)(SDL_GetPerformanceCounter() - startCount) / SDL_GetPerformanceFrequency();
+    SNZ_LOGF("Headless ran %lld frames in %.3fs, %.3fms per frame.", framesRun, seconds, framesRun ? seconds * 1000 / framesRun : 0.0);
+
+    if (outPath != NULL) {
+        uint8_t* pixels = SNZ_ARENA_PUSH_ARR(&frameArena, width * height * 3, uint8_t);
+        snzr_callGLFnOrError(glBindFramebuffer(GL_FRAMEBUFFER, screen.glId));
+        snzr_callGLFnOrError(glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels));
+
+        FILE* f = fopen(outPath, "wb");
+        SNZ_ASSERTF(f != NULL, "opening '%s' for the headless frame failed.", outPath);
+        fprintf(f, "P6\n%d %d\n255\n", width, height);
+        for (int32_t y = height - 1; y >= 0; y--) {  // GL rows go bottom up
+            fwrite(&pixels[y * width * 3], 1, width * 3, f);
+        }
+        fclose(f);
+        SNZ_LOGF("Wrote last headless frame to '%s'.", outPath);
+    }
+
+    if (deinitFunc) {
+        deinitFunc();
+    }
+    _snzr_captureDeinit();
+    snzr_frameBufferDeinit(&screen);
+    _snzr_globs.screenFrameBufferId = 0;
+    snz_jobsDeinit();
+    _snzr_deinit();
+    _snzr_resourceLeakReport();
+    snz_arenaDeinit(&frameArena);
+    _snz_eglDeinit();
+
+    SNZ_LOG("Ending normally.");
+    fclose(_snz_logFile);
 }
 
 // UI COMPONENTS ===============================================================
@@ -4,6 +4,8 @@
 #include "stb/stb_image.h"
 
 snzr_Font ui_labelFont = { 0 };
+snzr_AtlasAllocator ui_imageAtlas = { 0 };  // images this small or smaller get packed together
+#define UI_ATLAS_MAX_IMAGE_SIZE 256
 
 HMM_Vec4 ui_colorOrbit = { 0 };
 float ui_thicknessOrbit = 1;
@@ -18,14 +20,44 @@ float ui_thicknessUiLines = 1;
 float ui_padding = 5;
 
 // loads in RGBA, asserts on failue.
-snzr_Texture ui_texFromFile(const char* path) {
+// small images get packed into ui_imageAtlas, the rest get their own texture with a full mip chain.
+snzr_TextureRegion ui_texFromFile(const char* path) {
     SNZ_LOGF("Loading texture from %s.", path);
     int w, h, channels = 0;
     uint8_t* pixels = stbi_load(path, &w, &h, &channels, 4);
     SNZ_ASSERT(pixels, "Texture load failed.");
-    snzr_Texture tex = snzr_textureInitRBGA(w, h, pixels);
+    snzr_TextureRegion region = { 0 };
+    if (!snzr_atlasAdd(&ui_imageAtlas, w, h, pixels, &region)) {
+        region = snzr_textureRegionWhole(snzr_textureInitRBGAFiltered(w, h, pixels, SNZR_TF_TRILINEAR, -1));
+    }
+    stbi_image_free(pixels);
+    return region;
+}
+
+static uint8_t* _ui_texDecode(const char* path, int32_t* outWidth, int32_t* outHeight) {
+    int channels = 0;
+    return stbi_load(path, outWidth, outHeight, &channels, 4);
+}
+
+static void _ui_texDecodedFree(uint8_t* pixels) {
     stbi_image_free(pixels);
-    return tex;
+}
+
+// decodes on a worker thread, see snzr_textureLoadAsync. asserts on failure (a frame or two later).
+// mipmapped, since these get drawn at anything from icon size to full screen, unless small enough for the atlas
+const snzr_TextureRegion* ui_texFromFileAsync(const char* path) {
+    SNZ_LOGF("Queueing async texture load from %s.", path);
+    return snzr_textureLoadAsync(path, SNZR_TF_TRILINEAR, _ui_texDecode, _ui_texDecodedFree, &ui_imageAtlas);
+}
+
+// opens the virtual texture baked from path (at path + ".vt"), baking it first if there isn't a current one,
+// see snzr_virtualTextureIsCurrent. Sides have to be powers of two, see snzr_virtualTextureBake.
+snzr_VirtualTexture ui_virtualTextureFromFile(const char* path, int64_t cachePagesPerSide, snz_Arena* arena, snz_Arena* scratch) {
+    const char* vtPath = snz_arenaFormatStr(scratch, "%s.vt", path);
+    if (!snzr_virtualTextureIsCurrent(path, vtPath)) {
+        snzr_virtualTextureBake(path, vtPath, _ui_texDecode, _ui_texDecodedFree);
+    }
+    return snzr_virtualTextureInit(vtPath, cachePagesPerSide, arena);
 }
 
 typedef struct _ui_DebugValue _ui_DebugValue;
@@ -35,14 +67,26 @@ struct _ui_DebugValue {
     _ui_DebugValue* next;
 };
 
+// the debug log keeps the last few events under the debug values, oldest lines drop off the front once it's full
+#define _UI_DEBUG_LOG_MAX_CHARS 1024
+#define _UI_DEBUG_LOG_MAX_LINE 256
+#define _UI_DEBUG_LOG_WIDTH 500
+
 struct {
     _ui_DebugValue* firstValue;
     snz_Arena* arena;
+
+    char log[_UI_DEBUG_LOG_MAX_CHARS];
+    uint64_t logLen;
+    snzr_Paragraph logParagraph;  // kept up to date with snzr_paragraphEdit, so appends don't relayout everything
 } _ui_debugGlobs;
 
 void ui_init(snz_Arena* fontArena, snz_Arena* scratch, snz_Arena* debugDataArena) {
     stbi_set_flip_vertically_on_load(true);
+    const char* prevOwner = snzr_resourceOwnerSet("ui");
     ui_labelFont = snzr_fontInit(fontArena, scratch, "res/fonts/SpaceMono-Regular.ttf", 24);
+    ui_imageAtlas = snzr_atlasAllocatorInit(1024, UI_ATLAS_MAX_IMAGE_SIZE);
+    snzr_resourceOwnerSet(prevOwner);
 
     ui_colorText = HMM_V4(230 / 255.0, 244 / 255.0, 255 / 255.0, 1);
     ui_colorBackground = HMM_V4(9 / 255.0, 4 / 255.0, 3 / 255.0, 1.0f);
@@ -52,6 +96,13 @@ void ui_init(snz_Arena* fontArena, snz_Arena* scratch, snz_Arena* debugDataArena
     ui_colorHoveredBackground = HMM_V4(0.4, 0.3, 0.07, 1.0f);
 
     _ui_debugGlobs.arena = debugDataArena;
+    _ui_debugGlobs.logParagraph = snzr_paragraphInit(&ui_labelFont, ui_labelFont.renderedSize, _UI_DEBUG_LOG_WIDTH, 0);
+}
+
+void ui_deinit() {
+    snzr_paragraphDeinit(&_ui_debugGlobs.logParagraph);
+    snzr_fontDeinit(&ui_labelFont);
+    snzr_atlasAllocatorDeinit(&ui_imageAtlas);
 }
 
 float ui_hoverAnim(snzu_Interaction* inter) {
@@ -687,6 +738,96 @@ void ui_debugValueF(const char* boxTag, const char* format, ...) {
     _ui_debugGlobs.firstValue = value;
 }
 
+// adds a line to the debug log, lines past _UI_DEBUG_LOG_MAX_LINE chars get cut
+void ui_debugLogF(const char* format, ...) {
+    char line[_UI_DEBUG_LOG_MAX_LINE];
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (written < 0) {
+        return;
+    }
+    uint64_t lineLen = SNZ_MIN((uint64_t)written, sizeof(line) - 1);
+
+    char* log = _ui_debugGlobs.log;
+    snzr_Paragraph* p = &_ui_debugGlobs.logParagraph;
+    uint64_t added = lineLen + (_ui_debugGlobs.logLen ? 1 : 0);  // for the newline before it
+    while (_ui_debugGlobs.logLen && _ui_debugGlobs.logLen + added > _UI_DEBUG_LOG_MAX_CHARS) {
+        char* newline = memchr(log, '\n', _ui_debugGlobs.logLen);
+        uint64_t removed = newline ? (uint64_t)(newline - log) + 1 : _ui_debugGlobs.logLen;
+        memmove(log, log + removed, _ui_debugGlobs.logLen - removed);
+        _ui_debugGlobs.logLen -= removed;
+        snzr_paragraphEdit(p, log, _ui_debugGlobs.logLen, 0, removed, 0);
+        added = lineLen + (_ui_debugGlobs.logLen ? 1 : 0);
+    }
+
+    uint64_t editStart = _ui_debugGlobs.logLen;
+    if (_ui_debugGlobs.logLen) {
+        log[_ui_debugGlobs.logLen++] = '\n';
+    }
+    memcpy(&log[_ui_debugGlobs.logLen], line, lineLen);
+    _ui_debugGlobs.logLen += lineLen;
+    snzr_paragraphEdit(p, log, _ui_debugGlobs.logLen, editStart, 0, added);
+}
+
+// pushes a debug value per gpu zone, see snzr_gpuZone
+void ui_debugGpuZones() {
+    for (int64_t i = 0; i < snzr_gpuZoneCount(); i++) {
+        snzr_GpuZoneStats stats = snzr_gpuZoneGetStats(i);
+        ui_debugValueF(stats.name, "%.3fms avg %.3fms max", stats.avgMs, stats.maxMs);
+    }
+}
+
+// pushes what the last drawn ui frame culled, see snzu_cullStatsGet
+void ui_debugCullStats() {
+    snzu_CullStats stats = snzu_cullStatsGet();
+    ui_debugValueF("boxes drawn", "%llu", stats.boxesDrawn);
+    ui_debugValueF("boxes culled", "%llu invisible %llu clipped %llu occluded", stats.boxesInvisible, stats.boxesClipped, stats.boxesOccluded);
+    ui_debugValueF("subtrees pruned", "%llu", stats.subtreesPruned);
+    ui_debugValueF("texts culled", "%llu", stats.textsCulled);
+}
+
+void ui_debugTextCacheStats() {
+    snzr_TextCacheStats stats = snzr_textCacheStatsGet();
+    ui_debugValueF("text layouts", "%llu hits %llu misses, %llu cached", stats.hits, stats.misses, stats.entries);
+}
+
+// pushes how many of a virtual texture's pages are resident, and its streaming counts, see snzr_VirtualTextureStats
+void ui_debugVirtualTextureStats(const char* name, const snzr_VirtualTexture* vt) {
+    snzr_VirtualTextureStats stats = vt->stats;
+    uint64_t pageCount = vt->pagesPerSide * vt->pagesPerSide;
+    ui_debugValueF(name, "%llu/%llu pages, %llu requested %llu loading, %llu uploaded %llu evicted %llu failed",
+                   stats.resident, pageCount, stats.requested, stats.loading, stats.uploaded, stats.evicted, stats.failed);
+}
+
+// pushes estimated vram in use by kind and by owner, see snzr_resourceStatsGet
+void ui_debugResourceStats() {
+    snzr_ResourceStats stats = snzr_resourceStatsGet();
+    uint64_t total = 0;
+    for (int64_t i = 0; i < SNZR_RK_COUNT; i++) {
+        total += stats.bytes[i];
+        const char* name = snz_arenaFormatStr(_ui_debugGlobs.arena, "vram %ss", snzr_resourceKindName(i));
+        ui_debugValueF(name, "%.2fmb in %llu", stats.bytes[i] / 1000000.0, stats.counts[i]);
+    }
+    for (int64_t i = 0; i < stats.ownerCount; i++) {
+        const char* name = snz_arenaFormatStr(_ui_debugGlobs.arena, "vram owned by %s", stats.ownerNames[i]);
+        ui_debugValueF(name, "%.2fmb", stats.ownerBytes[i] / 1000000.0);
+    }
+    ui_debugValueF("vram total", "%.2fmb, %.2fmb waiting to be freed", total / 1000000.0, stats.pendingBytes / 1000000.0);
+}
+
+void ui_debugPacingStats() {
+    snz_PacingStats stats = snz_pacingStatsGet();
+    const char* modeNames[] = { "vsync", "adaptive vsync", "fixed" };
+    ui_debugValueF("pacing", "%s%s%s, %.2fms target", modeNames[stats.mode],
+                   stats.mode != stats.requestedMode ? ", fell back from " : "",
+                   stats.mode != stats.requestedMode ? modeNames[stats.requestedMode] : "", stats.targetFrameMs);
+    ui_debugValueF("frame", "%.2fms, %.2fms build", stats.lastFrameMs, stats.buildMs);
+    ui_debugValueF("input to present", "%.2fms", stats.inputToPresentMs);
+    ui_debugValueF("missed deadlines", "%llu of %llu", stats.missedDeadlines, stats.framesPresented);
+}
+
 void ui_debugValuesBuild() {
     if (!_ui_debugGlobs.firstValue) {
         return;
@@ -705,6 +846,12 @@ void ui_debugValuesBuild() {
             snzu_boxSetDisplayStrF(&ui_labelFont, ui_colorText, "%s: %20s", value->name, value->value);
             snzu_boxSetSizeFitText(ui_padding);
         }
+
+        if (_ui_debugGlobs.logLen) {
+            snzu_boxNew("log");
+            snzu_boxSetParagraph(&_ui_debugGlobs.logParagraph, _ui_debugGlobs.log, ui_colorText);
+            snzu_boxSetSizeFromStart(snzr_paragraphSize(&_ui_debugGlobs.logParagraph, _ui_debugGlobs.log));
+        }
     }
     snzu_boxSetStart(HMM_V2(20, 20));
     snzu_boxOrderChildrenInRowRecurse(ui_padding, SNZU_AX_Y, SNZU_ALIGN_LEFT);